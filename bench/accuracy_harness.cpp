@@ -0,0 +1,353 @@
+#include <allocation_tracker.hpp>
+#include <calc.hpp>
+#include <error.hpp>
+#include <profile.hpp>
+#include <reference/exact_riemann.hpp>
+#include <snapshot.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace MHD;
+
+namespace {
+
+// Short enough that no wave reaches the reflective walls of the default [0, 20] m domain
+double constexpr DURATION = 1e-2;
+double constexpr SOD_GAMMA = 1.4;
+
+// Coarsest sweep resolution is refined by halving the spacing, which keeps the cell count exact
+double constexpr COARSEST_SPACING = 0.2;
+std::size_t constexpr NUM_REFINEMENTS = 4;
+
+// The Brio-Wu reference is this many times finer than the finest sweep resolution
+std::size_t constexpr REFERENCE_REFINEMENT = 4;
+
+// Relative growth of an error over its baseline that fails the check
+double constexpr ERROR_TOLERANCE = 1e-2;
+
+ReconstructionOption const RECONSTRUCTIONS[] = {ReconstructionOption::CONSTANT, ReconstructionOption::LINEAR,
+                                                ReconstructionOption::MUSCL};
+FluxScheme const FLUXES[] = {FluxScheme::KT};
+TemporalIntegrationMethod const INTEGRATORS[] = {TemporalIntegrationMethod::FORWARD_EULER};
+
+std::string reconstructionName(ReconstructionOption const option) {
+    switch (option) {
+        case ReconstructionOption::CONSTANT: return "constant";
+        case ReconstructionOption::LINEAR: return "linear";
+        case ReconstructionOption::MUSCL: return "muscl";
+    }
+    return "";
+}
+
+std::string fluxName(FluxScheme const option) {
+    switch (option) {
+        case FluxScheme::KT: return "kt";
+    }
+    return "";
+}
+
+std::string integratorName(TemporalIntegrationMethod const option) {
+    switch (option) {
+        case TemporalIntegrationMethod::FORWARD_EULER: return "forwardEuler";
+    }
+    return "";
+}
+
+struct Configuration {
+    ReconstructionOption reconstruction;
+    FluxScheme flux;
+    TemporalIntegrationMethod integrator;
+
+    std::string Name() const {
+        return reconstructionName(reconstruction) + "," + fluxName(flux) + "," + integratorName(integrator);
+    }
+};
+
+struct RunOutput {
+    Snapshot initial;
+    Snapshot final;
+    double seconds;
+    double heapBytesPerCell;
+    double residentBytesPerCell;
+};
+
+struct Result {
+    std::string problem;
+    std::string configuration;
+    std::size_t numCells;
+    std::size_t numSteps;
+    double seconds;
+    double l1Rho;
+    double l1U;
+    double l1P;
+    double heapBytesPerCell;
+    double residentBytesPerCell;
+    bool pareto = false;
+};
+
+// A run the solver aborted, e.g. on a negative density, has no error and no cost
+Result failedResult(std::string const& problem, Configuration const& configuration, double const spacing) {
+    std::vector<double> const& bounds = Profile().m_gridBoundsOption;
+    std::size_t const numCells = static_cast<std::size_t>(std::lround((bounds[1] - bounds[0]) / spacing));
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+    return {problem, configuration.Name(), numCells, 0, nan, nan, nan, nan, nan, nan};
+}
+
+RunOutput run(InitialCondition const ic, Configuration const& configuration, double const spacing) {
+    Profile profile;
+    profile.m_gridSpacingsOption = {spacing, 0.1, 0.1};
+    profile.m_numGhostLayersOption = 2;
+    profile.m_reconstructionOption = configuration.reconstruction;
+    profile.m_fluxOption = configuration.flux;
+    profile.m_temporalIntegrationOption = configuration.integrator;
+    profile.m_durationOption = DURATION;
+    profile.m_timingReportOption = TimingReportOption::NO;
+
+    char const* const snapshotFile = "accuracy_harness.snap";
+    // Heap bytes of the setup are exact, resident growth also depends on what the allocator kept from earlier runs
+    resetPeakResidentBytes();
+    std::size_t const residentBytes = currentResidentBytes();
+    AllocationCounts const heapBefore = threadAllocationCounts();
+    Calc calc(profile);
+    calc.SetInitialCondition(ic);
+    std::uint64_t const heapBytes = threadAllocationCounts().numBytes - heapBefore.numBytes;
+
+    RunOutput output;
+    calc.WriteSnapshot(snapshotFile);
+    output.initial = readSnapshot(snapshotFile);
+
+    auto const start = std::chrono::steady_clock::now();
+    calc.Run();
+    output.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::size_t const peakBytes = peakResidentBytes();
+    output.heapBytesPerCell = static_cast<double>(heapBytes) / output.initial.info.numCells;
+    output.residentBytesPerCell = peakBytes > residentBytes
+        ? static_cast<double>(peakBytes - residentBytes) / output.initial.info.numCells : 0.0;
+
+    calc.WriteSnapshot(snapshotFile);
+    output.final = readSnapshot(snapshotFile);
+    std::remove(snapshotFile);
+    return output;
+}
+
+// Mean absolute difference over the interior cells, the L1 norm divided by the domain length
+double l1Error(std::vector<double> const& values, std::vector<double> const& reference, std::size_t const numCells) {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < numCells; ++i) {
+        sum += std::abs(values[i] - reference[i]);
+    }
+    return sum / numCells;
+}
+
+Result sodResult(Configuration const& configuration, double const spacing) {
+    RunOutput const output = run(InitialCondition::SOD_SHOCK_TUBE, configuration, spacing);
+    Snapshot const& initial = output.initial;
+    Snapshot const& final = output.final;
+    std::size_t const numCells = final.info.numCells;
+
+    // States and interface are taken from the initial condition Calc actually set
+    std::vector<double> const& x = initial.Field("x");
+    GasState const left = {initial.Field("rho")[0], initial.Field("u")[0], initial.Field("p")[0]};
+    GasState const right = {initial.Field("rho")[numCells - 1], initial.Field("u")[numCells - 1],
+                            initial.Field("p")[numCells - 1]};
+    std::size_t interface = 0;
+    while (interface + 1 < numCells && initial.Field("rho")[interface + 1] == left.rho) {
+        ++interface;
+    }
+    double const x0 = 0.5 * (x[interface] + x[interface + 1]);
+
+    // The exact solution is sampled at the time the run actually reached
+    ExactRiemannSolver const exact(left, right, SOD_GAMMA);
+    std::vector<double> rho(numCells), u(numCells), p(numCells);
+    for (std::size_t i = 0; i < numCells; ++i) {
+        GasState const state = exact.Sample((x[i] - x0) / final.info.time);
+        rho[i] = state.rho;
+        u[i] = state.u;
+        p[i] = state.p;
+    }
+
+    return {"sod", configuration.Name(), numCells, final.info.step, output.seconds,
+            l1Error(final.Field("rho"), rho, numCells), l1Error(final.Field("u"), u, numCells),
+            l1Error(final.Field("p"), p, numCells), output.heapBytesPerCell, output.residentBytesPerCell};
+}
+
+// Averages groups of fine cells onto the coarse grid
+std::vector<double> restrictField(std::vector<double> const& fine, std::size_t const numFineCells,
+                                  std::size_t const numCoarseCells) {
+    std::size_t const ratio = numFineCells / numCoarseCells;
+    std::vector<double> coarse(numCoarseCells, 0.0);
+    for (std::size_t i = 0; i < numCoarseCells * ratio; ++i) {
+        coarse[i / ratio] += fine[i] / ratio;
+    }
+    return coarse;
+}
+
+Result brioWuResult(Configuration const& configuration, double const spacing, Snapshot const& reference) {
+    RunOutput const output = run(InitialCondition::BRIO_WU_SHOCK_TUBE, configuration, spacing);
+    Snapshot const& final = output.final;
+    std::size_t const numCells = final.info.numCells;
+    std::size_t const numReferenceCells = reference.info.numCells;
+
+    return {"brioWu", configuration.Name(), numCells, final.info.step, output.seconds,
+            l1Error(final.Field("rho"), restrictField(reference.Field("rho"), numReferenceCells, numCells), numCells),
+            l1Error(final.Field("u"), restrictField(reference.Field("u"), numReferenceCells, numCells), numCells),
+            l1Error(final.Field("p"), restrictField(reference.Field("p"), numReferenceCells, numCells), numCells),
+            output.heapBytesPerCell, output.residentBytesPerCell};
+}
+
+// A run is on the front of its problem if no other run is at least as accurate in density and as fast
+void markParetoFront(std::vector<Result>& results) {
+    for (Result& result : results) {
+        result.pareto = std::isfinite(result.l1Rho);
+        for (Result const& other : results) {
+            bool const dominates = std::isfinite(other.l1Rho) && other.problem == result.problem && other.l1Rho <= result.l1Rho &&
+                                   other.seconds <= result.seconds &&
+                                   (other.l1Rho < result.l1Rho || other.seconds < result.seconds);
+            if (dominates) {
+                result.pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+void writeCsv(std::ostream& os, std::vector<Result> const& results) {
+    os << "problem,reconstruction,flux,integrator,cells,steps,seconds,cellUpdatesPerSecond,l1Rho,l1U,l1P,heapBytesPerCell,residentBytesPerCell,pareto\n";
+    os << std::setprecision(9);
+    for (Result const& result : results) {
+        os << result.problem << "," << result.configuration << "," << result.numCells << "," << result.numSteps << ","
+           << result.seconds << "," << result.numCells * result.numSteps / result.seconds << "," << result.l1Rho
+           << "," << result.l1U << "," << result.l1P << "," << result.heapBytesPerCell << ","
+           << result.residentBytesPerCell << "," << result.pareto
+           << "\n";
+    }
+}
+
+using BaselineKey = std::tuple<std::string, std::string, std::size_t>;
+
+std::map<BaselineKey, double> readBaseline(std::string const& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+
+    std::map<BaselineKey, double> baseline;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::vector<std::string> columns;
+        std::stringstream stream(line);
+        std::string column;
+        while (std::getline(stream, column, ',')) {
+            columns.push_back(column);
+        }
+        if (columns.size() < 9) {
+            continue;
+        }
+        std::string const configuration = columns[1] + "," + columns[2] + "," + columns[3];
+        baseline[{columns[0], configuration, std::stoul(columns[4])}] = std::stod(columns[8]);
+    }
+    return baseline;
+}
+
+} // namespace
+
+/**
+ * Grid-refinement sweep of every reconstruction, flux and integrator combination on the Sod and
+ * Brio-Wu shock tubes. Sod is measured against the exact Riemann solution and Brio-Wu against a
+ * MUSCL run on a finer grid, averaged onto each sweep grid. Writes one CSV row per run with the
+ * error, the wall time of Calc::Run, the cell updates per second, and the setup heap bytes and
+ * peak resident growth per cell, and marks the runs on the error-versus-time Pareto front of each problem.
+ *
+ * With --baseline, exits with a failure if any density error grew beyond the tolerance.
+ */
+int main(int argc, char** argv) {
+    std::string outputFile = "accuracy.csv";
+    std::string baselineFile;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--baseline") == 0 && a + 1 < argc) {
+            baselineFile = argv[++a];
+        } else if (std::strcmp(argv[a], "--output") == 0 && a + 1 < argc) {
+            outputFile = argv[++a];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--output accuracy.csv] [--baseline baseline.csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Configuration> configurations;
+    for (ReconstructionOption const reconstruction : RECONSTRUCTIONS) {
+        for (FluxScheme const flux : FLUXES) {
+            for (TemporalIntegrationMethod const integrator : INTEGRATORS) {
+                configurations.push_back({reconstruction, flux, integrator});
+            }
+        }
+    }
+
+    try {
+        double const finestSpacing = COARSEST_SPACING / (1 << (NUM_REFINEMENTS - 1));
+        Configuration const referenceConfiguration = {ReconstructionOption::MUSCL, FluxScheme::KT,
+                                                      TemporalIntegrationMethod::FORWARD_EULER};
+        Snapshot const brioWuReference = run(InitialCondition::BRIO_WU_SHOCK_TUBE, referenceConfiguration,
+                                             finestSpacing / REFERENCE_REFINEMENT).final;
+
+        std::vector<Result> results;
+        for (Configuration const& configuration : configurations) {
+            for (std::size_t r = 0; r < NUM_REFINEMENTS; ++r) {
+                double const spacing = COARSEST_SPACING / (1 << r);
+                try {
+                    results.push_back(sodResult(configuration, spacing));
+                } catch (Error const&) {
+                    results.push_back(failedResult("sod", configuration, spacing));
+                }
+                try {
+                    results.push_back(brioWuResult(configuration, spacing, brioWuReference));
+                } catch (Error const&) {
+                    results.push_back(failedResult("brioWu", configuration, spacing));
+                }
+            }
+        }
+        markParetoFront(results);
+
+        writeCsv(std::cout, results);
+        std::ofstream file(outputFile);
+        writeCsv(file, results);
+        if (!file) {
+            throw Error::FILE_IO;
+        }
+
+        if (baselineFile.empty()) {
+            return 0;
+        }
+        std::map<BaselineKey, double> const baseline = readBaseline(baselineFile);
+        bool regressed = false;
+        for (Result const& result : results) {
+            auto const it = baseline.find({result.problem, result.configuration, result.numCells});
+            // A run that used to complete and now fails counts as a regression too
+            bool const failed = std::isfinite(it == baseline.end() ? 0.0 : it->second) && !std::isfinite(result.l1Rho);
+            if (it != baseline.end() && (failed || result.l1Rho > it->second * (1.0 + ERROR_TOLERANCE))) {
+                std::cerr << "Accuracy regression: " << result.problem << " " << result.configuration << " "
+                          << result.numCells << " cells, L1(rho) " << result.l1Rho << " > baseline " << it->second
+                          << std::endl;
+                regressed = true;
+            }
+        }
+        return regressed ? 1 : 0;
+    } catch (Error const&) {
+        std::cerr << "Accuracy harness failed" << std::endl;
+        return 1;
+    }
+}
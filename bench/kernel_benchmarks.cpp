@@ -0,0 +1,365 @@
+#include <batched.hpp>
+#include <boundary_condition/boundary_condition.hpp>
+#include <execution_controller.hpp>
+#include <flux/flux_scheme.hpp>
+#include <grid.hpp>
+#include <integration/integration.hpp>
+#include <kernels.hpp>
+#include <profile.hpp>
+#include <reconstruction/reconstruction.hpp>
+#include <residual.hpp>
+#include <solver.hpp>
+#include <variable_store.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+using namespace MHD;
+
+namespace {
+
+// Bytes that must move between memory and core per item, counting each array once
+std::size_t constexpr BYTES_PER_DOUBLE = sizeof(double);
+
+Profile makeProfile(std::size_t const numCells) {
+    // Unit spacing so the cell count is exact
+    Profile profile;
+    profile.m_gridBoundsOption = {0.0, static_cast<double>(numCells), 0.0, 1.0, 0.0, 1.0};
+    profile.m_gridSpacingsOption = {1.0, 0.1, 0.1};
+    profile.m_numGhostLayersOption = 2;
+    return profile;
+}
+
+/**
+ * A grid and a smooth MHD state on every node, ghost cells included, with the primitive variables
+ * consistent with the conserved ones. Smooth data keeps the limiters off their division-by-zero
+ * paths, so the reconstruction kernels run their common case.
+ */
+struct KernelFixture {
+    KernelFixture(Profile const& profile) : KernelFixture(gridFactory(profile)) {}
+
+    KernelFixture(std::unique_ptr<IGrid> fixtureGrid) : grid(std::move(fixtureGrid)), varStore(*grid) {
+        std::size_t const numNodes = grid->NumNodes();
+        double const length = grid->NumCells() * grid->CellSize()[0];
+        for (std::size_t i = 0; i < numNodes; ++i) {
+            double const phase = 2.0 * M_PI * grid->Nodes()[i][0] / length;
+            varStore.rho[i] = 1.0 + 0.1 * std::sin(phase);
+            varStore.rhoU[i] = 0.1 * std::cos(phase);
+            varStore.rhoV[i] = 0.05 * std::sin(2.0 * phase);
+            varStore.rhoW[i] = 0.02 * std::cos(3.0 * phase);
+            varStore.bx[i] = 0.75;
+            varStore.by[i] = std::cos(phase);
+            varStore.bz[i] = 0.1 * std::sin(phase);
+            varStore.rhoE[i] = 2.5 + 0.1 * std::cos(phase);
+        }
+
+        VelocityKernel velKern(varStore);
+        execCtrl.LaunchKernel(velKern, numNodes);
+        SpecificInternalEnergyKernel eKern(varStore);
+        execCtrl.LaunchKernel(eKern, numNodes);
+        CaloricallyPerfectGasPressureKernel pKern(varStore);
+        execCtrl.LaunchKernel(pKern, numNodes);
+        CaloricallyPerfectGasTemperatureKernel tKern(varStore);
+        execCtrl.LaunchKernel(tKern, numNodes);
+        CaloricallyPerfectGasSoundSpeedKernel csKern(varStore);
+        execCtrl.LaunchKernel(csKern, numNodes);
+    }
+
+    ExecutionController execCtrl;
+    std::unique_ptr<IGrid> grid;
+    VariableStore varStore;
+};
+
+void setCounters(benchmark::State& state, std::size_t const numItems, std::size_t const bytesPerItem) {
+    state.SetItemsProcessed(state.iterations() * numItems);
+    state.SetBytesProcessed(state.iterations() * numItems * bytesPerItem);
+}
+
+// From L1-resident to well past the last-level cache for the widest kernels
+void gridSizes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->RangeMultiplier(8)->Range(1 << 9, 1 << 21)->ArgName("cells");
+}
+
+template <typename Kernel, std::size_t ARRAYS_PER_CELL> void BM_VariableStoreKernel(benchmark::State& state) {
+    KernelFixture fixture(makeProfile(state.range(0)));
+    std::size_t const numCells = fixture.grid->NumCells();
+    for (auto _ : state) {
+        Kernel kernel(fixture.varStore);
+        fixture.execCtrl.LaunchKernel(kernel, numCells);
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, numCells, ARRAYS_PER_CELL * BYTES_PER_DOUBLE);
+}
+
+// Calls body with a value of the face precision, float when mixed, as the solver picks its face stages
+template <typename Body> void withFacePrecision(PrecisionOption const precision, Body&& body) {
+    if (PrecisionOption::MIXED == precision) {
+        body(float{});
+    } else {
+        body(double{});
+    }
+}
+
+void BM_Reconstruction(benchmark::State& state, ReconstructionOption const option, std::size_t const cellArrays,
+                       PrecisionOption const precision) {
+    Profile profile = makeProfile(state.range(0));
+    profile.m_reconstructionOption = option;
+    KernelFixture fixture(profile);
+    withFacePrecision(precision, [&](auto real) {
+        using Real = decltype(real);
+        auto reconstruction = reconstructionFactory<Real>(profile, fixture.varStore, *fixture.grid);
+        for (auto _ : state) {
+            reconstruction->ComputeLeftRightStates(fixture.execCtrl);
+            benchmark::ClobberMemory();
+        }
+
+        // Cell states in, twice as many face states out
+        setCounters(state, fixture.grid->NumFaces(), cellArrays * BYTES_PER_DOUBLE + 2 * cellArrays * sizeof(Real));
+    });
+}
+
+// The same reconstruction on cells widening threefold along the grid, which also reads the geometry of each face
+void BM_StretchedReconstruction(benchmark::State& state, ReconstructionOption const option, std::size_t const cellArrays) {
+    Profile profile = makeProfile(state.range(0));
+    profile.m_reconstructionOption = option;
+    double const numCells = static_cast<double>(state.range(0));
+    for (std::int64_t k = 0; k <= state.range(0); ++k) {
+        double const fraction = k / numCells;
+        profile.m_gridNodesOption.push_back(numCells * fraction * (0.5 + 0.5 * fraction));
+    }
+    KernelFixture fixture(profile);
+    auto reconstruction = reconstructionFactory<double>(profile, fixture.varStore, *fixture.grid);
+    for (auto _ : state) {
+        reconstruction->ComputeLeftRightStates(fixture.execCtrl);
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, fixture.grid->NumFaces(), (3 * cellArrays + 5) * BYTES_PER_DOUBLE);
+}
+
+void BM_KTFlux(benchmark::State& state, PrecisionOption const precision) {
+    Profile profile = makeProfile(state.range(0));
+    KernelFixture fixture(profile);
+    withFacePrecision(precision, [&](auto real) {
+        using Real = decltype(real);
+        auto reconstruction = reconstructionFactory<Real>(profile, fixture.varStore, *fixture.grid);
+        reconstruction->ComputeLeftRightStates(fixture.execCtrl);
+        auto flux = fluxFactory<Real>(profile, *fixture.grid, reconstruction->GetContext());
+        for (auto _ : state) {
+            flux->ComputeInterfaceFluxes(fixture.execCtrl);
+            benchmark::ClobberMemory();
+        }
+
+        // Twenty face states and four face geometry values in, eight fluxes out
+        setCounters(state, fixture.grid->NumFaces(), 4 * BYTES_PER_DOUBLE + 28 * sizeof(Real));
+    });
+}
+
+void BM_Transport(benchmark::State& state, PrecisionOption const precision) {
+    Profile profile = makeProfile(state.range(0));
+    KernelFixture fixture(profile);
+    withFacePrecision(precision, [&](auto real) {
+        using Real = decltype(real);
+        auto reconstruction = reconstructionFactory<Real>(profile, fixture.varStore, *fixture.grid);
+        reconstruction->ComputeLeftRightStates(fixture.execCtrl);
+        auto flux = fluxFactory<Real>(profile, *fixture.grid, reconstruction->GetContext());
+        flux->ComputeInterfaceFluxes(fixture.execCtrl);
+        Residual<Real> residual(*fixture.grid, flux->GetContext());
+        for (auto _ : state) {
+            residual.ComputeResidual(fixture.execCtrl);
+            benchmark::ClobberMemory();
+        }
+
+        // Eight fluxes in (each face is shared by two cells), eight residuals out
+        setCounters(state, fixture.grid->NumCells(), 8 * sizeof(Real) + 8 * BYTES_PER_DOUBLE);
+    });
+}
+
+void BM_ForwardEuler(benchmark::State& state) {
+    Profile profile = makeProfile(state.range(0));
+    KernelFixture fixture(profile);
+    auto reconstruction = reconstructionFactory<double>(profile, fixture.varStore, *fixture.grid);
+    auto flux = fluxFactory<double>(profile, *fixture.grid, reconstruction->GetContext());
+    Residual<double> residual(*fixture.grid, flux->GetContext());
+
+    // Zero residuals leave the state unchanged however many iterations run
+    double const timeStep = 1e-5;
+    auto integrator = integratorFactory(residual.GetContext(), fixture.varStore, timeStep);
+    for (auto _ : state) {
+        integrator->Integrate(fixture.execCtrl);
+        benchmark::ClobberMemory();
+    }
+
+    // Eight residuals in, eight conserved states read and written
+    setCounters(state, fixture.grid->NumCells(), 24 * BYTES_PER_DOUBLE);
+}
+
+void BM_BoundaryCondition(benchmark::State& state, BoundaryConditionOption const option) {
+    Profile profile = makeProfile(1 << 12);
+    profile.m_boundaryConditionOption = option;
+    profile.m_numGhostLayersOption = state.range(0);
+
+    // Constant states read a single layer, so periodic ends may have as few as that
+    profile.m_reconstructionOption = ReconstructionOption::CONSTANT;
+    KernelFixture fixture(profile);
+    auto boundaryCondition = boundaryConditionFactory(profile, *fixture.grid, fixture.varStore);
+    for (auto _ : state) {
+        boundaryCondition->ApplyBoundaryConditions(fixture.execCtrl);
+        benchmark::ClobberMemory();
+    }
+
+    // Eleven primitive states gathered from the donor and scattered to each ghost cell
+    std::size_t const numGhostCells = fixture.grid->NumNodes() - fixture.grid->NumCells();
+    setCounters(state, numGhostCells, 22 * BYTES_PER_DOUBLE);
+}
+
+// A whole time step, with the stages run one after another over the grid or tile by tile
+void BM_TimeStep(benchmark::State& state, StepScheduleOption const schedule, PrecisionOption const precision) {
+    Profile profile = makeProfile(state.range(0));
+    profile.m_boundaryConditionOption = BoundaryConditionOption::OUTFLOW;
+    profile.m_stepScheduleOption = schedule;
+    profile.m_precisionOption = precision;
+    KernelFixture fixture(profile);
+    for (double& rhoE : fixture.varStore.rhoE) {
+        rhoE += 2.5e5;
+    }
+    auto solver = solverFactory(profile, fixture.execCtrl, fixture.varStore, *fixture.grid);
+
+    // Tiled steps try their tile sizes first, so the timed steps run at the size they settle on
+    for (std::size_t step = 0; step < 16; ++step) {
+        solver->PrimFromCons();
+        solver->PerformTimeStep();
+    }
+    for (auto _ : state) {
+        solver->PrimFromCons();
+        solver->PerformTimeStep();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.grid->NumCells());
+}
+
+// Blocks of several steps, each tile advanced through all of them before the next tile is read
+void BM_TemporalBlock(benchmark::State& state) {
+    std::size_t const numSteps = state.range(1);
+    Profile profile = makeProfile(state.range(0));
+    profile.m_boundaryConditionOption = BoundaryConditionOption::OUTFLOW;
+    profile.m_temporalBlockStepsOption = numSteps;
+    KernelFixture fixture(profile);
+    for (double& rhoE : fixture.varStore.rhoE) {
+        rhoE += 2.5e5;
+    }
+    auto solver = solverFactory(profile, fixture.execCtrl, fixture.varStore, *fixture.grid);
+    for (auto _ : state) {
+        solver->PrimFromCons();
+        solver->PerformTimeStep();
+        benchmark::ClobberMemory();
+    }
+
+    // Items are cell updates, comparable with BM_TimeStep
+    state.SetItemsProcessed(state.iterations() * numSteps * fixture.grid->NumCells());
+}
+
+// Steps over a quiet state disturbed in its middle, with and without skipping the tiles that cannot change
+void BM_SparseTimeStep(benchmark::State& state, ActivityTrackingOption const activityTracking) {
+    Profile profile = makeProfile(state.range(0));
+    profile.m_boundaryConditionOption = BoundaryConditionOption::OUTFLOW;
+    profile.m_activityTrackingOption = activityTracking;
+    KernelFixture fixture(profile);
+    std::size_t const numNodes = fixture.grid->NumNodes();
+    std::size_t const middle = fixture.grid->NumCells() / 2;
+    for (std::size_t i = 0; i < numNodes; ++i) {
+        double const bump = i >= middle && i < middle + 16 ? 0.1 : 0.0;
+        fixture.varStore.rho[i] = 1.0 + bump;
+        fixture.varStore.rhoU[i] = 0.0;
+        fixture.varStore.rhoV[i] = 0.0;
+        fixture.varStore.rhoW[i] = 0.0;
+        fixture.varStore.bx[i] = 0.75;
+        fixture.varStore.by[i] = 1.0;
+        fixture.varStore.bz[i] = 0.0;
+        fixture.varStore.rhoE[i] = 2.5e5 * (1.0 + bump);
+    }
+    auto solver = solverFactory(profile, fixture.execCtrl, fixture.varStore, *fixture.grid);
+
+    // Every tile is active in the first step, after which the disturbance spreads by a few cells a step
+    for (std::size_t step = 0; step < 2; ++step) {
+        solver->PrimFromCons();
+        solver->PerformTimeStep();
+    }
+    for (auto _ : state) {
+        solver->PrimFromCons();
+        solver->PerformTimeStep();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.grid->NumCells());
+}
+
+// A whole time step over a small grid, with each cell carrying the given number of independent lanes
+void BM_BatchedTimeStep(benchmark::State& state) {
+    Profile profile = makeProfile(512);
+    profile.m_boundaryConditionOption = BoundaryConditionOption::PERIODIC;
+    profile.m_numGhostLayersOption = 2;
+    auto const grid = gridFactory(profile);
+    KernelFixture fixture(std::make_unique<BatchedGrid>(*grid, state.range(0)));
+
+    // Thermal energy well above the magnetic energy keeps the state physical over any number of steps
+    for (double& rhoE : fixture.varStore.rhoE) {
+        rhoE += 2.5e5;
+    }
+    auto solver = solverFactory(profile, fixture.execCtrl, fixture.varStore, *fixture.grid);
+    for (auto _ : state) {
+        solver->PrimFromCons();
+        solver->PerformTimeStep();
+        benchmark::ClobberMemory();
+    }
+
+    // Items are cell updates, so throughput per lane shows what batching buys over one problem at a time
+    state.SetItemsProcessed(state.iterations() * fixture.grid->NumCells());
+}
+
+} // namespace
+
+// Cell-local kernels, bytes are the arrays read plus the arrays written
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, VelocityKernel, 7)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, SpecificInternalEnergyKernel, 9)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, CaloricallyPerfectGasPressureKernel, 6)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, CaloricallyPerfectGasTemperatureKernel, 2)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, CaloricallyPerfectGasSoundSpeedKernel, 2)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, MaximumWaveSpeedKernel, 2)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, MomentumDensityKernel, 7)->Apply(gridSizes);
+BENCHMARK_TEMPLATE(BM_VariableStoreKernel, TotalEnergyDensityKernel, 9)->Apply(gridSizes);
+
+// Face and cell stages, launched through the same interfaces the solver uses
+// Node states in, left and right face states out: seven fields for constant and linear, ten for MUSCL
+BENCHMARK_CAPTURE(BM_Reconstruction, Constant, ReconstructionOption::CONSTANT, 7, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_Reconstruction, Linear, ReconstructionOption::LINEAR, 7, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_Reconstruction, MUSCL, ReconstructionOption::MUSCL, 10, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_Reconstruction, MUSCLMixed, ReconstructionOption::MUSCL, 10, PrecisionOption::MIXED)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_StretchedReconstruction, Linear, ReconstructionOption::LINEAR, 7)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_StretchedReconstruction, MUSCL, ReconstructionOption::MUSCL, 10)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_KTFlux, Double, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_KTFlux, Mixed, PrecisionOption::MIXED)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_Transport, Double, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_Transport, Mixed, PrecisionOption::MIXED)->Apply(gridSizes);
+BENCHMARK(BM_ForwardEuler)->Apply(gridSizes);
+
+// Boundary conditions scale with the number of ghost layers, not the grid size
+BENCHMARK_CAPTURE(BM_BoundaryCondition, Outflow, BoundaryConditionOption::OUTFLOW)->Arg(1)->Arg(2)->ArgName("layers");
+BENCHMARK_CAPTURE(BM_BoundaryCondition, Reflective, BoundaryConditionOption::REFLECTIVE)->Arg(1)->Arg(2)->ArgName("layers");
+BENCHMARK_CAPTURE(BM_BoundaryCondition, Periodic, BoundaryConditionOption::PERIODIC)->Arg(1)->Arg(2)->ArgName("layers");
+
+// Whole steps, where tiling pays once the stage arrays no longer fit in cache
+BENCHMARK_CAPTURE(BM_TimeStep, Staged, StepScheduleOption::STAGED, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_TimeStep, Tiled, StepScheduleOption::TILED, PrecisionOption::DOUBLE)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_TimeStep, StagedMixed, StepScheduleOption::STAGED, PrecisionOption::MIXED)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_SparseTimeStep, Full, ActivityTrackingOption::NO)->Apply(gridSizes);
+BENCHMARK_CAPTURE(BM_SparseTimeStep, ActiveTiles, ActivityTrackingOption::YES)->Apply(gridSizes);
+
+BENCHMARK(BM_TemporalBlock)->ArgsProduct({{1 << 15, 1 << 18, 1 << 21}, {2, 4, 8}})->ArgNames({"cells", "steps"});
+
+// Small problems batched across lanes, from one lane up to a full batch
+BENCHMARK(BM_BatchedTimeStep)->RangeMultiplier(2)->Range(1, 8)->ArgName("lanes");
+
+BENCHMARK_MAIN();
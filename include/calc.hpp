@@ -1,14 +1,24 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace MHD {
 
+class AsyncSnapshotWriter;
+class Diagnostics;
 class ExecutionController;
+class ICommunicator;
 class IGrid;
 class ISolver;
 class Profile;
+class TimeSeriesWriter;
 class VariableStore;
+struct SnapshotField;
 
 enum class InitialCondition {
     ATMOSPHERE = 0,
@@ -16,31 +26,150 @@ enum class InitialCondition {
     BRIO_WU_SHOCK_TUBE = 2,
 };
 
+// Read-only window onto one field of the live state, without a copy
+class FieldView {
+public:
+    FieldView() = default;
+    FieldView(double const* data, std::size_t const size) : m_data(data), m_size(size) {}
+
+    double operator[](std::size_t const i) const { return m_data[i]; }
+    double const* Data() const { return m_data; }
+    std::size_t Size() const { return m_size; }
+    double const* begin() const { return m_data; }
+    double const* end() const { return m_data + m_size; }
+
+private:
+    double const* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+/**
+ * The state of a calculation between steps, with the primitives consistent with the conserved
+ * variables. Every field covers the interior cells only and points into the solver's own arrays, so
+ * a view is valid until the next step and must be copied by anyone who keeps the data longer.
+ */
+struct StateView {
+    double time = 0.0;
+    std::size_t step = 0;
+    std::size_t numCells = 0;
+    FieldView x;
+    FieldView rho, rhoU, rhoV, rhoW, rhoE;
+    FieldView u, v, w, p, e, t, cs;
+    FieldView bx, by, bz;
+};
+
+using Observer = std::function<void(StateView const&)>;
+
 class Calc {
 public:
+    // Splits the domain over the ranks of MPI_COMM_WORLD when MPI is initialized
     Calc(Profile const& profile);
+
+    /**
+     * Runs the part of the domain owned by the rank of the communicator, one contiguous run of cells
+     * per rank. Every rank must make the same calls in the same order; output files are prefixed with
+     * "rank_R_" when there is more than one rank and only rank 0 prints the timing report.
+     */
+    Calc(Profile const& profile, std::shared_ptr<ICommunicator> communicator);
+
+    // Runs on a grid built elsewhere, which must match the grid options of the profile and is only read
+    Calc(Profile const& profile, std::shared_ptr<IGrid const> grid);
     ~Calc();
 
     void SetInitialCondition(InitialCondition ic);
+
+    // Steps to the duration of the profile, then flushes the output and writes the reports
     void Run();
-    
+
+    /**
+     * Finer-grained drivers for embedding the calculation in a larger loop. Step advances a fixed
+     * number of steps; RunUntil shortens its last step to land on the requested time exactly. Both
+     * keep the output, diagnostics, checkpoint and observer schedules of Run, but leave flushing and
+     * reporting to Run or to the destructor. With temporal blocking each step is a whole block of
+     * m_temporalBlockStepsOption steps, and it is blocks that the step count and every step interval
+     * count.
+     */
+    void Step(std::size_t const numSteps = 1);
+    void RunUntil(double const time);
+
+    double CurrentTime() const { return m_currentTime; }
+    std::size_t CurrentStep() const { return m_currentStep; }
+
+    // The current state, with the primitives brought up to date first
+    StateView State();
+
+    // Overwrites the time, step and conserved fields of the interior cells, e.g. with a state advanced elsewhere
+    void Load(StateView const& state);
+
+    /**
+     * Registers a callback made before every stepInterval-th step, or whenever timeInterval of
+     * simulated time has passed, and at the start. Returns an id for RemoveObserver. A temporal
+     * block counts as one step, and its state is only seen at its end. Callbacks may add and remove
+     * observers, including themselves; an observer added during a notification is first called at
+     * the next one.
+     */
+    std::size_t AddObserver(Observer observer, std::size_t const stepInterval = 1);
+    std::size_t AddTimeObserver(Observer observer, double const timeInterval);
+    void RemoveObserver(std::size_t const id);
+
+    // Saves the conserved state and counters, and resumes from them in place of an initial condition
+    void WriteCheckpoint(std::string const& filename) const;
+    void Restart(std::string const& filename);
+
+    // Writes every field at every node of the current state, independent of the output schedule
+    void WriteSnapshot(std::string const& filename);
+
 private:
+    Calc(Profile const& profile, std::shared_ptr<IGrid const> grid, std::shared_ptr<ICommunicator> communicator);
+
+    struct ObserverEntry {
+        std::size_t id;
+        Observer observer;
+        std::size_t stepInterval;
+        double timeInterval;
+        double nextTime;
+        bool removed = false; // removed during a notification, erased once it ends
+    };
+
+    void Advance();
+    void NotifyObservers();
+    StateView MakeStateView() const;
+
     void SetAtmosphere();
     void SetSodShockTube();
     void SetBrioWuShockTube();
 
     void WriteData(VariableStore const& varStore);
+    void WriteCsvData(VariableStore const& varStore);
+    void WriteBinaryData(VariableStore const& varStore);
+    void WriteSlices(VariableStore const& varStore);
+    void SampleDiagnostics();
+    std::string OutputPath(std::string const& filename) const;
+    std::vector<SnapshotField> SnapshotFields(VariableStore const& varStore, std::size_t const first) const;
+
+    std::uint64_t StateHash() const;
 
     std::unique_ptr<ExecutionController> m_executionController;
-    std::unique_ptr<IGrid> m_grid;
+    std::shared_ptr<IGrid const> m_grid;
+    std::shared_ptr<ICommunicator> m_communicator;
     Profile const& m_profile;
     std::unique_ptr<ISolver> m_solver;
     std::unique_ptr<VariableStore> m_variableStore;
-    double const m_duration = 2e-1;
+    std::unique_ptr<AsyncSnapshotWriter> m_snapshotWriter;
+    std::unique_ptr<Diagnostics> m_diagnostics;
+    std::unique_ptr<TimeSeriesWriter> m_diagnosticsWriter;
+    std::vector<double> m_diagnosticsRow;
+    double const m_duration;
     double m_currentTime = 0.0;
     std::size_t m_currentStep = 0;
     std::size_t m_currentOutput = 0;
     double const m_outputPeriod = m_duration / 100;
+    std::vector<double> m_nodeCoordsX;
+    std::size_t m_residentBytesAtStart = 0;
+    std::vector<ObserverEntry> m_observers;
+    std::vector<ObserverEntry> m_addedObservers; // added during a notification, so m_observers stays put
+    bool m_notifyingObservers = false;
+    std::size_t m_nextObserverId = 0;
 };
 
 } // namespace MHD
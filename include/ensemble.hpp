@@ -0,0 +1,81 @@
+#pragma once
+
+#include <calc.hpp>
+#include <error.hpp>
+#include <profile.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MHD {
+
+class IGrid;
+class ThreadPool;
+
+struct EnsembleResult {
+    Error status = Error::SUCCESS; // the error a member stopped with, if any
+    double time = 0.0;
+    std::size_t steps = 0;
+    double seconds = 0.0;
+    std::string outputPrefix;
+};
+
+/**
+ * Runs many independent calcs on one grid. The grid is built once from the profile given to the
+ * constructor and shared read-only; each member brings its own profile, which may differ in
+ * anything but the grid options, and runs start to finish as one task on a shared thread pool.
+ * Members write their files under "member_K_" after the ensemble's output prefix, and leave the
+ * timing report and trace to the ensemble, which covers every member in one of each.
+ *
+ * With a batch width above one, consecutive members that agree on the solver options and the
+ * duration are advanced together, up to that many at a time, by one solver on a BatchedGrid. A
+ * batch takes the smallest stable timestep of its members at every step, so its results differ
+ * from unbatched runs by the smaller steps, and a non-physical state in one member stops the
+ * whole batch. Batched members skip per-step output, diagnostics, checkpoints and observers; their
+ * final state is loaded back into their calcs before the finish callback. A member whose setup
+ * moves it away from time zero, e.g. by restarting, runs on its own.
+ */
+class Ensemble {
+public:
+    // Called on the worker thread after the initial condition is set and before the member runs
+    using Setup = std::function<void(Calc&)>;
+
+    // Called on the worker thread once the member has reached its duration
+    using Finish = std::function<void(Calc&)>;
+
+    // Zero threads means one per hardware thread
+    Ensemble(Profile const& profile, std::size_t const numThreads = 0, std::size_t const batchWidth = 1);
+    ~Ensemble();
+
+    std::size_t AddMember(InitialCondition const ic, Setup setup = {}, Finish finish = {});
+    std::size_t AddMember(Profile const& profile, InitialCondition const ic, Setup setup = {}, Finish finish = {});
+
+    // Runs every member added so far, and returns their results in the order they were added
+    std::vector<EnsembleResult> Run();
+
+    std::size_t NumMembers() const { return m_members.size(); }
+    std::size_t NumThreads() const;
+    std::size_t BatchWidth() const { return m_batchWidth; }
+
+private:
+    struct Member {
+        Profile profile;
+        InitialCondition initialCondition;
+        Setup setup;
+        Finish finish;
+    };
+
+    void RunMember(Member const& member, EnsembleResult& result) const;
+    void RunBatch(std::size_t const first, std::size_t const count, std::vector<EnsembleResult>& results) const;
+
+    Profile const m_profile;
+    std::shared_ptr<IGrid const> m_grid;
+    std::unique_ptr<ThreadPool> m_threadPool;
+    std::size_t const m_batchWidth;
+    std::vector<Member> m_members;
+};
+
+} // namespace MHD
@@ -9,6 +9,20 @@ enum class Error {
     INVALID_GRID_GEOMETRY = 3,
     INVALID_RECONSTRUCTION_OPTION = 4,
     INVALID_INITIAL_CONDITION = 5,
+    INVALID_BOUNDARY_CONDITION = 6,
+    INVALID_NUM_GHOST_LAYERS = 7,
+    FILE_IO = 8,
+    INVALID_SNAPSHOT = 9,
+    INVALID_CHECKPOINT = 10,
+    INVALID_TIME_SERIES = 11,
+    INVALID_DIAGNOSTIC = 12,
+    NON_PHYSICAL_STATE = 13,
+    INVALID_OBSERVER = 14,
+    INVALID_STATE = 15,
+    INVALID_DECOMPOSITION = 16,
+    INVALID_TEMPORAL_BLOCK = 17,
+    INVALID_ACTIVITY_TRACKING = 18,
+    INVALID_REFINEMENT = 19,
 };
 
 }
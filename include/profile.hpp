@@ -2,6 +2,7 @@
 
 #include <profile_options.hpp>
 
+#include <string>
 #include <vector>
 
 namespace MHD {
@@ -11,18 +12,58 @@ struct Profile {
     Dimension m_gridDimensionOption = Dimension::ONE;
     std::vector<double> m_gridBoundsOption = {0.0, 20.0, 0.0, 1.0, 0.0, 1.0};
     std::vector<double> m_gridSpacingsOption = {0.04, 0.1, 0.1};
+    std::vector<double> m_gridNodesOption = {}; // x of every cell face in increasing order, in place of the bounds and spacing in x if set
+    std::vector<double> m_gridClusterPointsOption = {}; // x of points cells narrow towards, from the spacing in x far from all of them
+    double m_gridClusterRatioOption = 4.0; // spacing far from the cluster points over the spacing at one on its own
+    double m_gridClusterWidthOption = 1.0; // distance from a cluster point at which its extra cell density has fallen by a factor e
+    std::size_t m_numGhostLayersOption = 1; // 2 or more for MUSCL across periodic ends and ranks, whose stencils reach two cells
 
     // Solver options
     BoundaryConditionOption m_boundaryConditionOption = BoundaryConditionOption::REFLECTIVE;
+    std::vector<BoundaryConditionOption> m_boundaryConditionsOption = {}; // per boundary, overrides the above if set
     ReconstructionOption m_reconstructionOption = ReconstructionOption::MUSCL;
     FluxScheme m_fluxOption = FluxScheme::KT;
     TemporalIntegrationMethod m_temporalIntegrationOption = TemporalIntegrationMethod::FORWARD_EULER;
+    StepScheduleOption m_stepScheduleOption = StepScheduleOption::STAGED; // TILED runs every stage of a tile before the next tile
+    std::size_t m_numThreadsOption = 1; // above one, tiles run as a task graph on this many threads, 0 for one per hardware thread
+    std::size_t m_tileCellsOption = 4096; // interior cells per tile, 0 to time a range of sizes over the first steps and keep the fastest
+    PinThreadsOption m_pinThreadsOption = PinThreadsOption::NO; // YES pins the threads node by node and gives each a fixed run of tiles, whose pages it places
+    std::size_t m_temporalBlockStepsOption = 1; // above one, each tile advances this many steps at once on one timestep
+    ActivityTrackingOption m_activityTrackingOption = ActivityTrackingOption::NO; // YES skips the tiles of m_tileCellsOption cells (256 if 0) a step cannot change
+    HaloOverlapOption m_haloOverlapOption = HaloOverlapOption::YES; // NO completes the halo exchange of a decomposed step before any face
+    PrecisionOption m_precisionOption = PrecisionOption::DOUBLE; // MIXED stores face states and fluxes as float, the fields stay double
+    std::size_t m_refinementLevelsOption = 0; // above zero, patches refined by two this many times follow steep jumps, each level subcycling within the step of the one below
+    std::size_t m_refinementBlockCellsOption = 8; // cells of the grid being refined per block the jump detector flags
+    double m_refinementThresholdOption = 0.05; // jump in density or total energy between neighbouring cells, relative to the larger, that flags their blocks
 
     // Phenomenon options
     CompressibleOption m_compressibleOption = CompressibleOption::COMPRESSIBLE;
 
     // Generic options
+    double m_durationOption = 2e-1; // simulated time in s
     OutputDataOption m_outputDataOption = OutputDataOption::NO;
+    OutputFormatOption m_outputFormatOption = OutputFormatOption::BINARY;
+    OutputModeOption m_outputModeOption = OutputModeOption::ASYNCHRONOUS;
+    CompressionOption m_outputCompressionOption = CompressionOption::NONE; // snapshots and checkpoints
+    std::size_t m_checkpointIntervalOption = 0; // time steps between checkpoints, 0 disables checkpointing
+    std::string m_checkpointFileOption = "checkpoint.ckpt";
+    std::string m_outputPrefixOption = ""; // prepended to the name of every file a calc writes on its own
+
+    // Diagnostics options
+    std::size_t m_diagnosticsIntervalOption = 0; // time steps between samples, 0 disables diagnostics
+    std::vector<DiagnosticIntegralOption> m_diagnosticIntegralsOption = {};
+    std::vector<double> m_probeLocationsOption = {}; // x of each probe, sampled at the nearest cell
+    std::string m_diagnosticsFileOption = "diagnostics.series";
+    std::vector<double> m_sliceBoundsOption = {}; // lower and upper x of each slice
+    std::size_t m_sliceIntervalOption = 0; // time steps between slices, 0 disables slices
+
+    // Instrumentation options
+    TimingReportOption m_timingReportOption = TimingReportOption::NO; // YES prints a per-stage and per-kernel table to stdout after Run
+    std::string m_timingFileOption = ""; // JSON dump of the same statistics, empty disables it
+    HardwareCountersOption m_hardwareCountersOption = HardwareCountersOption::NO; // perf_event_open counters per kernel
+    double m_peakBandwidthOption = 0.0; // GB/s of the roofline, 0 when unknown
+    double m_peakFlopRateOption = 0.0; // GFLOP/s of the roofline, 0 when unknown
+    std::string m_traceFileOption = ""; // Chrome trace-event timeline of every launch, stage and write, empty disables it
 };
 
 } // namespace MHD
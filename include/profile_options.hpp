@@ -11,6 +11,7 @@ enum class Dimension {
 enum class BoundaryConditionOption {
     REFLECTIVE = 0,
     OUTFLOW = 1,
+    PERIODIC = 2,
 };
 
 enum class TemporalIntegrationMethod {
@@ -32,6 +33,31 @@ enum class ReconstructionOption {
     MUSCL = 2,
 };
 
+enum class StepScheduleOption {
+    STAGED = 0,
+    TILED = 1,
+};
+
+enum class PinThreadsOption {
+    NO = 0,
+    YES = 1,
+};
+
+enum class ActivityTrackingOption {
+    NO = 0,
+    YES = 1,
+};
+
+enum class HaloOverlapOption {
+    NO = 0,
+    YES = 1,
+};
+
+enum class PrecisionOption {
+    DOUBLE = 0,
+    MIXED = 1,
+};
+
 enum class CompressibleOption {
     COMPRESSIBLE = 0,
 };
@@ -41,4 +67,37 @@ enum class OutputDataOption {
     YES = 1,
 };
 
+enum class OutputFormatOption {
+    CSV = 0,
+    BINARY = 1,
+};
+
+enum class CompressionOption {
+    NONE = 0,
+    XOR_BITPLANE = 1,
+};
+
+enum class TimingReportOption {
+    NO = 0,
+    YES = 1,
+};
+
+enum class HardwareCountersOption {
+    NO = 0,
+    YES = 1,
+};
+
+enum class DiagnosticIntegralOption {
+    MASS = 0,
+    MOMENTUM_X = 1,
+    TOTAL_ENERGY = 2,
+    KINETIC_ENERGY = 3,
+    MAGNETIC_ENERGY = 4,
+};
+
+enum class OutputModeOption {
+    SYNCHRONOUS = 0,
+    ASYNCHRONOUS = 1,
+};
+
 } // namespace MHD
@@ -1,13 +1,24 @@
+#include <allocation_tracker.hpp>
+#include <async_writer.hpp>
 #include <calc.hpp>
+#include <checkpoint.hpp>
+#include <communicator.hpp>
 #include <constants.hpp>
+#include <diagnostics/diagnostics.hpp>
 #include <error.hpp>
 #include <execution_controller.hpp>
 #include <grid.hpp>
+#include <halo/halo_exchange.hpp>
 #include <profile.hpp>
+#include <snapshot.hpp>
 #include <solver.hpp>
+#include <time_series.hpp>
+#include <trace.hpp>
 #include <variable_store.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <fstream>
 #include <cmath>
 #include <memory>
@@ -15,11 +26,96 @@
 
 namespace MHD {
 
-Calc::Calc(Profile const& profile) : m_profile(profile) {
+namespace {
+
+// 64-bit FNV-1a
+struct Fnv1aHash {
+    template <typename T> void Add(T const& value) {
+        unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&value);
+        for (std::size_t b = 0; b < sizeof(T); ++b) {
+            hash = (hash ^ bytes[b]) * 0x100000001b3ull;
+        }
+    }
+
+    template <typename T> void Add(std::vector<T> const& values) {
+        Add(values.size());
+        for (T const& value : values) {
+            Add(value);
+        }
+    }
+
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+};
+
+} // namespace
+
+Calc::Calc(Profile const& profile) : Calc(profile, worldCommunicator()) {}
+
+Calc::Calc(Profile const& profile, std::shared_ptr<ICommunicator> communicator) :
+    Calc(profile, gridFactory(profile, communicator->Rank(), communicator->Size()), communicator) {}
+
+Calc::Calc(Profile const& profile, std::shared_ptr<IGrid const> grid) :
+    Calc(profile, std::move(grid), std::make_shared<SerialCommunicator>()) {}
+
+Calc::Calc(Profile const& profile, std::shared_ptr<IGrid const> grid, std::shared_ptr<ICommunicator> communicator) :
+    m_grid(std::move(grid)), m_communicator(std::move(communicator)), m_profile(profile),
+    m_duration(profile.m_durationOption) {
+    if (!m_grid || m_grid->NumGhostLayers() != m_profile.m_numGhostLayersOption) {
+        throw Error::INVALID_GRID_GEOMETRY;
+    }
+    bool const decomposed = m_communicator->Size() > 1;
+
+    // Peak memory is reported relative to what the process held before this calculation, and only
+    // with the timing report, so the process-wide peak is left alone otherwise
+    if (TimingReportOption::YES == m_profile.m_timingReportOption) {
+        resetPeakResidentBytes();
+        m_residentBytesAtStart = currentResidentBytes();
+    }
+
+    if (!m_profile.m_traceFileOption.empty()) {
+        Tracer::Clear();
+        Tracer::Enable();
+        Tracer::SetThreadName("main");
+    }
+
     m_executionController = std::make_unique<ExecutionController>();
-    m_grid = gridFactory(m_profile);
+    if (HardwareCountersOption::YES == m_profile.m_hardwareCountersOption &&
+        !m_executionController->EnableHardwareCounters()) {
+        std::cerr << "Hardware counters unavailable, timing without them" << std::endl;
+    }
     m_variableStore = std::make_unique<VariableStore>(*m_grid);
-    m_solver = solverFactory(m_profile, *m_executionController, *m_variableStore, *m_grid);
+    if (decomposed) {
+        // Periodic ends are joined across the first and last rank instead of within one grid
+        bool const periodic = m_profile.m_boundaryConditionsOption.empty()
+            ? BoundaryConditionOption::PERIODIC == m_profile.m_boundaryConditionOption
+            : BoundaryConditionOption::PERIODIC == m_profile.m_boundaryConditionsOption.front();
+        Decomposition const decomposition = decompose1D(m_communicator, periodic);
+        m_solver = solverFactory(m_profile, *m_executionController, *m_variableStore, *m_grid, &decomposition);
+    } else {
+        m_solver = solverFactory(m_profile, *m_executionController, *m_variableStore, *m_grid);
+    }
+
+    for (auto const& node : m_grid->Nodes()) {
+        m_nodeCoordsX.push_back(node[0]);
+    }
+
+    // Binary snapshots are serialized on a background thread unless synchronous output is requested
+    if (OutputDataOption::YES == m_profile.m_outputDataOption &&
+        OutputFormatOption::BINARY == m_profile.m_outputFormatOption &&
+        OutputModeOption::ASYNCHRONOUS == m_profile.m_outputModeOption) {
+        m_snapshotWriter = std::make_unique<AsyncSnapshotWriter>();
+    }
+
+    if (m_profile.m_diagnosticsIntervalOption > 0 || m_profile.m_sliceIntervalOption > 0) {
+        m_diagnostics = std::make_unique<Diagnostics>(m_profile, *m_grid, *m_variableStore,
+                                                      decomposed ? m_communicator.get() : nullptr);
+    }
+    if (m_profile.m_diagnosticsIntervalOption > 0) {
+        std::vector<std::string> columnNames = {"time", "step"};
+        columnNames.insert(columnNames.end(), m_diagnostics->Names().begin(), m_diagnostics->Names().end());
+        m_diagnosticsWriter = std::make_unique<TimeSeriesWriter>(OutputPath(m_profile.m_diagnosticsFileOption), columnNames);
+        m_diagnosticsRow.resize(columnNames.size());
+    }
 }
 
 Calc::~Calc() = default;
@@ -34,6 +130,7 @@ void Calc::SetInitialCondition(InitialCondition ic) {
     } else {
         throw Error::INVALID_INITIAL_CONDITION;
     }
+    m_solver->StateReplaced();
 }
 
 void Calc::SetAtmosphere() {
@@ -62,9 +159,12 @@ void Calc::SetSodShockTube() {
     double const p2 = 0.1 * STANDARD_PRESSURE;
     double const e2 = p2 / ((gamma - 1.0) * rho2);
 
+    // The interface sits at the middle of the whole domain, wherever this grid lies in it
     std::size_t const numCells = m_grid->NumCells();
+    std::size_t const firstCell = m_grid->FirstCell();
+    std::size_t const numGlobalCells = m_grid->NumGlobalCells();
     for (std::size_t i = 0; i < numCells; ++i) {
-        if (i <= numCells / 2) {
+        if (firstCell + i <= numGlobalCells / 2) {
             m_variableStore->rho[i] = rho1;
             m_variableStore->rhoU[i] = 0.0;
             m_variableStore->rhoV[i] = 0.0;
@@ -97,9 +197,12 @@ void Calc::SetBrioWuShockTube() {
     double const b2Squared = bx * bx + by2 * by2 + bz * bz;
     double const e2 = p2 / ((gamma - 1.0) * rho2);
 
+    // The interface sits at the middle of the whole domain, wherever this grid lies in it
     std::size_t const numCells = m_grid->NumCells();
+    std::size_t const firstCell = m_grid->FirstCell();
+    std::size_t const numGlobalCells = m_grid->NumGlobalCells();
     for (std::size_t i = 0; i < numCells; ++i) {
-        if (i <= numCells / 2) {
+        if (firstCell + i <= numGlobalCells / 2) {
             m_variableStore->rho[i] = rho1;
             m_variableStore->rhoU[i] = 0.0;
             m_variableStore->rhoV[i] = 0.0;
@@ -122,23 +225,421 @@ void Calc::SetBrioWuShockTube() {
 }
 
 void Calc::Run() {
-    while (m_currentTime < m_duration) {
-        m_solver->PrimFromCons();
-        if (OutputDataOption::YES == m_profile.m_outputDataOption) {
-            if (m_currentTime >= m_currentOutput * m_outputPeriod) {
-                WriteData(*m_variableStore);
-                ++m_currentOutput;
+    using Region = ExecutionController::ScopedRegion;
+    {
+        Region runRegion(*m_executionController, "Run");
+        while (m_currentTime < m_duration) {
+            Advance();
+        }
+
+        Region region(*m_executionController, "Output");
+        if (m_snapshotWriter) {
+            m_snapshotWriter->Flush();
+        }
+        if (m_diagnosticsWriter) {
+            m_diagnosticsWriter->Flush();
+        }
+    }
+
+    if (TimingReportOption::YES == m_profile.m_timingReportOption && m_communicator->Rank() == 0) {
+        m_executionController->PrintSummary(std::cout);
+
+        std::size_t const peakBytes = peakResidentBytes();
+        double const bytesPerCell = peakBytes > m_residentBytesAtStart
+            ? static_cast<double>(peakBytes - m_residentBytesAtStart) / m_grid->NumCells() : 0.0;
+        std::cout << "\nPeak resident memory: " << 1e-6 * peakBytes << " MB, " << bytesPerCell
+                  << " bytes per cell above the " << 1e-6 * m_residentBytesAtStart << " MB before setup" << std::endl;
+        if (HardwareCountersOption::YES == m_profile.m_hardwareCountersOption ||
+            (m_profile.m_peakBandwidthOption > 0.0 && m_profile.m_peakFlopRateOption > 0.0)) {
+            std::cout << "\n";
+            m_executionController->PrintRoofline(std::cout, m_profile.m_peakBandwidthOption,
+                                                 m_profile.m_peakFlopRateOption);
+        }
+    }
+    if (!m_profile.m_timingFileOption.empty()) {
+        m_executionController->WriteJson(OutputPath(m_profile.m_timingFileOption));
+    }
+    if (!m_profile.m_traceFileOption.empty()) {
+        Tracer::WriteChromeTrace(OutputPath(m_profile.m_traceFileOption));
+        Tracer::Disable();
+    }
+}
+
+void Calc::Step(std::size_t const numSteps) {
+    ExecutionController::ScopedRegion runRegion(*m_executionController, "Run");
+    for (std::size_t step = 0; step < numSteps; ++step) {
+        Advance();
+    }
+}
+
+void Calc::RunUntil(double const time) {
+    ExecutionController::ScopedRegion runRegion(*m_executionController, "Run");
+    while (m_currentTime < time) {
+        double const remaining = time - m_currentTime;
+        m_solver->LimitTimeStep(remaining);
+        Advance();
+
+        // Snap to the target rather than leave a rounding-sized step for the next call
+        if (m_solver->TimeStep() == remaining) {
+            m_currentTime = time;
+        }
+    }
+    m_solver->LimitTimeStep(std::numeric_limits<double>::infinity());
+}
+
+void Calc::Advance() {
+    using Region = ExecutionController::ScopedRegion;
+    m_solver->PrimFromCons();
+    if (OutputDataOption::YES == m_profile.m_outputDataOption) {
+        if (m_currentTime >= m_currentOutput * m_outputPeriod) {
+            Region region(*m_executionController, "Output");
+            WriteData(*m_variableStore);
+            ++m_currentOutput;
+        }
+    }
+    if (m_diagnostics) {
+        Region region(*m_executionController, "Diagnostics");
+        SampleDiagnostics();
+    }
+    if (!m_observers.empty()) {
+        Region region(*m_executionController, "Observers");
+        NotifyObservers();
+    }
+    m_solver->PerformTimeStep();
+    m_currentTime += m_solver->TimeStep();
+    m_currentStep++;
+
+    std::size_t const checkpointInterval = m_profile.m_checkpointIntervalOption;
+    if (checkpointInterval > 0 && m_currentStep % checkpointInterval == 0) {
+        Region region(*m_executionController, "Checkpoint");
+        WriteCheckpoint(OutputPath(m_profile.m_checkpointFileOption));
+    }
+}
+
+StateView Calc::State() {
+    m_solver->PrimFromCons();
+    return MakeStateView();
+}
+
+void Calc::Load(StateView const& state) {
+    std::size_t const numCells = m_grid->NumCells();
+    for (FieldView const* field : {&state.rho, &state.rhoU, &state.rhoV, &state.rhoW, &state.rhoE,
+                                   &state.bx, &state.by, &state.bz}) {
+        if (field->Size() != numCells || !field->Data()) {
+            throw Error::INVALID_STATE;
+        }
+    }
+
+    VariableStore& varStore = *m_variableStore;
+    std::copy(state.rho.begin(), state.rho.end(), varStore.rho.begin());
+    std::copy(state.rhoU.begin(), state.rhoU.end(), varStore.rhoU.begin());
+    std::copy(state.rhoV.begin(), state.rhoV.end(), varStore.rhoV.begin());
+    std::copy(state.rhoW.begin(), state.rhoW.end(), varStore.rhoW.begin());
+    std::copy(state.rhoE.begin(), state.rhoE.end(), varStore.rhoE.begin());
+    std::copy(state.bx.begin(), state.bx.end(), varStore.bx.begin());
+    std::copy(state.by.begin(), state.by.end(), varStore.by.begin());
+    std::copy(state.bz.begin(), state.bz.end(), varStore.bz.begin());
+    m_solver->StateReplaced();
+    m_currentTime = state.time;
+    m_currentStep = state.step;
+
+    // Output resumes at the first scheduled time not yet passed
+    if (m_outputPeriod > 0.0) {
+        m_currentOutput = static_cast<std::size_t>(std::ceil(m_currentTime / m_outputPeriod));
+    }
+}
+
+StateView Calc::MakeStateView() const {
+    VariableStore const& varStore = *m_variableStore;
+    std::size_t const numCells = m_grid->NumCells();
+    StateView view;
+    view.time = m_currentTime;
+    view.step = m_currentStep;
+    view.numCells = numCells;
+    view.x = FieldView(m_nodeCoordsX.data(), numCells);
+    view.rho = FieldView(varStore.rho.data(), numCells);
+    view.rhoU = FieldView(varStore.rhoU.data(), numCells);
+    view.rhoV = FieldView(varStore.rhoV.data(), numCells);
+    view.rhoW = FieldView(varStore.rhoW.data(), numCells);
+    view.rhoE = FieldView(varStore.rhoE.data(), numCells);
+    view.u = FieldView(varStore.u.data(), numCells);
+    view.v = FieldView(varStore.v.data(), numCells);
+    view.w = FieldView(varStore.w.data(), numCells);
+    view.p = FieldView(varStore.p.data(), numCells);
+    view.e = FieldView(varStore.e.data(), numCells);
+    view.t = FieldView(varStore.t.data(), numCells);
+    view.cs = FieldView(varStore.cs.data(), numCells);
+    view.bx = FieldView(varStore.bx.data(), numCells);
+    view.by = FieldView(varStore.by.data(), numCells);
+    view.bz = FieldView(varStore.bz.data(), numCells);
+    return view;
+}
+
+std::size_t Calc::AddObserver(Observer observer, std::size_t const stepInterval) {
+    if (!observer || stepInterval == 0) {
+        throw Error::INVALID_OBSERVER;
+    }
+    (m_notifyingObservers ? m_addedObservers : m_observers)
+        .push_back({m_nextObserverId, std::move(observer), stepInterval, 0.0, 0.0});
+    return m_nextObserverId++;
+}
+
+std::size_t Calc::AddTimeObserver(Observer observer, double const timeInterval) {
+    if (!observer || !(timeInterval > 0.0)) {
+        throw Error::INVALID_OBSERVER;
+    }
+    (m_notifyingObservers ? m_addedObservers : m_observers)
+        .push_back({m_nextObserverId, std::move(observer), 0, timeInterval, m_currentTime});
+    return m_nextObserverId++;
+}
+
+void Calc::RemoveObserver(std::size_t const id) {
+    auto const matches = [id](ObserverEntry const& entry) { return entry.id == id && !entry.removed; };
+    auto const added = std::find_if(m_addedObservers.begin(), m_addedObservers.end(), matches);
+    if (added != m_addedObservers.end()) {
+        m_addedObservers.erase(added);
+        return;
+    }
+    auto const it = std::find_if(m_observers.begin(), m_observers.end(), matches);
+    if (it == m_observers.end()) {
+        throw Error::INVALID_OBSERVER;
+    }
+
+    // A callback may be running, possibly this one, so it is only erased after the notification
+    if (m_notifyingObservers) {
+        it->removed = true;
+    } else {
+        m_observers.erase(it);
+    }
+}
+
+void Calc::NotifyObservers() {
+    // Applies what callbacks added and removed, also when one of them throws
+    auto const settle = [this]() {
+        m_notifyingObservers = false;
+        m_observers.erase(std::remove_if(m_observers.begin(), m_observers.end(),
+                                         [](ObserverEntry const& entry) { return entry.removed; }),
+                          m_observers.end());
+        for (ObserverEntry& entry : m_addedObservers) {
+            m_observers.push_back(std::move(entry));
+        }
+        m_addedObservers.clear();
+    };
+
+    StateView const view = MakeStateView();
+    m_notifyingObservers = true;
+    try {
+        for (ObserverEntry& entry : m_observers) {
+            if (entry.removed) {
+                continue;
+            }
+            if (entry.stepInterval > 0) {
+                if (m_currentStep % entry.stepInterval == 0) {
+                    entry.observer(view);
+                }
+            } else if (m_currentTime >= entry.nextTime) {
+                entry.observer(view);
+
+                // A step longer than the interval yields one call, not a burst of stale ones
+                while (entry.nextTime <= m_currentTime) {
+                    entry.nextTime += entry.timeInterval;
+                }
             }
         }
-        m_solver->PerformTimeStep();
-        m_currentTime += m_solver->TimeStep();
-        m_currentStep++;
+    } catch (...) {
+        settle();
+        throw;
+    }
+    settle();
+}
+
+std::string Calc::OutputPath(std::string const& filename) const {
+    if (m_communicator->Size() > 1) {
+        return m_profile.m_outputPrefixOption + "rank_" + std::to_string(m_communicator->Rank()) + "_" + filename;
+    }
+    return m_profile.m_outputPrefixOption + filename;
+}
+
+void Calc::SampleDiagnostics() {
+    std::size_t const diagnosticsInterval = m_profile.m_diagnosticsIntervalOption;
+    if (diagnosticsInterval > 0 && m_currentStep % diagnosticsInterval == 0) {
+        m_diagnosticsRow[0] = m_currentTime;
+        m_diagnosticsRow[1] = static_cast<double>(m_currentStep);
+        m_diagnostics->Sample(*m_executionController, m_diagnosticsRow.data() + 2);
+        m_diagnosticsWriter->Append(m_diagnosticsRow.data());
+    }
+
+    std::size_t const sliceInterval = m_profile.m_sliceIntervalOption;
+    if (sliceInterval > 0 && m_currentStep % sliceInterval == 0) {
+        WriteSlices(*m_variableStore);
+    }
+}
+
+std::uint64_t Calc::StateHash() const {
+    Fnv1aHash hasher;
+
+    // Everything that changes the meaning or layout of the conserved state
+    hasher.Add(m_profile.m_gridDimensionOption);
+    hasher.Add(m_profile.m_gridBoundsOption);
+    hasher.Add(m_profile.m_gridSpacingsOption);
+    hasher.Add(m_profile.m_numGhostLayersOption);
+    hasher.Add(m_profile.m_boundaryConditionOption);
+    hasher.Add(m_profile.m_boundaryConditionsOption);
+    hasher.Add(m_profile.m_reconstructionOption);
+    hasher.Add(m_profile.m_fluxOption);
+    hasher.Add(m_profile.m_temporalIntegrationOption);
+    hasher.Add(m_profile.m_compressibleOption);
+    hasher.Add(m_grid->NumCells());
+    hasher.Add(m_grid->NumNodes());
+    hasher.Add(m_nodeCoordsX);
+
+    return hasher.hash;
+}
+
+void Calc::WriteCheckpoint(std::string const& filename) const {
+    CheckpointInfo info;
+    info.time = m_currentTime;
+    info.step = m_currentStep;
+    info.output = m_currentOutput;
+    info.hash = StateHash();
+    info.numNodes = m_grid->NumNodes();
+    info.compression = m_profile.m_outputCompressionOption;
+
+    writeCheckpoint(filename, info, {
+        {"rho", m_variableStore->rho.data()},
+        {"rhoU", m_variableStore->rhoU.data()},
+        {"rhoV", m_variableStore->rhoV.data()},
+        {"rhoW", m_variableStore->rhoW.data()},
+        {"rhoE", m_variableStore->rhoE.data()},
+        {"bx", m_variableStore->bx.data()},
+        {"by", m_variableStore->by.data()},
+        {"bz", m_variableStore->bz.data()},
+    });
+}
+
+void Calc::Restart(std::string const& filename) {
+    MappedCheckpoint const checkpoint(filename);
+    CheckpointInfo const& info = checkpoint.Info();
+    if (info.hash != StateHash() || info.numNodes != m_grid->NumNodes()) {
+        throw Error::INVALID_CHECKPOINT;
     }
+
+    // The conserved arrays are copied straight out of the mapped pages
+    std::size_t const numNodes = info.numNodes;
+    auto adopt = [&](std::string const& name, std::vector<double>& field) {
+        double const* data = checkpoint.Field(name);
+        std::copy(data, data + numNodes, field.begin());
+    };
+    adopt("rho", m_variableStore->rho);
+    adopt("rhoU", m_variableStore->rhoU);
+    adopt("rhoV", m_variableStore->rhoV);
+    adopt("rhoW", m_variableStore->rhoW);
+    adopt("rhoE", m_variableStore->rhoE);
+    adopt("bx", m_variableStore->bx);
+    adopt("by", m_variableStore->by);
+    adopt("bz", m_variableStore->bz);
+    m_solver->StateReplaced();
+
+    m_currentTime = info.time;
+    m_currentStep = info.step;
+    m_currentOutput = info.output;
 }
 
 void Calc::WriteData(VariableStore const& varStore) {
+    if (OutputFormatOption::CSV == m_profile.m_outputFormatOption) {
+        WriteCsvData(varStore);
+    } else {
+        WriteBinaryData(varStore);
+    }
+}
+
+std::vector<SnapshotField> Calc::SnapshotFields(VariableStore const& varStore, std::size_t const first) const {
+    return {
+        {"x", m_nodeCoordsX.data() + first},
+        {"rho", varStore.rho.data() + first},
+        {"u", varStore.u.data() + first},
+        {"v", varStore.v.data() + first},
+        {"w", varStore.w.data() + first},
+        {"bx", varStore.bx.data() + first},
+        {"by", varStore.by.data() + first},
+        {"bz", varStore.bz.data() + first},
+        {"e", varStore.e.data() + first},
+        {"p", varStore.p.data() + first},
+        {"T", varStore.t.data() + first},
+        {"cs", varStore.cs.data() + first},
+    };
+}
+
+void Calc::WriteSnapshot(std::string const& filename) {
+    m_solver->PrimFromCons();
+
+    SnapshotInfo info;
+    info.time = m_currentTime;
+    info.step = m_currentStep;
+    info.dimension = static_cast<std::size_t>(m_profile.m_gridDimensionOption) + 1;
+    info.numCells = m_grid->NumCells();
+    info.numNodes = m_grid->NumNodes();
+    info.compression = m_profile.m_outputCompressionOption;
+
+    writeSnapshot(filename, info, SnapshotFields(*m_variableStore, 0));
+}
+
+void Calc::WriteSlices(VariableStore const& varStore) {
+    std::vector<SliceRange> const& slices = m_diagnostics->Slices();
+    for (std::size_t s = 0; s < slices.size(); ++s) {
+        // Each rank writes the part of a slice within its cells, if any
+        if (slices[s].count == 0) {
+            continue;
+        }
+        std::string filename = OutputPath("slice_" + std::to_string(s) + "_" + std::to_string(m_currentStep) + ".snap");
+
+        // A slice is a contiguous run of interior cells, so it is written straight from the store
+        SnapshotInfo info;
+        info.time = m_currentTime;
+        info.step = m_currentStep;
+        info.dimension = static_cast<std::size_t>(m_profile.m_gridDimensionOption) + 1;
+        info.numCells = slices[s].count;
+        info.numNodes = slices[s].count;
+        info.compression = m_profile.m_outputCompressionOption;
+
+        try {
+            writeSnapshot(filename, info, SnapshotFields(varStore, slices[s].first));
+        } catch (Error const&) {
+            std::cerr << "Unable to write file: " << filename << std::endl;
+        }
+    }
+}
+
+void Calc::WriteBinaryData(VariableStore const& varStore) {
+    std::string filename = OutputPath("results_" + std::to_string(m_currentOutput) + ".snap");
+
+    SnapshotInfo info;
+    info.time = m_currentTime;
+    info.step = m_currentStep;
+    info.dimension = static_cast<std::size_t>(m_profile.m_gridDimensionOption) + 1;
+    info.numCells = m_grid->NumCells();
+    info.numNodes = m_grid->NumNodes();
+    info.compression = m_profile.m_outputCompressionOption;
+
+    std::vector<SnapshotField> const fields = SnapshotFields(varStore, 0);
+
+    if (m_snapshotWriter) {
+        m_snapshotWriter->Submit(filename, info, fields);
+        std::cout << "Data queued at time: " << m_currentTime << " s" << std::endl;
+        return;
+    }
+
+    try {
+        writeSnapshot(filename, info, fields);
+        std::cout << "Data written at time: " << m_currentTime << " s" << std::endl;
+    } catch (Error const&) {
+        std::cerr << "Unable to write file: " << filename << std::endl;
+    }
+}
+
+void Calc::WriteCsvData(VariableStore const& varStore) {
     std::ofstream myFile;
-    std::string filename = "results_" + std::to_string(m_currentOutput) + ".csv";
+    std::string filename = OutputPath("results_" + std::to_string(m_currentOutput) + ".csv");
     
     // Open the file for writing
     myFile.open(filename);
@@ -0,0 +1,308 @@
+#include <batched.hpp>
+#include <ensemble.hpp>
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <grid.hpp>
+#include <solver.hpp>
+#include <thread_pool.hpp>
+#include <trace.hpp>
+#include <variable_store.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <utility>
+
+namespace MHD {
+
+namespace {
+
+// Members that one solver can advance together, one step at a time
+bool batchable(Profile const& a, Profile const& b) {
+    return a.m_temporalBlockStepsOption == 1 && b.m_temporalBlockStepsOption == 1 &&
+           a.m_refinementLevelsOption == 0 && b.m_refinementLevelsOption == 0 &&
+           a.m_reconstructionOption == b.m_reconstructionOption &&
+           a.m_precisionOption == b.m_precisionOption &&
+           a.m_activityTrackingOption == b.m_activityTrackingOption &&
+           a.m_fluxOption == b.m_fluxOption &&
+           a.m_temporalIntegrationOption == b.m_temporalIntegrationOption &&
+           a.m_compressibleOption == b.m_compressibleOption &&
+           a.m_boundaryConditionOption == b.m_boundaryConditionOption &&
+           a.m_boundaryConditionsOption == b.m_boundaryConditionsOption &&
+           a.m_durationOption == b.m_durationOption;
+}
+
+} // namespace
+
+Ensemble::Ensemble(Profile const& profile, std::size_t const numThreads, std::size_t const batchWidth) :
+    m_profile(profile), m_grid(gridFactory(profile)),
+    m_threadPool(std::make_unique<ThreadPool>(numThreads, "ensemble worker")),
+    m_batchWidth(std::max<std::size_t>(batchWidth, 1)) {}
+
+Ensemble::~Ensemble() = default;
+
+std::size_t Ensemble::NumThreads() const {
+    return m_threadPool->NumThreads();
+}
+
+std::size_t Ensemble::AddMember(InitialCondition const ic, Setup setup, Finish finish) {
+    return AddMember(m_profile, ic, std::move(setup), std::move(finish));
+}
+
+std::size_t Ensemble::AddMember(Profile const& profile, InitialCondition const ic, Setup setup, Finish finish) {
+    // Members only read the shared grid, so they have to agree on everything it was built from, which
+    // for a stretched grid includes whether its ghost cells wrap round
+    bool const stretched = !m_profile.m_gridNodesOption.empty() || !m_profile.m_gridClusterPointsOption.empty();
+    if (profile.m_gridDimensionOption != m_profile.m_gridDimensionOption ||
+        profile.m_gridBoundsOption != m_profile.m_gridBoundsOption ||
+        profile.m_gridSpacingsOption != m_profile.m_gridSpacingsOption ||
+        profile.m_gridNodesOption != m_profile.m_gridNodesOption ||
+        profile.m_gridClusterPointsOption != m_profile.m_gridClusterPointsOption ||
+        profile.m_gridClusterRatioOption != m_profile.m_gridClusterRatioOption ||
+        profile.m_gridClusterWidthOption != m_profile.m_gridClusterWidthOption ||
+        profile.m_numGhostLayersOption != m_profile.m_numGhostLayersOption ||
+        (stretched && (profile.m_boundaryConditionOption != m_profile.m_boundaryConditionOption ||
+                       profile.m_boundaryConditionsOption != m_profile.m_boundaryConditionsOption))) {
+        throw Error::INVALID_GRID_GEOMETRY;
+    }
+
+    std::size_t const index = m_members.size();
+    Member member{profile, ic, std::move(setup), std::move(finish)};
+    member.profile.m_outputPrefixOption = m_profile.m_outputPrefixOption + "member_" + std::to_string(index) + "_";
+    member.profile.m_timingReportOption = TimingReportOption::NO;
+    member.profile.m_numThreadsOption = 1; // members already run one per thread of the pool
+    member.profile.m_traceFileOption = "";
+    m_members.push_back(std::move(member));
+    return index;
+}
+
+std::vector<EnsembleResult> Ensemble::Run() {
+    bool const tracing = !m_profile.m_traceFileOption.empty();
+    if (tracing) {
+        Tracer::Clear();
+        Tracer::Enable();
+        Tracer::SetThreadName("main");
+    }
+
+    // Consecutive compatible members share a batch, everything else runs as a batch of one
+    std::vector<std::pair<std::size_t, std::size_t>> batches;
+    for (std::size_t m = 0; m < m_members.size(); ++m) {
+        if (!batches.empty() && batches.back().second < m_batchWidth &&
+            batchable(m_members[batches.back().first].profile, m_members[m].profile)) {
+            ++batches.back().second;
+        } else {
+            batches.emplace_back(m, 1);
+        }
+    }
+
+    std::vector<EnsembleResult> results(m_members.size());
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto const& [first, count] : batches) {
+        m_threadPool->Submit([this, first = first, count = count, &results, &failure, &failureMutex] {
+            try {
+                if (count == 1) {
+                    RunMember(m_members[first], results[first]);
+                } else {
+                    RunBatch(first, count, results);
+                }
+            } catch (...) {
+                // Anything but an Error is a bug rather than a member that went wrong, so it is rethrown
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        });
+    }
+    m_threadPool->Wait();
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (tracing) {
+        Tracer::WriteChromeTrace(m_profile.m_outputPrefixOption + m_profile.m_traceFileOption);
+        Tracer::Disable();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    if (TimingReportOption::YES == m_profile.m_timingReportOption) {
+        double numCellUpdates = 0.0;
+        std::size_t numFailed = 0;
+        for (EnsembleResult const& result : results) {
+            numCellUpdates += static_cast<double>(result.steps) * m_grid->NumCells();
+            numFailed += result.status != Error::SUCCESS;
+        }
+        std::cout << "Ensemble of " << results.size() << " members in " << batches.size() << " batches on "
+                  << NumThreads() << " threads: "
+                  << seconds << " s, " << numCellUpdates / seconds << " cell updates/s";
+        if (numFailed > 0) {
+            std::cout << ", " << numFailed << " failed";
+        }
+        std::cout << std::endl;
+    }
+    return results;
+}
+
+void Ensemble::RunMember(Member const& member, EnsembleResult& result) const {
+    ScopedTrace trace("Member", "ensemble");
+    result.outputPrefix = member.profile.m_outputPrefixOption;
+    auto const start = std::chrono::steady_clock::now();
+
+    // The calc is built on the worker so its controller and counters belong to the thread that runs it
+    try {
+        Calc calc(member.profile, m_grid);
+        calc.SetInitialCondition(member.initialCondition);
+        if (member.setup) {
+            member.setup(calc);
+        }
+        try {
+            calc.Run();
+        } catch (Error const& error) {
+            result.status = error;
+        }
+        result.time = calc.CurrentTime();
+        result.steps = calc.CurrentStep();
+        if (member.finish && Error::SUCCESS == result.status) {
+            member.finish(calc);
+        }
+    } catch (Error const& error) {
+        result.status = error;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Ensemble::RunBatch(std::size_t const first, std::size_t const count, std::vector<EnsembleResult>& results) const {
+    ScopedTrace trace("Batch", "ensemble", count);
+    auto const start = std::chrono::steady_clock::now();
+    auto elapsed = [&start] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Every member gets its own calc for the initial condition, the callbacks and the final state
+    std::vector<std::unique_ptr<Calc>> calcs(count);
+    std::vector<std::size_t> lanes;
+    for (std::size_t k = 0; k < count; ++k) {
+        Member const& member = m_members[first + k];
+        EnsembleResult& result = results[first + k];
+        result.outputPrefix = member.profile.m_outputPrefixOption;
+        try {
+            calcs[k] = std::make_unique<Calc>(member.profile, m_grid);
+            calcs[k]->SetInitialCondition(member.initialCondition);
+            if (member.setup) {
+                member.setup(*calcs[k]);
+            }
+            if (calcs[k]->CurrentTime() == 0.0) {
+                lanes.push_back(k);
+                continue;
+            }
+            calcs[k]->Run();
+            result.time = calcs[k]->CurrentTime();
+            result.steps = calcs[k]->CurrentStep();
+            if (member.finish) {
+                member.finish(*calcs[k]);
+            }
+        } catch (Error const& error) {
+            result.status = error;
+        }
+        result.seconds = elapsed();
+    }
+    if (lanes.empty()) {
+        return;
+    }
+
+    // Per-boundary options repeat for every lane, in the order the batched grid numbers its boundaries
+    std::size_t const width = lanes.size();
+    Profile profile = m_members[first + lanes[0]].profile;
+    std::vector<BoundaryConditionOption> options = profile.m_boundaryConditionsOption;
+    if (options.empty()) {
+        options.assign(m_grid->NumBoundaries(), profile.m_boundaryConditionOption);
+    }
+    profile.m_boundaryConditionsOption.clear();
+    for (BoundaryConditionOption const option : options) {
+        profile.m_boundaryConditionsOption.insert(profile.m_boundaryConditionsOption.end(), width, option);
+    }
+
+    BatchedGrid const grid(*m_grid, width);
+    ExecutionController execCtrl;
+    VariableStore varStore(grid);
+    std::unique_ptr<ISolver> const solver = solverFactory(profile, execCtrl, varStore, grid);
+
+    std::size_t const numCells = m_grid->NumCells();
+    auto scatter = [&](FieldView const& field, std::vector<double>& target, std::size_t const lane) {
+        for (std::size_t i = 0; i < numCells; ++i) {
+            target[i * width + lane] = field[i];
+        }
+    };
+    for (std::size_t lane = 0; lane < width; ++lane) {
+        StateView const state = calcs[lanes[lane]]->State();
+        scatter(state.rho, varStore.rho, lane);
+        scatter(state.rhoU, varStore.rhoU, lane);
+        scatter(state.rhoV, varStore.rhoV, lane);
+        scatter(state.rhoW, varStore.rhoW, lane);
+        scatter(state.rhoE, varStore.rhoE, lane);
+        scatter(state.bx, varStore.bx, lane);
+        scatter(state.by, varStore.by, lane);
+        scatter(state.bz, varStore.bz, lane);
+    }
+    solver->StateReplaced();
+
+    // Lock-step: the solver's wave speed maximum spans every lane, so each step is stable for all of them
+    double time = 0.0;
+    std::size_t step = 0;
+    Error status = Error::SUCCESS;
+    try {
+        while (time < profile.m_durationOption) {
+            solver->PrimFromCons();
+            solver->PerformTimeStep();
+            time += solver->TimeStep();
+            ++step;
+        }
+    } catch (Error const& error) {
+        status = error;
+    }
+
+    std::vector<std::vector<double>> laneFields(8, std::vector<double>(numCells));
+    std::vector<double> const* batchFields[] = {&varStore.rho, &varStore.rhoU, &varStore.rhoV, &varStore.rhoW,
+                                                &varStore.rhoE, &varStore.bx, &varStore.by, &varStore.bz};
+    double const seconds = elapsed();
+    for (std::size_t lane = 0; lane < width; ++lane) {
+        for (std::size_t f = 0; f < laneFields.size(); ++f) {
+            for (std::size_t i = 0; i < numCells; ++i) {
+                laneFields[f][i] = (*batchFields[f])[i * width + lane];
+            }
+        }
+        StateView state;
+        state.time = time;
+        state.step = step;
+        state.numCells = numCells;
+        state.rho = FieldView(laneFields[0].data(), numCells);
+        state.rhoU = FieldView(laneFields[1].data(), numCells);
+        state.rhoV = FieldView(laneFields[2].data(), numCells);
+        state.rhoW = FieldView(laneFields[3].data(), numCells);
+        state.rhoE = FieldView(laneFields[4].data(), numCells);
+        state.bx = FieldView(laneFields[5].data(), numCells);
+        state.by = FieldView(laneFields[6].data(), numCells);
+        state.bz = FieldView(laneFields[7].data(), numCells);
+
+        std::size_t const k = lanes[lane];
+        EnsembleResult& result = results[first + k];
+        result.status = status;
+        result.time = time;
+        result.steps = step;
+        result.seconds = seconds;
+        try {
+            calcs[k]->Load(state);
+            if (m_members[first + k].finish && Error::SUCCESS == status) {
+                m_members[first + k].finish(*calcs[k]);
+            }
+        } catch (Error const& error) {
+            result.status = error;
+        }
+    }
+}
+
+} // namespace MHD
@@ -1,46 +1,251 @@
 #include <1d.hpp>
+#include <error.hpp>
 #include <grid.hpp>
 #include <profile.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <memory>
 #include <vector>
 
 namespace MHD {
 
-Cartesian1DGrid::Cartesian1DGrid(Profile const& profile) {
+namespace {
+
+// Faces in x of the whole domain, uniformly spaced between the bounds unless the profile lists them
+// or clusters the cells towards points. Clustered cells follow a density of one per spacing plus a
+// Gaussian bump of ratio - 1 more about each point, whose integral has a closed form in erf, and
+// face k is where that integral reaches k cells
+class DomainFaces {
+public:
+    explicit DomainFaces(Profile const& profile) :
+        m_nodes(profile.m_gridNodesOption), m_points(profile.m_gridClusterPointsOption),
+        m_lower(profile.m_gridBoundsOption[0]), m_upper(profile.m_gridBoundsOption[1]),
+        m_spacing(profile.m_gridSpacingsOption[0]), m_width(profile.m_gridClusterWidthOption),
+        m_peak(profile.m_gridClusterRatioOption - 1.0), m_bump(0.5 * std::sqrt(M_PI) * m_peak * m_width),
+        m_periodic(BoundaryConditionOption::PERIODIC == (profile.m_boundaryConditionsOption.empty()
+            ? profile.m_boundaryConditionOption : profile.m_boundaryConditionsOption.front())) {
+        if (!m_nodes.empty()) {
+            if (!m_points.empty() || m_nodes.size() < 2 ||
+                std::adjacent_find(m_nodes.begin(), m_nodes.end(), std::greater_equal<double>()) != m_nodes.end()) {
+                throw Error::INVALID_GRID_GEOMETRY;
+            }
+            m_numCells = m_nodes.size() - 1;
+        } else if (!m_points.empty()) {
+            if (m_peak < 0.0 || m_width <= 0.0 || m_spacing <= 0.0 || m_upper <= m_lower) {
+                throw Error::INVALID_GRID_GEOMETRY;
+            }
+            m_numCells = std::max<std::size_t>(1, std::lround(Cells(m_upper)));
+            m_cellsPerFace = Cells(m_upper) / m_numCells;
+        } else {
+            m_numCells = (m_upper - m_lower) / m_spacing;
+        }
+    }
+
+    bool Stretched() const { return !m_nodes.empty() || !m_points.empty(); }
+    std::size_t NumCells() const { return m_numCells; }
+
+    // Face k of a stretched domain. Ghost cells past a bound repeat the cells at the other end of a
+    // periodic domain, and otherwise mirror the cells inside it
+    double operator()(long const k) const {
+        long const n = static_cast<long>(m_numCells);
+        if (m_periodic && (k < 0 || k > n)) {
+            long const wraps = k < 0 ? -((n - 1 - k) / n) : k / n;
+            return Face(k - wraps * n) + wraps * (Face(n) - Face(0));
+        }
+        if (k < 0) {
+            return 2.0 * Face(0) - Face(std::min(-k, n));
+        }
+        if (k > n) {
+            return 2.0 * Face(n) - Face(std::max(2 * n - k, 0L));
+        }
+        return Face(k);
+    }
+
+    // Width of cell k, past the ends of a periodic domain that of the cell it repeats, to the bit
+    double Width(long k) const {
+        long const n = static_cast<long>(m_numCells);
+        if (m_periodic) {
+            k = ((k % n) + n) % n;
+        }
+        return (*this)(k + 1) - (*this)(k);
+    }
+
+private:
+    double Face(long const k) const {
+        if (!m_nodes.empty()) {
+            return m_nodes[k];
+        }
+        if (k == 0) {
+            return m_lower;
+        }
+        if (k == static_cast<long>(m_numCells)) {
+            return m_upper;
+        }
+
+        // Newton on the cells below x, which rise monotonically, kept inside a bracket by bisection
+        double const target = k * m_cellsPerFace;
+        double lower = m_lower;
+        double upper = m_upper;
+        double x = m_lower + (m_upper - m_lower) * k / m_numCells;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            double const residual = Cells(x) - target;
+            (residual < 0.0 ? lower : upper) = x;
+            double next = x - residual / Density(x);
+            if (!(next > lower && next < upper)) {
+                next = 0.5 * (lower + upper);
+            }
+            if (std::abs(next - x) <= 1e-15 * (m_upper - m_lower)) {
+                return next;
+            }
+            x = next;
+        }
+        return x;
+    }
+
+    // Cells between the lower bound and x, and per unit length at x
+    double Cells(double const x) const {
+        double cells = x - m_lower;
+        for (double const point : m_points) {
+            cells += m_bump * (std::erf((x - point) / m_width) - std::erf((m_lower - point) / m_width));
+        }
+        return cells / m_spacing;
+    }
+
+    double Density(double const x) const {
+        double density = 1.0;
+        for (double const point : m_points) {
+            double const distance = (x - point) / m_width;
+            density += m_peak * std::exp(-distance * distance);
+        }
+        return density / m_spacing;
+    }
+
+    std::vector<double> const& m_nodes;
+    std::vector<double> const& m_points;
+    double const m_lower;
+    double const m_upper;
+    double const m_spacing;
+    double const m_width;
+    double const m_peak; // extra density at a point, in cells per spacing
+    double const m_bump; // half the length of uniform cells a point adds over the whole line
+    bool const m_periodic;
+    std::size_t m_numCells = 0;
+    double m_cellsPerFace = 1.0;
+};
+
+} // namespace
+
+Cartesian1DGrid::Cartesian1DGrid(Profile const& profile, std::size_t const part, std::size_t const numParts) {
+    std::size_t const numGlobalCells = DomainFaces(profile).NumCells();
+    if (numParts == 0 || part >= numParts || numParts > numGlobalCells) {
+        throw Error::INVALID_DECOMPOSITION;
+    }
+    std::size_t const firstCell = part * numGlobalCells / numParts;
+    Build(profile, firstCell, (part + 1) * numGlobalCells / numParts - firstCell);
+}
+
+std::unique_ptr<Cartesian1DGrid> Cartesian1DGrid::CellRange(Profile const& profile, std::size_t const firstCell,
+                                                            std::size_t const numCells) {
+    std::unique_ptr<Cartesian1DGrid> grid(new Cartesian1DGrid());
+    grid->Build(profile, firstCell, numCells);
+    return grid;
+}
+
+void Cartesian1DGrid::Build(Profile const& profile, std::size_t const firstCell, std::size_t const numCells) {
     auto& bounds = profile.m_gridBoundsOption;
+    DomainFaces const faces(profile);
     m_cellSize = profile.m_gridSpacingsOption;
-    m_numCells = (bounds[1] - bounds[0]) / m_cellSize[0];
+    m_numGlobalCells = faces.NumCells();
+    m_uniform = !faces.Stretched();
+
+    // A part is laid out exactly like the whole domain, shifted to start at its first cell
+    m_firstCell = firstCell;
+    m_numCells = numCells;
+    double const lowerBound = m_firstCell == 0 ? bounds[0] : bounds[0] + m_firstCell * m_cellSize[0];
+    double const upperBound = m_firstCell + m_numCells == m_numGlobalCells
+        ? bounds[1] : bounds[0] + (m_firstCell + m_numCells) * m_cellSize[0];
     m_numFaces = m_numCells + 1;
     m_numBoundaries = 2;
+    m_numGhostLayers = profile.m_numGhostLayersOption;
+    m_numGhostCells = m_numBoundaries * m_numGhostLayers;
 
-    // Internal nodes correspond to the cell centers
-    for (std::size_t i = 0; i < m_numCells; ++i) {
-        m_nodes.push_back({bounds[0] + (i + 0.5) * m_cellSize[0], 0.0, 0.0});
+    if (m_numGhostLayers < 1 || m_numGhostLayers > m_numCells) {
+        throw Error::INVALID_NUM_GHOST_LAYERS;
     }
-    
-    // External nodes correspond to the ghost cells
-    m_nodes.push_back({bounds[0] - 0.5 * m_cellSize[0], 0.0, 0.0});
-    m_nodes.push_back({bounds[1] + 0.5 * m_cellSize[0], 0.0, 0.0});
 
-    // Each face has a "left" and "right" cell
+    if (m_uniform) {
+        // Internal nodes correspond to the cell centers
+        for (std::size_t i = 0; i < m_numCells; ++i) {
+            m_nodes.push_back({bounds[0] + (m_firstCell + i + 0.5) * m_cellSize[0], 0.0, 0.0});
+        }
+
+        // External nodes correspond to the ghost cells, ordered by layer moving away from the boundary
+        for (std::size_t k = 0; k < m_numGhostLayers; ++k) {
+            m_nodes.push_back({lowerBound - (k + 0.5) * m_cellSize[0], 0.0, 0.0});
+        }
+        for (std::size_t k = 0; k < m_numGhostLayers; ++k) {
+            m_nodes.push_back({upperBound + (k + 0.5) * m_cellSize[0], 0.0, 0.0});
+        }
+        m_cellWidths.assign(m_numCells + m_numGhostCells, m_cellSize[0]);
+    } else {
+        // Cells between the faces of the whole domain, the same for every part of it
+        auto place = [this, &faces](long const j) {
+            long const m = static_cast<long>(m_firstCell) + j;
+            m_nodes.push_back({0.5 * (faces(m) + faces(m + 1)), 0.0, 0.0});
+            m_cellWidths.push_back(faces.Width(m));
+        };
+        long const numCells = static_cast<long>(m_numCells);
+        for (long i = 0; i < numCells; ++i) {
+            place(i);
+        }
+        for (long k = 0; k < static_cast<long>(m_numGhostLayers); ++k) {
+            place(-k - 1);
+        }
+        for (long k = 0; k < static_cast<long>(m_numGhostLayers); ++k) {
+            place(numCells + k);
+        }
+        m_cellSize[0] = *std::min_element(m_cellWidths.begin(), m_cellWidths.begin() + m_numCells);
+    }
+
+    // Maps a signed cell position onto a node index, clamping to the outermost ghost layer
+    long const n = static_cast<long>(m_numCells);
+    long const g = static_cast<long>(m_numGhostLayers);
+    auto nodeIdx = [n, g](long j) -> std::size_t {
+        j = std::clamp(j, -g, n + g - 1);
+        if (j < 0) {
+            return n - j - 1;
+        }
+        if (j >= n) {
+            return n + g + (j - n);
+        }
+        return j;
+    };
+
+    // Each face has a "left" and "right" cell, followed by the next cell outward on each side
     // Boundary faces have an "inner" and "outer" cell
     for (std::size_t i = 0; i < m_numFaces; ++i) {
+        long const j = static_cast<long>(i);
         m_faceIdxs.push_back(i);
-        if (i == 0) {
-            m_faceIdxToCellIdxs[i] = {m_numCells, i, m_numCells, i + 1};
-            m_boundaryIdxs.push_back(i);
-            m_boundaryIdxToCellIdxs[i] = {i, m_numCells};
-        } else if (i == 1) {
-            m_faceIdxToCellIdxs[i] = {i - 1, i, m_numCells, i + 1};
-        } else if (i == m_numFaces - 2) {
-            m_faceIdxToCellIdxs[i] = {i - 1, i, i - 2, m_numCells + 1};
-        } else if (i == m_numFaces - 1) {
-            m_faceIdxToCellIdxs[i] = {i - 1, m_numCells + 1, i - 2, m_numCells + 1};
-            m_boundaryIdxs.push_back(i);
-            m_boundaryIdxToCellIdxs[i] = {i - 1, m_numCells + 1};
-        } else {
-            m_faceIdxToCellIdxs[i] = {i - 1, i, i - 2, i + 1};
+        m_faceIdxToCellIdxs[i] = {nodeIdx(j - 1), nodeIdx(j), nodeIdx(j - 2), nodeIdx(j + 1)};
+    }
+
+    // Each boundary pairs the interior cell k away from it with ghost layer k:
+    // {inner_0, outer_0, inner_1, outer_1, ...}
+    // The periodic pairing instead takes the inner cell from the opposite end of the domain
+    std::size_t const boundaryFaces[] = {0, m_numFaces - 1};
+    for (std::size_t b = 0; b < m_numBoundaries; ++b) {
+        std::size_t const faceIdx = boundaryFaces[b];
+        m_boundaryIdxs.push_back(faceIdx);
+        for (long k = 0; k < g; ++k) {
+            std::size_t const outer = b == 0 ? nodeIdx(-k - 1) : nodeIdx(n + k);
+            std::size_t const mirror = b == 0 ? nodeIdx(k) : nodeIdx(n - k - 1);
+            std::size_t const periodic = b == 0 ? nodeIdx(n - k - 1) : nodeIdx(k);
+            m_boundaryIdxToCellIdxs[faceIdx].push_back(mirror);
+            m_boundaryIdxToCellIdxs[faceIdx].push_back(outer);
+            m_boundaryIdxToPeriodicCellIdxs[faceIdx].push_back(periodic);
+            m_boundaryIdxToPeriodicCellIdxs[faceIdx].push_back(outer);
         }
     }
 
@@ -2,13 +2,25 @@
 
 #include <grid.hpp>
 
+#include <cstddef>
+#include <memory>
+
 namespace MHD {
 
 class Profile;
 
 class Cartesian1DGrid : public IGrid {
 public:
-    Cartesian1DGrid(Profile const& profile);
+    // The part-th of numParts contiguous, near-equal runs of the cells between the bounds
+    Cartesian1DGrid(Profile const& profile, std::size_t const part = 0, std::size_t const numParts = 1);
+
+    // numCells contiguous cells from firstCell, spaced as in the whole domain and free to run past its upper bound
+    static std::unique_ptr<Cartesian1DGrid> CellRange(Profile const& profile, std::size_t const firstCell,
+                                                      std::size_t const numCells);
+
+private:
+    Cartesian1DGrid() = default;
+    void Build(Profile const& profile, std::size_t const firstCell, std::size_t const numCells);
 };
 
 } // namespace MHD
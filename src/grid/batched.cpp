@@ -0,0 +1,68 @@
+#include <batched.hpp>
+#include <error.hpp>
+#include <grid.hpp>
+
+namespace MHD {
+
+BatchedGrid::BatchedGrid(IGrid const& grid, std::size_t const width) : m_width(width) {
+    if (width == 0) {
+        throw Error::INVALID_GRID_GEOMETRY;
+    }
+
+    m_numCells = grid.NumCells() * width;
+    m_numFaces = grid.NumFaces() * width;
+    m_numBoundaries = grid.NumBoundaries() * width;
+    m_numGhostLayers = grid.NumGhostLayers();
+    m_numGhostCells = (grid.NumNodes() - grid.NumCells()) * width;
+    m_numGlobalCells = m_numCells;
+    m_cellSize = grid.CellSize();
+    m_uniform = grid.IsUniform();
+
+    auto lanes = [width](std::vector<std::size_t> const& idxs, std::size_t const lane) {
+        std::vector<std::size_t> laneIdxs;
+        laneIdxs.reserve(idxs.size());
+        for (std::size_t const idx : idxs) {
+            laneIdxs.push_back(idx * width + lane);
+        }
+        return laneIdxs;
+    };
+    auto interleave = [width, &lanes](std::map<std::size_t, std::vector<std::size_t>> const& source,
+                                      std::map<std::size_t, std::vector<std::size_t>>& target) {
+        for (auto const& [key, idxs] : source) {
+            for (std::size_t lane = 0; lane < width; ++lane) {
+                target[key * width + lane] = lanes(idxs, lane);
+            }
+        }
+    };
+
+    for (auto const& node : grid.Nodes()) {
+        m_nodes.insert(m_nodes.end(), width, node);
+    }
+    for (double const cellWidth : grid.CellWidths()) {
+        m_cellWidths.insert(m_cellWidths.end(), width, cellWidth);
+    }
+    for (std::size_t const faceIdx : grid.FaceIdxs()) {
+        for (std::size_t lane = 0; lane < width; ++lane) {
+            m_faceIdxs.push_back(faceIdx * width + lane);
+        }
+    }
+    for (std::size_t f = 0; f < grid.NumFaces(); ++f) {
+        m_faceAreas.insert(m_faceAreas.end(), width, grid.FaceAreas()[f]);
+        m_faceNormalsX.insert(m_faceNormalsX.end(), width, grid.FaceNormalX()[f]);
+        m_faceNormalsY.insert(m_faceNormalsY.end(), width, grid.FaceNormalY()[f]);
+        m_faceNormalsZ.insert(m_faceNormalsZ.end(), width, grid.FaceNormalZ()[f]);
+    }
+    interleave(grid.FaceIdxToCellIdxs(), m_faceIdxToCellIdxs);
+    interleave(grid.CellIdxToFaceIdxs(), m_cellIdxToFaceIdxs);
+    interleave(grid.BoundaryIdxToCellIdxs(), m_boundaryIdxToCellIdxs);
+    interleave(grid.BoundaryIdxToPeriodicCellIdxs(), m_boundaryIdxToPeriodicCellIdxs);
+
+    // Boundary b of lane l sits at b * width + l, so the partner of boundary b stays at the mirrored position
+    for (std::size_t const boundaryIdx : grid.BoundaryIdxs()) {
+        for (std::size_t lane = 0; lane < width; ++lane) {
+            m_boundaryIdxs.push_back(boundaryIdx * width + lane);
+        }
+    }
+}
+
+} // namespace MHD
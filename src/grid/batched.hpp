@@ -0,0 +1,27 @@
+#pragma once
+
+#include <grid.hpp>
+
+#include <cstddef>
+
+namespace MHD {
+
+/**
+ * Width independent copies of a grid interleaved into one, so a single solver advances a batch of
+ * problems in lock-step. Node n of lane l becomes node n * width + l, and faces and boundaries
+ * likewise, so every field carries the lanes as its innermost dimension: a cell-local kernel
+ * streams all lanes of a cell from one cache line, and a stencil reads its neighbours' lanes
+ * contiguously. Interior nodes still come before ghost nodes, and boundary b * width + l keeps
+ * the partner of the unbatched boundary b for periodic pairing.
+ */
+class BatchedGrid : public IGrid {
+public:
+    BatchedGrid(IGrid const& grid, std::size_t const width);
+
+    std::size_t Width() const { return m_width; }
+
+private:
+    std::size_t m_width;
+};
+
+} // namespace MHD
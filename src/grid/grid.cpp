@@ -7,9 +7,16 @@
 
 namespace MHD {
 
-std::unique_ptr<IGrid> gridFactory(Profile const& profile) {
+std::unique_ptr<IGrid> gridFactory(Profile const& profile, std::size_t const part, std::size_t const numParts) {
     if (Dimension::ONE == profile.m_gridDimensionOption) {
-        return std::make_unique<Cartesian1DGrid>(profile);
+        return std::make_unique<Cartesian1DGrid>(profile, part, numParts);
+    }
+    return nullptr;
+}
+
+std::unique_ptr<IGrid> cellRangeGridFactory(Profile const& profile, std::size_t const firstCell, std::size_t const numCells) {
+    if (Dimension::ONE == profile.m_gridDimensionOption) {
+        return Cartesian1DGrid::CellRange(profile, firstCell, numCells);
     }
     return nullptr;
 }
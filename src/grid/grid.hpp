@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <vector>
@@ -16,10 +17,16 @@ public:
     std::size_t const NumCells() const { return m_numCells; }
     std::size_t const NumFaces() const { return m_numFaces; }
     std::size_t const NumBoundaries() const { return m_numBoundaries; }
-    std::size_t const NumNodes() const { return m_numCells + m_numBoundaries; }
+    std::size_t const NumGhostLayers() const { return m_numGhostLayers; }
+    std::size_t const NumNodes() const { return m_numCells + m_numGhostCells; }
+
+    // Position of this grid's interior cells in the whole domain, which differ for a part of it
+    std::size_t const FirstCell() const { return m_firstCell; }
+    std::size_t const NumGlobalCells() const { return m_numGlobalCells; }
     std::map<std::size_t, std::vector<std::size_t>> const& FaceIdxToCellIdxs() const { return m_faceIdxToCellIdxs; }
     std::map<std::size_t, std::vector<std::size_t>> const& CellIdxToFaceIdxs() const { return m_cellIdxToFaceIdxs; }
     std::map<std::size_t, std::vector<std::size_t>> const& BoundaryIdxToCellIdxs() const { return m_boundaryIdxToCellIdxs; }
+    std::map<std::size_t, std::vector<std::size_t>> const& BoundaryIdxToPeriodicCellIdxs() const { return m_boundaryIdxToPeriodicCellIdxs; }
     std::vector<std::size_t> const& BoundaryIdxs() const { return m_boundaryIdxs; }
     std::vector<std::size_t> const& FaceIdxs() const { return m_faceIdxs; }
     std::vector<double> const& FaceAreas() const { return m_faceAreas; }
@@ -27,16 +34,26 @@ public:
     std::vector<double> const& FaceNormalY() const { return m_faceNormalsY; }
     std::vector<double> const& FaceNormalZ() const { return m_faceNormalsZ; }
 
+    // Spacing in each dimension, which in x is the narrowest cell's width when the grid is stretched
     std::vector<double> const& CellSize() const { return m_cellSize; }
 
+    // Width in x of every node's cell, ghost cells included, all the spacing on a uniform grid
+    std::vector<double> const& CellWidths() const { return m_cellWidths; }
+    bool const IsUniform() const { return m_uniform; }
+
 protected:
     std::vector<std::array<double, 3>> m_nodes;
     std::size_t m_numCells;
     std::size_t m_numFaces;
     std::size_t m_numBoundaries;
+    std::size_t m_numGhostLayers = 1;
+    std::size_t m_numGhostCells;
+    std::size_t m_firstCell = 0;
+    std::size_t m_numGlobalCells = 0;
     std::map<std::size_t, std::vector<std::size_t>> m_faceIdxToCellIdxs;
     std::map<std::size_t, std::vector<std::size_t>> m_cellIdxToFaceIdxs;
     std::map<std::size_t, std::vector<std::size_t>> m_boundaryIdxToCellIdxs;
+    std::map<std::size_t, std::vector<std::size_t>> m_boundaryIdxToPeriodicCellIdxs;
     std::vector<std::size_t> m_boundaryIdxs;
     std::vector<std::size_t> m_faceIdxs;
     std::vector<double> m_faceAreas;
@@ -45,8 +62,14 @@ protected:
     std::vector<double> m_faceNormalsZ;
 
     std::vector<double> m_cellSize;
+    std::vector<double> m_cellWidths;
+    bool m_uniform = true;
 };
 
-std::unique_ptr<IGrid> gridFactory(Profile const& profile);
+// Part part of the domain split into numParts contiguous runs of cells, the whole domain by default
+std::unique_ptr<IGrid> gridFactory(Profile const& profile, std::size_t const part = 0, std::size_t const numParts = 1);
+
+// A window of numCells cells of the domain from firstCell, e.g. one tile of a larger grid with room for its stencils
+std::unique_ptr<IGrid> cellRangeGridFactory(Profile const& profile, std::size_t const firstCell, std::size_t const numCells);
 
 } // namespace MHD
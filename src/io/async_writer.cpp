@@ -0,0 +1,113 @@
+#include <async_writer.hpp>
+#include <error.hpp>
+#include <snapshot.hpp>
+#include <trace.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace MHD {
+
+AsyncSnapshotWriter::AsyncSnapshotWriter(std::size_t const numBuffers) : m_buffers(std::max<std::size_t>(numBuffers, 1)) {
+    for (std::size_t b = 0; b < m_buffers.size(); ++b) {
+        m_freeBuffers.push_back(b);
+    }
+    m_thread = std::thread(&AsyncSnapshotWriter::WriterLoop, this);
+}
+
+AsyncSnapshotWriter::~AsyncSnapshotWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_bufferPending.notify_one();
+    m_thread.join();
+}
+
+void AsyncSnapshotWriter::Submit(std::string const& filename, SnapshotInfo const& info, std::vector<SnapshotField> const& fields) {
+    std::size_t b;
+    {
+        // Back-pressure: wait for the writer to release a staging buffer
+        ScopedTrace trace("WaitForBuffer", "io");
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_bufferFreed.wait(lock, [this] { return !m_freeBuffers.empty(); });
+        b = m_freeBuffers.front();
+        m_freeBuffers.pop_front();
+    }
+
+    ScopedTrace trace("StageSnapshot", "io", fields.size() * info.numNodes);
+
+    // Staging buffers keep their capacity, so steady-state submits do not allocate
+    StagingBuffer& buffer = m_buffers[b];
+    buffer.filename = filename;
+    buffer.info = info;
+    buffer.fieldNames.resize(fields.size());
+    buffer.data.resize(fields.size() * info.numNodes);
+    for (std::size_t f = 0; f < fields.size(); ++f) {
+        buffer.fieldNames[f] = fields[f].name;
+        std::copy(fields[f].data, fields[f].data + info.numNodes, buffer.data.begin() + f * info.numNodes);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingBuffers.push_back(b);
+    }
+    m_bufferPending.notify_one();
+}
+
+void AsyncSnapshotWriter::Flush() {
+    ScopedTrace trace("FlushSnapshots", "io");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_bufferFreed.wait(lock, [this] { return m_pendingBuffers.empty() && m_numWriting == 0; });
+}
+
+std::size_t AsyncSnapshotWriter::NumFailedWrites() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numFailedWrites;
+}
+
+void AsyncSnapshotWriter::WriterLoop() {
+    Tracer::SetThreadName("snapshot writer");
+    std::vector<SnapshotField> fields;
+    while (true) {
+        std::size_t b;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_bufferPending.wait(lock, [this] { return m_stop || !m_pendingBuffers.empty(); });
+            if (m_pendingBuffers.empty()) {
+                return;
+            }
+            b = m_pendingBuffers.front();
+            m_pendingBuffers.pop_front();
+            ++m_numWriting;
+        }
+
+        StagingBuffer const& buffer = m_buffers[b];
+        fields.clear();
+        for (std::size_t f = 0; f < buffer.fieldNames.size(); ++f) {
+            fields.push_back({buffer.fieldNames[f], buffer.data.data() + f * buffer.info.numNodes});
+        }
+
+        bool failed = false;
+        try {
+            writeSnapshot(buffer.filename, buffer.info, fields);
+        } catch (Error const&) {
+            std::cerr << "Unable to write file: " << buffer.filename << std::endl;
+            failed = true;
+        } catch (...) {
+            // Nothing may escape the writer thread, so out of memory and the like fail this write too
+            std::cerr << "Unable to write file: " << buffer.filename << std::endl;
+            failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeBuffers.push_back(b);
+            --m_numWriting;
+            m_numFailedWrites += failed;
+        }
+        m_bufferFreed.notify_all();
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <snapshot.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Writes snapshots on a background thread. Submit copies the fields into a free staging buffer
+ * and returns, so the caller can keep stepping while the previous snapshot is serialized. When
+ * every staging buffer is still waiting to be written, Submit blocks until one is released.
+ */
+class AsyncSnapshotWriter {
+public:
+    AsyncSnapshotWriter(std::size_t const numBuffers = 2);
+    ~AsyncSnapshotWriter();
+
+    void Submit(std::string const& filename, SnapshotInfo const& info, std::vector<SnapshotField> const& fields);
+
+    // Blocks until every submitted snapshot has been written
+    void Flush();
+
+    std::size_t NumFailedWrites() const;
+
+private:
+    struct StagingBuffer {
+        std::string filename;
+        SnapshotInfo info;
+        std::vector<std::string> fieldNames;
+        std::vector<double> data;
+    };
+
+    void WriterLoop();
+
+    std::vector<StagingBuffer> m_buffers;
+    std::deque<std::size_t> m_freeBuffers;
+    std::deque<std::size_t> m_pendingBuffers;
+    std::size_t m_numWriting = 0;
+    std::size_t m_numFailedWrites = 0;
+    bool m_stop = false;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_bufferFreed;
+    std::condition_variable m_bufferPending;
+    std::thread m_thread;
+};
+
+} // namespace MHD
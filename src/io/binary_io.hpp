@@ -0,0 +1,75 @@
+#pragma once
+
+#include <error.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace MHD {
+
+bool constexpr IS_LITTLE_ENDIAN = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+// Largest single write, keeps each syscall well inside the limits of every platform
+std::size_t constexpr MAX_WRITE_SIZE = std::size_t(1) << 30;
+
+template <typename T> inline void putLittleEndian(std::vector<char>& buffer, std::size_t const offset, T const value) {
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    for (std::size_t b = 0; b < sizeof(T); ++b) {
+        buffer[offset + b] = static_cast<char>((bits >> (8 * b)) & 0xff);
+    }
+}
+
+template <typename T> inline T getLittleEndian(char const* buffer, std::size_t const offset) {
+    std::uint64_t bits = 0;
+    for (std::size_t b = 0; b < sizeof(T); ++b) {
+        bits |= std::uint64_t(static_cast<unsigned char>(buffer[offset + b])) << (8 * b);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+template <typename T> inline void byteSwapInPlace(T* data, std::size_t const n) {
+    static_assert(sizeof(T) == sizeof(std::uint64_t));
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &data[i], sizeof(bits));
+        bits = __builtin_bswap64(bits);
+        std::memcpy(&data[i], &bits, sizeof(bits));
+    }
+}
+
+inline std::size_t alignUp(std::size_t const size, std::size_t const alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+inline void pwriteAll(int const fd, char const* data, std::size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t const written = ::pwrite(fd, data, std::min(size, MAX_WRITE_SIZE), offset);
+        if (written <= 0) {
+            throw Error::FILE_IO;
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+// Writes an array of 64-bit values in little-endian order regardless of the host
+template <typename T> inline void pwriteLittleEndian(int const fd, T const* data, std::size_t const n, off_t const offset) {
+    if (IS_LITTLE_ENDIAN) {
+        pwriteAll(fd, reinterpret_cast<char const*>(data), n * sizeof(T), offset);
+    } else {
+        std::vector<T> swapped(data, data + n);
+        byteSwapInPlace(swapped.data(), swapped.size());
+        pwriteAll(fd, reinterpret_cast<char const*>(swapped.data()), n * sizeof(T), offset);
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,202 @@
+#include <binary_io.hpp>
+#include <checkpoint.hpp>
+#include <compression.hpp>
+#include <error.hpp>
+#include <trace.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace MHD {
+
+namespace {
+
+char constexpr CHECKPOINT_MAGIC[8] = "MHDCKPT";
+std::size_t constexpr CHECKPOINT_FIXED_HEADER_SIZE = 64;
+std::size_t constexpr CHECKPOINT_FIELD_ENTRY_SIZE = 16;
+std::size_t constexpr CHECKPOINT_ALIGNMENT = 4096;
+
+} // namespace
+
+void writeCheckpoint(std::string const& filename, CheckpointInfo const& info, std::vector<SnapshotField> const& fields) {
+    ScopedTrace trace("WriteCheckpoint", "io", fields.size() * info.numNodes);
+    std::size_t const numFields = fields.size();
+    std::size_t const dataOffset = alignUp(CHECKPOINT_FIXED_HEADER_SIZE +
+                                           numFields * (SNAPSHOT_FIELD_NAME_SIZE + CHECKPOINT_FIELD_ENTRY_SIZE),
+                                           CHECKPOINT_ALIGNMENT);
+    bool const compressed = CompressionOption::NONE != info.compression;
+
+    // Every field starts on a page boundary so an uncompressed one can be used straight from the mapping
+    std::vector<std::vector<std::uint64_t>> compressedFields(compressed ? numFields : 0);
+    std::vector<std::size_t> fieldOffsets(numFields);
+    std::vector<std::size_t> fieldBytes(numFields);
+    std::size_t offset = dataOffset;
+    for (std::size_t f = 0; f < numFields; ++f) {
+        if (compressed) {
+            compressField(fields[f].data, info.numNodes, compressedFields[f]);
+            fieldBytes[f] = compressedFields[f].size() * sizeof(std::uint64_t);
+        } else {
+            fieldBytes[f] = info.numNodes * sizeof(double);
+        }
+        fieldOffsets[f] = offset;
+        offset += alignUp(fieldBytes[f], CHECKPOINT_ALIGNMENT);
+    }
+
+    std::vector<char> header(dataOffset, 0);
+    std::memcpy(header.data(), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    putLittleEndian<std::uint32_t>(header, 8, CHECKPOINT_VERSION);
+    putLittleEndian<std::uint32_t>(header, 12, dataOffset);
+    putLittleEndian<std::uint64_t>(header, 16, info.step);
+    putLittleEndian<double>(header, 24, info.time);
+    putLittleEndian<std::uint64_t>(header, 32, info.output);
+    putLittleEndian<std::uint64_t>(header, 40, info.hash);
+    putLittleEndian<std::uint64_t>(header, 48, info.numNodes);
+    putLittleEndian<std::uint32_t>(header, 56, numFields);
+    putLittleEndian<std::uint32_t>(header, 60, static_cast<std::uint32_t>(info.compression));
+    std::size_t const tableOffset = CHECKPOINT_FIXED_HEADER_SIZE + numFields * SNAPSHOT_FIELD_NAME_SIZE;
+    for (std::size_t f = 0; f < numFields; ++f) {
+        std::string const& name = fields[f].name;
+        std::memcpy(&header[CHECKPOINT_FIXED_HEADER_SIZE + f * SNAPSHOT_FIELD_NAME_SIZE], name.data(),
+                    std::min(name.size(), SNAPSHOT_FIELD_NAME_SIZE - 1));
+        putLittleEndian<std::uint64_t>(header, tableOffset + f * CHECKPOINT_FIELD_ENTRY_SIZE, fieldOffsets[f]);
+        putLittleEndian<std::uint64_t>(header, tableOffset + f * CHECKPOINT_FIELD_ENTRY_SIZE + 8, fieldBytes[f]);
+    }
+
+    std::string const tmpFilename = filename + ".tmp";
+    int const fd = ::open(tmpFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw Error::FILE_IO;
+    }
+
+    try {
+        pwriteAll(fd, header.data(), header.size(), 0);
+        for (std::size_t f = 0; f < numFields; ++f) {
+            if (compressed) {
+                pwriteLittleEndian(fd, compressedFields[f].data(), compressedFields[f].size(), fieldOffsets[f]);
+            } else {
+                pwriteLittleEndian(fd, fields[f].data, info.numNodes, fieldOffsets[f]);
+            }
+        }
+        // Extend the file over the padding of the last array so every mapping stays in bounds
+        if (::ftruncate(fd, offset) != 0 || ::fsync(fd) != 0) {
+            throw Error::FILE_IO;
+        }
+    } catch (Error const&) {
+        ::close(fd);
+        throw;
+    }
+
+    if (::close(fd) != 0 || std::rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+        throw Error::FILE_IO;
+    }
+}
+
+MappedCheckpoint::MappedCheckpoint(std::string const& filename) {
+    if (!IS_LITTLE_ENDIAN) {
+        // Adopting the arrays in place relies on the file and host byte order agreeing
+        throw Error::INVALID_CHECKPOINT;
+    }
+
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw Error::FILE_IO;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < CHECKPOINT_FIXED_HEADER_SIZE) {
+        ::close(fd);
+        throw Error::INVALID_CHECKPOINT;
+    }
+
+    m_mappingSize = st.st_size;
+    m_mapping = ::mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == m_mapping) {
+        m_mapping = nullptr;
+        throw Error::FILE_IO;
+    }
+    ::madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+
+    char const* base = static_cast<char const*>(m_mapping);
+    try {
+        std::uint32_t const version = getLittleEndian<std::uint32_t>(base, 8);
+        if (std::memcmp(base, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || version < 1 || version > CHECKPOINT_VERSION) {
+            throw Error::INVALID_CHECKPOINT;
+        }
+
+        std::size_t const dataOffset = getLittleEndian<std::uint32_t>(base, 12);
+        m_info.step = getLittleEndian<std::uint64_t>(base, 16);
+        m_info.time = getLittleEndian<double>(base, 24);
+        m_info.output = getLittleEndian<std::uint64_t>(base, 32);
+        m_info.hash = getLittleEndian<std::uint64_t>(base, 40);
+        m_info.numNodes = getLittleEndian<std::uint64_t>(base, 48);
+        std::size_t const numFields = getLittleEndian<std::uint32_t>(base, 56);
+        if (version > 1) {
+            m_info.compression = static_cast<CompressionOption>(getLittleEndian<std::uint32_t>(base, 60));
+        }
+
+        std::size_t const tableSize = version == 1 ? 0 : numFields * CHECKPOINT_FIELD_ENTRY_SIZE;
+        if (dataOffset < CHECKPOINT_FIXED_HEADER_SIZE + numFields * SNAPSHOT_FIELD_NAME_SIZE + tableSize ||
+            dataOffset > m_mappingSize) {
+            throw Error::INVALID_CHECKPOINT;
+        }
+
+        bool const compressed = CompressionOption::NONE != m_info.compression;
+        std::size_t const tableOffset = CHECKPOINT_FIXED_HEADER_SIZE + numFields * SNAPSHOT_FIELD_NAME_SIZE;
+        for (std::size_t f = 0; f < numFields; ++f) {
+            char const* name = base + CHECKPOINT_FIXED_HEADER_SIZE + f * SNAPSHOT_FIELD_NAME_SIZE;
+            m_fieldNames.emplace_back(name, strnlen(name, SNAPSHOT_FIELD_NAME_SIZE));
+
+            std::size_t fieldOffset = dataOffset + f * alignUp(m_info.numNodes * sizeof(double), CHECKPOINT_ALIGNMENT);
+            std::size_t fieldBytes = m_info.numNodes * sizeof(double);
+            if (version > 1) {
+                fieldOffset = getLittleEndian<std::uint64_t>(base, tableOffset + f * CHECKPOINT_FIELD_ENTRY_SIZE);
+                fieldBytes = getLittleEndian<std::uint64_t>(base, tableOffset + f * CHECKPOINT_FIELD_ENTRY_SIZE + 8);
+            }
+            if (fieldOffset + fieldBytes > m_mappingSize) {
+                throw Error::INVALID_CHECKPOINT;
+            }
+
+            if (compressed) {
+                std::uint64_t const* words = reinterpret_cast<std::uint64_t const*>(base + fieldOffset);
+                std::size_t const numWords = fieldBytes / sizeof(std::uint64_t);
+                if (!isValidCompressedField(words, numWords, m_info.numNodes)) {
+                    throw Error::INVALID_CHECKPOINT;
+                }
+                m_decodedFields.emplace_back(m_info.numNodes);
+                decompressField(words, m_info.numNodes, m_decodedFields.back().data());
+                m_fields.push_back(m_decodedFields.back().data());
+            } else {
+                if (fieldBytes != m_info.numNodes * sizeof(double)) {
+                    throw Error::INVALID_CHECKPOINT;
+                }
+                m_fields.push_back(reinterpret_cast<double const*>(base + fieldOffset));
+            }
+        }
+    } catch (Error const&) {
+        ::munmap(m_mapping, m_mappingSize);
+        throw;
+    }
+}
+
+MappedCheckpoint::~MappedCheckpoint() {
+    if (m_mapping) {
+        ::munmap(m_mapping, m_mappingSize);
+    }
+}
+
+double const* MappedCheckpoint::Field(std::string const& name) const {
+    for (std::size_t f = 0; f < m_fieldNames.size(); ++f) {
+        if (m_fieldNames[f] == name) {
+            return m_fields[f];
+        }
+    }
+    throw Error::INVALID_CHECKPOINT;
+}
+
+} // namespace MHD
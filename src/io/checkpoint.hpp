@@ -0,0 +1,71 @@
+#pragma once
+
+#include <snapshot.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Checkpoint layout (all values little-endian):
+ *   char[8]   magic "MHDCKPT"
+ *   uint32    format version
+ *   uint32    header size in bytes, a multiple of the page size
+ *   uint64    time step
+ *   float64   simulation time
+ *   uint64    number of snapshots written so far
+ *   uint64    hash of the profile and grid the state belongs to
+ *   uint64    number of nodes (cells plus ghost cells)
+ *   uint32    number of fields
+ *   uint32    compression (CompressionOption)
+ *   char[16]  name of each field
+ *   uint64[2] byte offset and byte size of each field
+ * followed by one page-aligned array per field, in header order. Uncompressed arrays are
+ * float64[numNodes], compressed arrays use the layout in compression.hpp.
+ *
+ * Version 1 files have no field table and are never compressed.
+ */
+std::uint32_t constexpr CHECKPOINT_VERSION = 2;
+
+struct CheckpointInfo {
+    double time = 0.0;
+    std::size_t step = 0;
+    std::size_t output = 0;
+    std::uint64_t hash = 0;
+    std::size_t numNodes = 0;
+    CompressionOption compression = CompressionOption::NONE;
+};
+
+// Writes to a temporary file first and renames it, so a preempted write never clobbers the last good checkpoint
+void writeCheckpoint(std::string const& filename, CheckpointInfo const& info, std::vector<SnapshotField> const& fields);
+
+/**
+ * Read-only memory mapping of a checkpoint. Uncompressed field arrays are used in place from the
+ * page cache, nothing is parsed beyond the header. Compressed fields are decoded from the mapping
+ * into buffers owned by this object.
+ */
+class MappedCheckpoint {
+public:
+    MappedCheckpoint(std::string const& filename);
+    ~MappedCheckpoint();
+
+    MappedCheckpoint(MappedCheckpoint const&) = delete;
+    MappedCheckpoint& operator=(MappedCheckpoint const&) = delete;
+
+    CheckpointInfo const& Info() const { return m_info; }
+    std::vector<std::string> const& FieldNames() const { return m_fieldNames; }
+    double const* Field(std::string const& name) const;
+
+private:
+    CheckpointInfo m_info;
+    std::vector<std::string> m_fieldNames;
+    std::vector<double const*> m_fields;
+    std::vector<std::vector<double>> m_decodedFields;
+    void* m_mapping = nullptr;
+    std::size_t m_mappingSize = 0;
+};
+
+} // namespace MHD
@@ -0,0 +1,161 @@
+#include <compression.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace MHD {
+
+namespace {
+
+std::size_t constexpr BITS_PER_WORD = 64;
+
+// Maps the bit pattern of a double onto an unsigned integer that increases monotonically with its value
+std::uint64_t toOrdered(double const value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits >> 63 ? ~bits : bits | (std::uint64_t(1) << 63);
+}
+
+double fromOrdered(std::uint64_t const ordered) {
+    std::uint64_t const bits = ordered >> 63 ? ordered & ~(std::uint64_t(1) << 63) : ~ordered;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Linear extrapolation from the two previous values, in wrapping integer arithmetic so it inverts exactly
+std::uint64_t predict(std::uint64_t const* ordered, std::size_t const i) {
+    return i < 2 ? ordered[i - 1] : 2 * ordered[i - 1] - ordered[i - 2];
+}
+
+std::uint64_t zigzag(std::uint64_t const delta) {
+    return (delta << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(delta) >> 63);
+}
+
+std::uint64_t unzigzag(std::uint64_t const code) {
+    return (code >> 1) ^ (~(code & 1) + 1);
+}
+
+void encodeBlock(double const* values, std::size_t const n, std::vector<std::uint64_t>& words) {
+    std::uint64_t ordered[COMPRESSION_BLOCK_SIZE];
+    for (std::size_t i = 0; i < n; ++i) {
+        ordered[i] = toOrdered(values[i]);
+    }
+
+    // The first value is stored verbatim and seeds the predictor
+    std::uint64_t residuals[COMPRESSION_BLOCK_SIZE];
+    residuals[0] = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        residuals[i] = zigzag(ordered[i] - predict(ordered, i));
+    }
+
+    words.push_back(ordered[0]);
+
+    // Each group of 64 residuals is transposed into bit planes and only its non-empty planes are kept
+    for (std::size_t begin = 0; begin < n; begin += BITS_PER_WORD) {
+        std::size_t const end = std::min(n, begin + BITS_PER_WORD);
+        std::uint64_t planeMask = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            planeMask |= residuals[i];
+        }
+        words.push_back(planeMask);
+        for (int plane = BITS_PER_WORD - 1; plane >= 0; --plane) {
+            if (!((planeMask >> plane) & 1)) {
+                continue;
+            }
+            std::uint64_t word = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                word |= ((residuals[i] >> plane) & 1) << (i - begin);
+            }
+            words.push_back(word);
+        }
+    }
+}
+
+void decodeBlock(std::uint64_t const* words, std::size_t const n, double* values) {
+    std::uint64_t residuals[COMPRESSION_BLOCK_SIZE] = {};
+    std::uint64_t ordered[COMPRESSION_BLOCK_SIZE];
+    ordered[0] = *words++;
+    for (std::size_t begin = 0; begin < n; begin += BITS_PER_WORD) {
+        std::size_t const end = std::min(n, begin + BITS_PER_WORD);
+        std::uint64_t const planeMask = *words++;
+        for (int plane = BITS_PER_WORD - 1; plane >= 0; --plane) {
+            if (!((planeMask >> plane) & 1)) {
+                continue;
+            }
+            std::uint64_t const word = *words++;
+            for (std::size_t i = begin; i < end; ++i) {
+                residuals[i] |= ((word >> (i - begin)) & 1) << plane;
+            }
+        }
+    }
+
+    values[0] = fromOrdered(ordered[0]);
+    for (std::size_t i = 1; i < n; ++i) {
+        ordered[i] = predict(ordered, i) + unzigzag(residuals[i]);
+        values[i] = fromOrdered(ordered[i]);
+    }
+}
+
+} // namespace
+
+std::size_t numCompressionBlocks(std::size_t const n) {
+    return (n + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE;
+}
+
+bool isValidCompressedField(std::uint64_t const* words, std::size_t const numWords, std::size_t const n) {
+    std::size_t const numBlocks = numCompressionBlocks(n);
+    if (numWords < numBlocks + 1) {
+        return false;
+    }
+
+    std::uint64_t const* data = words + numBlocks + 1;
+    std::size_t const dataWords = numWords - numBlocks - 1;
+    for (std::size_t b = 0; b < numBlocks; ++b) {
+        if (words[b] > words[b + 1] || words[b + 1] > dataWords) {
+            return false;
+        }
+
+        // Walk the group masks to check the block holds exactly the planes they name
+        std::size_t const count = std::min(COMPRESSION_BLOCK_SIZE, n - b * COMPRESSION_BLOCK_SIZE);
+        std::size_t w = words[b] + 1;
+        for (std::size_t begin = 0; begin < count; begin += BITS_PER_WORD) {
+            if (w >= words[b + 1]) {
+                return false;
+            }
+            w += 1 + __builtin_popcountll(data[w]);
+        }
+        if (w != words[b + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void compressField(double const* values, std::size_t const n, std::vector<std::uint64_t>& words) {
+    std::size_t const numBlocks = numCompressionBlocks(n);
+    words.assign(numBlocks + 1, 0);
+
+    // Blocks share nothing, each could equally be encoded on its own thread into its own buffer
+    std::size_t const tableSize = numBlocks + 1;
+    for (std::size_t b = 0; b < numBlocks; ++b) {
+        words[b] = words.size() - tableSize;
+        std::size_t const begin = b * COMPRESSION_BLOCK_SIZE;
+        encodeBlock(values + begin, std::min(COMPRESSION_BLOCK_SIZE, n - begin), words);
+    }
+    words[numBlocks] = words.size() - tableSize;
+}
+
+void decompressBlock(std::uint64_t const* words, std::size_t const n, std::size_t const block, double* values) {
+    std::size_t const tableSize = numCompressionBlocks(n) + 1;
+    std::size_t const begin = block * COMPRESSION_BLOCK_SIZE;
+    decodeBlock(words + tableSize + words[block], std::min(COMPRESSION_BLOCK_SIZE, n - begin), values);
+}
+
+void decompressField(std::uint64_t const* words, std::size_t const n, double* values) {
+    for (std::size_t b = 0; b < numCompressionBlocks(n); ++b) {
+        decompressBlock(words, n, b, values + b * COMPRESSION_BLOCK_SIZE);
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Lossless compression of float64 arrays for snapshots and checkpoints.
+ *
+ * The array is cut into blocks of COMPRESSION_BLOCK_SIZE values that are coded independently, so
+ * blocks can be encoded in parallel and any one of them decoded on its own. Each value is mapped onto
+ * an integer that orders like the value itself and predicted by linear extrapolation from the two
+ * before it (the first value of a block is stored as is, the second is predicted by the first).
+ * Neighbouring values of a smooth field are nearly collinear, so the zigzag-coded prediction
+ * residuals are small and their high-order bits are zero. Each group of 64 residuals is transposed
+ * into 64 bit planes and only the planes holding a set bit are stored, after a mask naming them, so
+ * a shock only costs bits in the group it falls in.
+ *
+ * Compressed field layout, in 64-bit words:
+ *   numBlocks + 1 block offsets, relative to the first block
+ *   per block: first value as an ordered integer, then per group of 64 values a plane mask followed
+ *              by one word for each plane in the mask, most significant first
+ */
+std::size_t constexpr COMPRESSION_BLOCK_SIZE = 1024;
+
+std::size_t numCompressionBlocks(std::size_t const n);
+
+// Checks that the block table of a compressed field is consistent with its size
+bool isValidCompressedField(std::uint64_t const* words, std::size_t const numWords, std::size_t const n);
+
+void compressField(double const* values, std::size_t const n, std::vector<std::uint64_t>& words);
+
+void decompressField(std::uint64_t const* words, std::size_t const n, double* values);
+
+// Decodes the values of a single block into values[0, min(COMPRESSION_BLOCK_SIZE, n - block * COMPRESSION_BLOCK_SIZE))
+void decompressBlock(std::uint64_t const* words, std::size_t const n, std::size_t const block, double* values);
+
+} // namespace MHD
@@ -0,0 +1,222 @@
+#include <binary_io.hpp>
+#include <compression.hpp>
+#include <error.hpp>
+#include <snapshot.hpp>
+#include <trace.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace MHD {
+
+namespace {
+
+char constexpr SNAPSHOT_MAGIC[8] = "MHDSNAP";
+std::size_t constexpr SNAPSHOT_FIXED_HEADER_SIZE = 64;
+std::size_t constexpr SNAPSHOT_V1_FIXED_HEADER_SIZE = 56;
+std::size_t constexpr SNAPSHOT_FIELD_ENTRY_SIZE = 16;
+std::size_t constexpr SNAPSHOT_ALIGNMENT = 64;
+
+std::size_t headerSize(std::size_t const numFields) {
+    return alignUp(SNAPSHOT_FIXED_HEADER_SIZE + numFields * (SNAPSHOT_FIELD_NAME_SIZE + SNAPSHOT_FIELD_ENTRY_SIZE),
+                   SNAPSHOT_ALIGNMENT);
+}
+
+} // namespace
+
+std::vector<double> const& Snapshot::Field(std::string const& name) const {
+    for (std::size_t f = 0; f < fieldNames.size(); ++f) {
+        if (fieldNames[f] == name) {
+            return fields[f];
+        }
+    }
+    throw Error::INVALID_SNAPSHOT;
+}
+
+void writeSnapshot(std::string const& filename, SnapshotInfo const& info, std::vector<SnapshotField> const& fields) {
+    ScopedTrace trace("WriteSnapshot", "io", fields.size() * info.numNodes);
+    std::size_t const numFields = fields.size();
+    std::size_t const dataOffset = headerSize(numFields);
+    bool const compressed = CompressionOption::NONE != info.compression;
+
+    // Compressed fields are encoded up front so their sizes can go in the header
+    std::vector<std::vector<std::uint64_t>> compressedFields(compressed ? numFields : 0);
+    std::vector<std::size_t> fieldOffsets(numFields);
+    std::vector<std::size_t> fieldBytes(numFields);
+    std::size_t offset = dataOffset;
+    for (std::size_t f = 0; f < numFields; ++f) {
+        if (compressed) {
+            compressField(fields[f].data, info.numNodes, compressedFields[f]);
+            fieldBytes[f] = compressedFields[f].size() * sizeof(std::uint64_t);
+        } else {
+            fieldBytes[f] = info.numNodes * sizeof(double);
+        }
+        fieldOffsets[f] = offset;
+        offset += fieldBytes[f];
+    }
+
+    std::vector<char> header(dataOffset, 0);
+    std::memcpy(header.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    putLittleEndian<std::uint32_t>(header, 8, SNAPSHOT_VERSION);
+    putLittleEndian<std::uint32_t>(header, 12, dataOffset);
+    putLittleEndian<std::uint64_t>(header, 16, info.step);
+    putLittleEndian<double>(header, 24, info.time);
+    putLittleEndian<std::uint32_t>(header, 32, info.dimension);
+    putLittleEndian<std::uint32_t>(header, 36, numFields);
+    putLittleEndian<std::uint64_t>(header, 40, info.numCells);
+    putLittleEndian<std::uint64_t>(header, 48, info.numNodes);
+    putLittleEndian<std::uint32_t>(header, 56, static_cast<std::uint32_t>(info.compression));
+    std::size_t const tableOffset = SNAPSHOT_FIXED_HEADER_SIZE + numFields * SNAPSHOT_FIELD_NAME_SIZE;
+    for (std::size_t f = 0; f < numFields; ++f) {
+        std::string const& name = fields[f].name;
+        std::memcpy(&header[SNAPSHOT_FIXED_HEADER_SIZE + f * SNAPSHOT_FIELD_NAME_SIZE], name.data(),
+                    std::min(name.size(), SNAPSHOT_FIELD_NAME_SIZE - 1));
+        putLittleEndian<std::uint64_t>(header, tableOffset + f * SNAPSHOT_FIELD_ENTRY_SIZE, fieldOffsets[f]);
+        putLittleEndian<std::uint64_t>(header, tableOffset + f * SNAPSHOT_FIELD_ENTRY_SIZE + 8, fieldBytes[f]);
+    }
+
+    int const fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw Error::FILE_IO;
+    }
+
+    try {
+        pwriteAll(fd, header.data(), header.size(), 0);
+
+        // Uncompressed arrays go straight from the caller's memory to the file
+        for (std::size_t f = 0; f < numFields; ++f) {
+            if (compressed) {
+                pwriteLittleEndian(fd, compressedFields[f].data(), compressedFields[f].size(), fieldOffsets[f]);
+            } else {
+                pwriteLittleEndian(fd, fields[f].data, info.numNodes, fieldOffsets[f]);
+            }
+        }
+    } catch (Error const&) {
+        ::close(fd);
+        throw;
+    }
+
+    if (::close(fd) != 0) {
+        throw Error::FILE_IO;
+    }
+}
+
+Snapshot readSnapshot(std::string const& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+
+    std::vector<char> header(SNAPSHOT_V1_FIXED_HEADER_SIZE);
+    if (!file.read(header.data(), header.size()) || std::memcmp(header.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw Error::INVALID_SNAPSHOT;
+    }
+    std::uint32_t const version = getLittleEndian<std::uint32_t>(header.data(), 8);
+    if (version < 1 || version > SNAPSHOT_VERSION) {
+        throw Error::INVALID_SNAPSHOT;
+    }
+
+    Snapshot snapshot;
+    std::size_t const dataOffset = getLittleEndian<std::uint32_t>(header.data(), 12);
+    snapshot.info.step = getLittleEndian<std::uint64_t>(header.data(), 16);
+    snapshot.info.time = getLittleEndian<double>(header.data(), 24);
+    snapshot.info.dimension = getLittleEndian<std::uint32_t>(header.data(), 32);
+    std::size_t const numFields = getLittleEndian<std::uint32_t>(header.data(), 36);
+    snapshot.info.numCells = getLittleEndian<std::uint64_t>(header.data(), 40);
+    snapshot.info.numNodes = getLittleEndian<std::uint64_t>(header.data(), 48);
+
+    std::size_t const fixedHeaderSize = version == 1 ? SNAPSHOT_V1_FIXED_HEADER_SIZE : SNAPSHOT_FIXED_HEADER_SIZE;
+    std::size_t const tableSize = version == 1 ? 0 : numFields * SNAPSHOT_FIELD_ENTRY_SIZE;
+    if (dataOffset < fixedHeaderSize + numFields * SNAPSHOT_FIELD_NAME_SIZE + tableSize) {
+        throw Error::INVALID_SNAPSHOT;
+    }
+
+    header.resize(dataOffset);
+    if (!file.read(header.data() + SNAPSHOT_V1_FIXED_HEADER_SIZE, dataOffset - SNAPSHOT_V1_FIXED_HEADER_SIZE)) {
+        throw Error::INVALID_SNAPSHOT;
+    }
+    if (version > 1) {
+        snapshot.info.compression = static_cast<CompressionOption>(getLittleEndian<std::uint32_t>(header.data(), 56));
+    }
+
+    std::vector<std::size_t> fieldOffsets(numFields);
+    std::vector<std::size_t> fieldBytes(numFields);
+    std::size_t const tableOffset = fixedHeaderSize + numFields * SNAPSHOT_FIELD_NAME_SIZE;
+    for (std::size_t f = 0; f < numFields; ++f) {
+        char const* name = &header[fixedHeaderSize + f * SNAPSHOT_FIELD_NAME_SIZE];
+        snapshot.fieldNames.emplace_back(name, strnlen(name, SNAPSHOT_FIELD_NAME_SIZE));
+        if (version == 1) {
+            fieldBytes[f] = snapshot.info.numNodes * sizeof(double);
+            fieldOffsets[f] = dataOffset + f * fieldBytes[f];
+        } else {
+            fieldOffsets[f] = getLittleEndian<std::uint64_t>(header.data(), tableOffset + f * SNAPSHOT_FIELD_ENTRY_SIZE);
+            fieldBytes[f] = getLittleEndian<std::uint64_t>(header.data(), tableOffset + f * SNAPSHOT_FIELD_ENTRY_SIZE + 8);
+        }
+    }
+
+    bool const compressed = CompressionOption::NONE != snapshot.info.compression;
+    std::vector<std::uint64_t> words;
+    snapshot.fields.resize(numFields);
+    for (std::size_t f = 0; f < numFields; ++f) {
+        std::vector<double>& field = snapshot.fields[f];
+        field.resize(snapshot.info.numNodes);
+        file.seekg(fieldOffsets[f]);
+        if (compressed) {
+            words.resize(fieldBytes[f] / sizeof(std::uint64_t));
+            if (!file.read(reinterpret_cast<char*>(words.data()), words.size() * sizeof(std::uint64_t))) {
+                throw Error::INVALID_SNAPSHOT;
+            }
+            if (!IS_LITTLE_ENDIAN) {
+                byteSwapInPlace(words.data(), words.size());
+            }
+            if (!isValidCompressedField(words.data(), words.size(), field.size())) {
+                throw Error::INVALID_SNAPSHOT;
+            }
+            decompressField(words.data(), field.size(), field.data());
+        } else {
+            if (fieldBytes[f] != field.size() * sizeof(double) ||
+                !file.read(reinterpret_cast<char*>(field.data()), field.size() * sizeof(double))) {
+                throw Error::INVALID_SNAPSHOT;
+            }
+            if (!IS_LITTLE_ENDIAN) {
+                byteSwapInPlace(field.data(), field.size());
+            }
+        }
+    }
+
+    return snapshot;
+}
+
+void writeSnapshotCsv(std::string const& filename, Snapshot const& snapshot) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+
+    // Same two-line preamble as the original text output
+    file << "# ";
+    for (std::size_t f = 0; f < snapshot.fieldNames.size(); ++f) {
+        file << (f > 0 ? ", " : "") << snapshot.fieldNames[f];
+    }
+    file << "\n# time: " << snapshot.info.time << " s\n";
+
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (std::size_t i = 0; i < snapshot.info.numNodes; ++i) {
+        for (std::size_t f = 0; f < snapshot.fields.size(); ++f) {
+            file << (f > 0 ? ", " : "") << snapshot.fields[f][i];
+        }
+        file << '\n';
+    }
+
+    if (!file) {
+        throw Error::FILE_IO;
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <profile_options.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Binary snapshot layout (all values little-endian):
+ *   char[8]   magic "MHDSNAP"
+ *   uint32    format version
+ *   uint32    header size in bytes, i.e. the offset of the first field array
+ *   uint64    time step
+ *   float64   simulation time
+ *   uint32    grid dimension
+ *   uint32    number of fields
+ *   uint64    number of cells
+ *   uint64    number of nodes (cells plus ghost cells)
+ *   uint32    compression (CompressionOption)
+ *   uint32    reserved
+ *   char[16]  name of each field
+ *   uint64[2] byte offset and byte size of each field
+ * followed by one array per field, in header order. Uncompressed arrays are float64[numNodes],
+ * compressed arrays use the layout in compression.hpp.
+ *
+ * Version 1 files have neither the compression word nor the field table, and their float64
+ * arrays directly follow the header.
+ */
+std::uint32_t constexpr SNAPSHOT_VERSION = 2;
+std::size_t constexpr SNAPSHOT_FIELD_NAME_SIZE = 16;
+
+// Non-owning description of a field to be written
+struct SnapshotField {
+    std::string name;
+    double const* data;
+};
+
+struct SnapshotInfo {
+    double time = 0.0;
+    std::size_t step = 0;
+    std::size_t dimension = 1;
+    std::size_t numCells = 0;
+    std::size_t numNodes = 0;
+    CompressionOption compression = CompressionOption::NONE;
+};
+
+struct Snapshot {
+    SnapshotInfo info;
+    std::vector<std::string> fieldNames;
+    std::vector<std::vector<double>> fields;
+
+    std::vector<double> const& Field(std::string const& name) const;
+};
+
+void writeSnapshot(std::string const& filename, SnapshotInfo const& info, std::vector<SnapshotField> const& fields);
+
+Snapshot readSnapshot(std::string const& filename);
+
+void writeSnapshotCsv(std::string const& filename, Snapshot const& snapshot);
+
+} // namespace MHD
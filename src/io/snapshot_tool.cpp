@@ -0,0 +1,72 @@
+#include <error.hpp>
+#include <snapshot.hpp>
+#include <time_series.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void printUsage() {
+    std::cerr << "Usage: mhd_snapshot info <snapshot>" << std::endl;
+    std::cerr << "       mhd_snapshot csv <snapshot> [<output.csv>]" << std::endl;
+    std::cerr << "       mhd_snapshot series <time series> [<output.csv>]" << std::endl;
+}
+
+void printInfo(std::string const& filename, MHD::Snapshot const& snapshot) {
+    std::cout << filename << "\n";
+    std::cout << "  time:       " << snapshot.info.time << " s\n";
+    std::cout << "  step:       " << snapshot.info.step << "\n";
+    std::cout << "  dimension:  " << snapshot.info.dimension << "\n";
+    std::cout << "  cells:      " << snapshot.info.numCells << "\n";
+    std::cout << "  nodes:      " << snapshot.info.numNodes << "\n";
+    std::cout << "  compressed: " << (MHD::CompressionOption::NONE != snapshot.info.compression ? "yes" : "no") << "\n";
+    std::cout << "  fields:\n";
+    for (std::size_t f = 0; f < snapshot.fieldNames.size(); ++f) {
+        // An empty slice has no cells, and so no range
+        if (snapshot.info.numCells == 0) {
+            std::cout << "    " << snapshot.fieldNames[f] << " []\n";
+            continue;
+        }
+        auto const& field = snapshot.fields[f];
+        auto const [minIt, maxIt] = std::minmax_element(field.begin(), field.begin() + snapshot.info.numCells);
+        std::cout << "    " << snapshot.fieldNames[f] << " [" << *minIt << ", " << *maxIt << "]\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+
+    std::string const command = argv[1];
+    std::string const filename = argv[2];
+
+    std::string const output = argc > 3 ? argv[3] : filename.substr(0, filename.rfind('.')) + ".csv";
+
+    try {
+        if (command == "series") {
+            MHD::writeTimeSeriesCsv(output, MHD::readTimeSeries(filename));
+            return 0;
+        }
+
+        MHD::Snapshot const snapshot = MHD::readSnapshot(filename);
+        if (command == "info") {
+            printInfo(filename, snapshot);
+        } else if (command == "csv") {
+            MHD::writeSnapshotCsv(output, snapshot);
+        } else {
+            printUsage();
+            return 1;
+        }
+    } catch (MHD::Error const& error) {
+        std::cerr << "Unable to process " << filename << " (error " << static_cast<int>(error) << ")" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <binary_io.hpp>
+#include <error.hpp>
+#include <time_series.hpp>
+#include <trace.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace MHD {
+
+namespace {
+
+char constexpr TIME_SERIES_MAGIC[8] = "MHDSERI";
+std::size_t constexpr TIME_SERIES_FIXED_HEADER_SIZE = 16;
+
+} // namespace
+
+TimeSeriesWriter::TimeSeriesWriter(std::string const& filename, std::vector<std::string> const& columnNames,
+                                   std::size_t const rowsPerWrite) :
+    m_numColumns(columnNames.size()), m_rowsPerWrite(std::max<std::size_t>(rowsPerWrite, 1)) {
+    std::vector<char> header(TIME_SERIES_FIXED_HEADER_SIZE + m_numColumns * TIME_SERIES_COLUMN_NAME_SIZE, 0);
+    std::memcpy(header.data(), TIME_SERIES_MAGIC, sizeof(TIME_SERIES_MAGIC));
+    putLittleEndian<std::uint32_t>(header, 8, TIME_SERIES_VERSION);
+    putLittleEndian<std::uint32_t>(header, 12, m_numColumns);
+    for (std::size_t c = 0; c < m_numColumns; ++c) {
+        std::string const& name = columnNames[c];
+        std::memcpy(&header[TIME_SERIES_FIXED_HEADER_SIZE + c * TIME_SERIES_COLUMN_NAME_SIZE], name.data(),
+                    std::min(name.size(), TIME_SERIES_COLUMN_NAME_SIZE - 1));
+    }
+
+    m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        throw Error::FILE_IO;
+    }
+    try {
+        pwriteAll(m_fd, header.data(), header.size(), 0);
+    } catch (Error const&) {
+        ::close(m_fd);
+        throw;
+    }
+    m_offset = header.size();
+    m_buffer.reserve(m_rowsPerWrite * m_numColumns);
+}
+
+TimeSeriesWriter::~TimeSeriesWriter() {
+    try {
+        Flush();
+    } catch (Error const&) {
+        // Nothing sensible to do with a failed write during teardown
+    }
+    ::close(m_fd);
+}
+
+void TimeSeriesWriter::Append(double const* row) {
+    m_buffer.insert(m_buffer.end(), row, row + m_numColumns);
+    if (m_buffer.size() >= m_rowsPerWrite * m_numColumns) {
+        Flush();
+    }
+}
+
+void TimeSeriesWriter::Flush() {
+    if (m_buffer.empty()) {
+        return;
+    }
+    ScopedTrace trace("WriteTimeSeries", "io", m_buffer.size());
+    pwriteLittleEndian(m_fd, m_buffer.data(), m_buffer.size(), m_offset);
+    m_offset += m_buffer.size() * sizeof(double);
+    m_buffer.clear();
+}
+
+std::vector<double> TimeSeries::Column(std::string const& name) const {
+    std::size_t const numColumns = columnNames.size();
+    for (std::size_t c = 0; c < numColumns; ++c) {
+        if (columnNames[c] == name) {
+            std::vector<double> column(NumRows());
+            for (std::size_t r = 0; r < column.size(); ++r) {
+                column[r] = rows[r * numColumns + c];
+            }
+            return column;
+        }
+    }
+    throw Error::INVALID_TIME_SERIES;
+}
+
+TimeSeries readTimeSeries(std::string const& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+    std::size_t const fileSize = file.tellg();
+    file.seekg(0);
+
+    std::vector<char> header(TIME_SERIES_FIXED_HEADER_SIZE);
+    if (!file.read(header.data(), header.size()) ||
+        std::memcmp(header.data(), TIME_SERIES_MAGIC, sizeof(TIME_SERIES_MAGIC)) != 0 ||
+        getLittleEndian<std::uint32_t>(header.data(), 8) != TIME_SERIES_VERSION) {
+        throw Error::INVALID_TIME_SERIES;
+    }
+    std::size_t const numColumns = getLittleEndian<std::uint32_t>(header.data(), 12);
+    std::size_t const dataOffset = TIME_SERIES_FIXED_HEADER_SIZE + numColumns * TIME_SERIES_COLUMN_NAME_SIZE;
+    if (fileSize < dataOffset) {
+        throw Error::INVALID_TIME_SERIES;
+    }
+
+    TimeSeries series;
+    header.resize(dataOffset);
+    if (!file.read(header.data() + TIME_SERIES_FIXED_HEADER_SIZE, dataOffset - TIME_SERIES_FIXED_HEADER_SIZE)) {
+        throw Error::INVALID_TIME_SERIES;
+    }
+    for (std::size_t c = 0; c < numColumns; ++c) {
+        char const* name = &header[TIME_SERIES_FIXED_HEADER_SIZE + c * TIME_SERIES_COLUMN_NAME_SIZE];
+        series.columnNames.emplace_back(name, strnlen(name, TIME_SERIES_COLUMN_NAME_SIZE));
+    }
+
+    // A partially written trailing row is dropped
+    std::size_t const rowBytes = numColumns * sizeof(double);
+    std::size_t const numRows = rowBytes == 0 ? 0 : (fileSize - dataOffset) / rowBytes;
+    series.rows.resize(numRows * numColumns);
+    if (!file.read(reinterpret_cast<char*>(series.rows.data()), series.rows.size() * sizeof(double))) {
+        throw Error::INVALID_TIME_SERIES;
+    }
+    if (!IS_LITTLE_ENDIAN) {
+        byteSwapInPlace(series.rows.data(), series.rows.size());
+    }
+
+    return series;
+}
+
+void writeTimeSeriesCsv(std::string const& filename, TimeSeries const& series) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+
+    file << "# ";
+    for (std::size_t c = 0; c < series.columnNames.size(); ++c) {
+        file << (c > 0 ? ", " : "") << series.columnNames[c];
+    }
+    file << '\n';
+
+    std::size_t const numColumns = series.columnNames.size();
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (std::size_t r = 0; r < series.NumRows(); ++r) {
+        for (std::size_t c = 0; c < numColumns; ++c) {
+            file << (c > 0 ? ", " : "") << series.rows[r * numColumns + c];
+        }
+        file << '\n';
+    }
+
+    if (!file) {
+        throw Error::FILE_IO;
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Time-series layout (all values little-endian):
+ *   char[8]   magic "MHDSERI"
+ *   uint32    format version
+ *   uint32    number of columns
+ *   char[16]  name of each column
+ * followed by one float64[numColumns] row per sample, appended in time order.
+ */
+std::uint32_t constexpr TIME_SERIES_VERSION = 1;
+std::size_t constexpr TIME_SERIES_COLUMN_NAME_SIZE = 16;
+
+/**
+ * Appends fixed-width rows of samples to a time-series file. Rows are buffered and written in
+ * batches, so sampling every time step costs a memcpy rather than a system call.
+ */
+class TimeSeriesWriter {
+public:
+    TimeSeriesWriter(std::string const& filename, std::vector<std::string> const& columnNames,
+                     std::size_t const rowsPerWrite = 256);
+    ~TimeSeriesWriter();
+
+    TimeSeriesWriter(TimeSeriesWriter const&) = delete;
+    TimeSeriesWriter& operator=(TimeSeriesWriter const&) = delete;
+
+    std::size_t NumColumns() const { return m_numColumns; }
+
+    void Append(double const* row);
+
+    // Writes out every buffered row
+    void Flush();
+
+private:
+    int m_fd = -1;
+    std::size_t m_numColumns;
+    std::size_t m_rowsPerWrite;
+    std::size_t m_offset;
+    std::vector<double> m_buffer;
+};
+
+struct TimeSeries {
+    std::vector<std::string> columnNames;
+    std::vector<double> rows;   // row-major, columnNames.size() values per row
+
+    std::size_t NumRows() const { return columnNames.empty() ? 0 : rows.size() / columnNames.size(); }
+    std::vector<double> Column(std::string const& name) const;
+};
+
+TimeSeries readTimeSeries(std::string const& filename);
+
+void writeTimeSeriesCsv(std::string const& filename, TimeSeries const& series);
+
+} // namespace MHD
@@ -0,0 +1,121 @@
+#include <activity/activity_tracker.hpp>
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <grid.hpp>
+
+#include <algorithm>
+
+namespace MHD {
+
+struct ActivityKernel {
+    static constexpr KernelTraits TRAITS = {"Activity", 8 * sizeof(double), 0};
+
+    ActivityKernel(std::array<std::vector<double> const*, 8> const& residuals, std::vector<char>& changed,
+                   std::size_t const tileCells) :
+        m_residuals(residuals), m_changed(changed), m_tileCells(tileCells) {}
+
+    void operator()(std::size_t const i) {
+        for (std::vector<double> const* residual : m_residuals) {
+            if ((*residual)[i] != 0.0) {
+                m_changed[i / m_tileCells] = 1;
+                return;
+            }
+        }
+    }
+
+    std::array<std::vector<double> const*, 8> const& m_residuals;
+    std::vector<char>& m_changed;
+    std::size_t const m_tileCells;
+};
+
+ActivityTracker::ActivityTracker(IGrid const& grid, std::vector<std::array<std::size_t, 4>> const& faceStencils,
+                                 std::vector<std::array<std::size_t, 2>> const& cellFaces, std::size_t const tileCells,
+                                 std::vector<std::size_t> const& excludedFaces) :
+    m_numCells(grid.NumCells()), m_tileCells(tileCells), m_cellFaces(cellFaces) {
+    if (tileCells == 0) {
+        throw Error::INVALID_ACTIVITY_TRACKING;
+    }
+    std::size_t const numTiles = (m_numCells + tileCells - 1) / tileCells;
+    m_readTiles.resize(numTiles);
+    m_alwaysActive.assign(numTiles, 0);
+    for (std::size_t i = 0; i < m_numCells; ++i) {
+        std::size_t const tile = i / tileCells;
+        std::vector<std::size_t>& read = m_readTiles[tile];
+        for (std::size_t const f : cellFaces[i]) {
+            for (std::size_t const j : faceStencils[f]) {
+                if (j >= m_numCells) {
+                    m_alwaysActive[tile] = 1;
+                } else if (std::find(read.begin(), read.end(), j / tileCells) == read.end()) {
+                    read.push_back(j / tileCells);
+                }
+            }
+        }
+    }
+    m_excludedFace.assign(faceStencils.size(), 0);
+    for (std::size_t const f : excludedFaces) {
+        m_excludedFace[f] = 1;
+    }
+    m_faceCollected.assign(faceStencils.size(), 0);
+    m_changed.assign(numTiles, 0);
+    ActivateAll();
+}
+
+void ActivityTracker::ActivateAll() {
+    m_active.assign(NumTiles(), 1);
+    m_stale.assign(NumTiles(), 1);
+    CollectActive();
+}
+
+void ActivityTracker::Update(ExecutionController const& execCtrl,
+                             std::array<std::vector<double> const*, 8> const& residuals) {
+    // Inactive tiles are known to have a zero residual, so only the active cells are scanned
+    std::fill(m_changed.begin(), m_changed.end(), 0);
+    ActivityKernel kernel(residuals, m_changed, m_tileCells);
+    execCtrl.LaunchKernel(kernel, m_activeCells);
+
+    for (std::size_t t = 0; t < NumTiles(); ++t) {
+        m_stale[t] |= m_changed[t];
+        m_active[t] = m_alwaysActive[t];
+        for (std::size_t const read : m_readTiles[t]) {
+            m_active[t] |= m_changed[read];
+        }
+    }
+    CollectActive();
+}
+
+std::vector<std::size_t> const& ActivityTracker::TakeStaleCells() {
+    m_staleCells.clear();
+    for (std::size_t t = 0; t < NumTiles(); ++t) {
+        if (m_stale[t]) {
+            for (std::size_t i = t * m_tileCells; i < std::min(m_numCells, (t + 1) * m_tileCells); ++i) {
+                m_staleCells.push_back(i);
+            }
+            m_stale[t] = 0;
+        }
+    }
+    return m_staleCells;
+}
+
+void ActivityTracker::CollectActive() {
+    m_activeCells.clear();
+    m_activeFaces.clear();
+    for (std::size_t t = 0; t < NumTiles(); ++t) {
+        if (!m_active[t]) {
+            continue;
+        }
+        for (std::size_t i = t * m_tileCells; i < std::min(m_numCells, (t + 1) * m_tileCells); ++i) {
+            m_activeCells.push_back(i);
+            for (std::size_t const f : m_cellFaces[i]) {
+                if (!m_excludedFace[f] && !m_faceCollected[f]) {
+                    m_faceCollected[f] = 1;
+                    m_activeFaces.push_back(f);
+                }
+            }
+        }
+    }
+    for (std::size_t const f : m_activeFaces) {
+        m_faceCollected[f] = 0;
+    }
+}
+
+} // namespace MHD
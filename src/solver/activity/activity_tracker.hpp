@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace MHD {
+
+class ExecutionController;
+class IGrid;
+
+/**
+ * Keeps the tiles of a grid that a step can change. A cell's residual is read from the cells in the
+ * stencils of its faces, so a tile whose cells all had a zero residual, and whose stencils reach no
+ * cell that changed, has a zero residual again and is skipped. Skipped cells would only have added
+ * zero, so a step over the active tiles gives the same state as a step over every cell, bit for bit.
+ * Tiles whose stencils reach a ghost cell are always active, since a boundary condition or a halo
+ * exchange can change their inputs from outside.
+ */
+class ActivityTracker {
+public:
+    // Faces at excludedFaces in the face list are left to the caller, who computes them every step
+    ActivityTracker(IGrid const& grid, std::vector<std::array<std::size_t, 4>> const& faceStencils,
+                    std::vector<std::array<std::size_t, 2>> const& cellFaces, std::size_t const tileCells,
+                    std::vector<std::size_t> const& excludedFaces = {});
+
+    // Positions in the face list and cells of the tiles active in the coming step
+    std::vector<std::size_t> const& ActiveFaces() const { return m_activeFaces; }
+    std::vector<std::size_t> const& ActiveCells() const { return m_activeCells; }
+
+    // Marks the tiles whose cells have a nonzero residual as changed, and activates them and the
+    // tiles whose stencils reach them for the next step
+    void Update(ExecutionController const& execCtrl, std::array<std::vector<double> const*, 8> const& residuals);
+
+    // Cells changed since the last call, whose primitives are out of date; every cell at first
+    std::vector<std::size_t> const& TakeStaleCells();
+
+    // Every tile active and stale, for a state set from outside the solver
+    void ActivateAll();
+
+    std::size_t NumTiles() const { return m_alwaysActive.size(); }
+
+private:
+    void CollectActive();
+
+    std::size_t const m_numCells;
+    std::size_t const m_tileCells;
+    std::vector<std::array<std::size_t, 2>> const& m_cellFaces;
+
+    // Tiles whose cells appear in the stencils of each tile's faces, itself included
+    std::vector<std::vector<std::size_t>> m_readTiles;
+    std::vector<char> m_alwaysActive;
+    std::vector<char> m_excludedFace;
+
+    std::vector<char> m_active;
+    std::vector<char> m_changed;
+    std::vector<char> m_stale;
+    std::vector<char> m_faceCollected;
+    std::vector<std::size_t> m_activeFaces;
+    std::vector<std::size_t> m_activeCells;
+    std::vector<std::size_t> m_staleCells;
+};
+
+} // namespace MHD
@@ -1,7 +1,9 @@
 #include <boundary_condition/boundary_condition.hpp>
+#include <error.hpp>
 #include <execution_controller.hpp>
 #include <grid.hpp>
 #include <profile.hpp>
+#include <reconstruction/reconstruction.hpp>
 #include <variable_store.hpp>
 
 #include <memory>
@@ -9,35 +11,42 @@
 namespace MHD {
 
 struct OutflowBoundaryConditionKernel {
-    OutflowBoundaryConditionKernel(BoundaryConditionContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"OutflowBoundaryCondition", 13 * sizeof(double), 8};
+
+    OutflowBoundaryConditionKernel(BoundaryConditionContext& context) : m_context(context), m_idxs(context.outflow) {}
 
     void operator()(std::size_t const i) {
-        std::size_t const iInt = m_context.boundaryIdxToCellIdxs.at(m_context.boundaryIdxs[i])[0];
-        std::size_t const iExt = m_context.boundaryIdxToCellIdxs.at(m_context.boundaryIdxs[i])[1];
+        std::size_t const iInt = m_idxs.intIdxs[i];
+        std::size_t const iExt = m_idxs.extIdxs[i];
+        std::size_t const iFace = m_idxs.faceIdxs[i];
 
         // Normal component of the velocity inside the boundary
-        auto uDotN = m_context.u[iInt] * m_context.faceNormalX[i] +
-                     m_context.v[iInt] * m_context.faceNormalY[i] +
-                     m_context.w[iInt] * m_context.faceNormalZ[i];
+        auto uDotN = m_context.u[iInt] * m_context.faceNormalX[iFace] +
+                     m_context.v[iInt] * m_context.faceNormalY[iFace] +
+                     m_context.w[iInt] * m_context.faceNormalZ[iFace];
 
         // Neumann condition on the normal velocity
-        m_context.u[iExt] = uDotN * m_context.faceNormalX[i];
-        m_context.v[iExt] = uDotN * m_context.faceNormalY[i];
-        m_context.w[iExt] = uDotN * m_context.faceNormalZ[i];
+        m_context.u[iExt] = uDotN * m_context.faceNormalX[iFace];
+        m_context.v[iExt] = uDotN * m_context.faceNormalY[iFace];
+        m_context.w[iExt] = uDotN * m_context.faceNormalZ[iFace];
 
         // Dirichlet condition on the pressure
         m_context.rho[iExt] = m_context.rho[iInt];
         m_context.p[iExt] = m_context.p[iInt];
     }
+
     BoundaryConditionContext& m_context;
+    BoundaryIdxList const& m_idxs;
 };
 
 struct ReflectiveBoundaryConditionKernel {
-    ReflectiveBoundaryConditionKernel(BoundaryConditionContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"ReflectiveBoundaryCondition", 22 * sizeof(double), 0};
+
+    ReflectiveBoundaryConditionKernel(BoundaryConditionContext& context) : m_context(context), m_idxs(context.reflective) {}
 
     void operator()(std::size_t const i) {
-        std::size_t const iInt = m_context.boundaryIdxToCellIdxs.at(m_context.boundaryIdxs[i])[0];
-        std::size_t const iExt = m_context.boundaryIdxToCellIdxs.at(m_context.boundaryIdxs[i])[1];
+        std::size_t const iInt = m_idxs.intIdxs[i];
+        std::size_t const iExt = m_idxs.extIdxs[i];
 
         m_context.rho[iExt] = m_context.rho[iInt];
         m_context.p[iExt] = m_context.p[iInt];
@@ -53,47 +62,138 @@ struct ReflectiveBoundaryConditionKernel {
     }
 
     BoundaryConditionContext& m_context;
+    BoundaryIdxList const& m_idxs;
 };
 
-BoundaryConditionContext::BoundaryConditionContext(IGrid const& grid, VariableStore& vs) :
-    numBoundaries(grid.NumBoundaries()), boundaryIdxToCellIdxs(grid.BoundaryIdxToCellIdxs()),
-    boundaryIdxs(grid.BoundaryIdxs()),
-    faceNormalX(grid.FaceNormalX()), faceNormalY(grid.FaceNormalY()), faceNormalZ(grid.FaceNormalZ()),
-    rho(vs.rho), u(vs.u), v(vs.v), w(vs.w), p(vs.p), e(vs.e), t(vs.t), cs(vs.cs),
-    bx(vs.bx), by(vs.by), bz(vs.bz) {}
+struct PeriodicBoundaryConditionKernel {
+    static constexpr KernelTraits TRAITS = {"PeriodicBoundaryCondition", 22 * sizeof(double), 0};
 
-class OutflowBoundaryCondition : public IBoundaryCondition {
-public:
-    OutflowBoundaryCondition(IGrid const& grid, VariableStore& vs) {
-        m_context = std::make_unique<BoundaryConditionContext>(grid, vs);
-    };
+    PeriodicBoundaryConditionKernel(BoundaryConditionContext& context) : m_context(context), m_idxs(context.periodic) {}
 
-    void ApplyBoundaryConditions(ExecutionController const& execCtrl) {
-        OutflowBoundaryConditionKernel kern(*m_context);
-        execCtrl.LaunchKernel(kern, m_context->numBoundaries);
+    void operator()(std::size_t const i) {
+        std::size_t const iInt = m_idxs.intIdxs[i];
+        std::size_t const iExt = m_idxs.extIdxs[i];
+
+        m_context.rho[iExt] = m_context.rho[iInt];
+        m_context.p[iExt] = m_context.p[iInt];
+        m_context.e[iExt] = m_context.e[iInt];
+        m_context.t[iExt] = m_context.t[iInt];
+        m_context.cs[iExt] = m_context.cs[iInt];
+        m_context.u[iExt] = m_context.u[iInt];
+        m_context.v[iExt] = m_context.v[iInt];
+        m_context.w[iExt] = m_context.w[iInt];
+        m_context.bx[iExt] = m_context.bx[iInt];
+        m_context.by[iExt] = m_context.by[iInt];
+        m_context.bz[iExt] = m_context.bz[iInt];
     }
+
+    BoundaryConditionContext& m_context;
+    BoundaryIdxList const& m_idxs;
 };
 
-class ReflectiveBoundaryCondition : public IBoundaryCondition {
+BoundaryConditionContext::BoundaryConditionContext(IGrid const& grid, VariableStore& vs,
+                                                   std::vector<BoundaryConditionOption> const& options,
+                                                   std::vector<bool> const& exchanged) :
+    numBoundaries(grid.NumBoundaries()),
+    faceNormalX(grid.FaceNormalX()), faceNormalY(grid.FaceNormalY()), faceNormalZ(grid.FaceNormalZ()),
+    rho(vs.rho), u(vs.u), v(vs.v), w(vs.w), p(vs.p), e(vs.e), t(vs.t), cs(vs.cs),
+    bx(vs.bx), by(vs.by), bz(vs.bz) {
+    for (std::size_t b = 0; b < numBoundaries; ++b) {
+        if (exchanged[b]) {
+            continue;
+        }
+        std::size_t const faceIdx = grid.BoundaryIdxs()[b];
+        std::vector<std::size_t> const& pairs = grid.BoundaryIdxToCellIdxs().at(faceIdx);
+
+        if (BoundaryConditionOption::PERIODIC == options[b]) {
+            std::vector<std::size_t> const& periodicPairs = grid.BoundaryIdxToPeriodicCellIdxs().at(faceIdx);
+            for (std::size_t k = 0; k < periodicPairs.size(); k += 2) {
+                periodic.intIdxs.push_back(periodicPairs[k]);
+                periodic.extIdxs.push_back(periodicPairs[k + 1]);
+                periodic.faceIdxs.push_back(faceIdx);
+            }
+        } else if (BoundaryConditionOption::REFLECTIVE == options[b]) {
+            // Each ghost layer mirrors the interior cell the same distance from the boundary
+            for (std::size_t k = 0; k < pairs.size(); k += 2) {
+                reflective.intIdxs.push_back(pairs[k]);
+                reflective.extIdxs.push_back(pairs[k + 1]);
+                reflective.faceIdxs.push_back(faceIdx);
+            }
+        } else if (BoundaryConditionOption::OUTFLOW == options[b]) {
+            // Every ghost layer extrapolates from the cell adjacent to the boundary
+            for (std::size_t k = 0; k < pairs.size(); k += 2) {
+                outflow.intIdxs.push_back(pairs[0]);
+                outflow.extIdxs.push_back(pairs[k + 1]);
+                outflow.faceIdxs.push_back(faceIdx);
+            }
+        } else {
+            throw Error::INVALID_BOUNDARY_CONDITION;
+        }
+    }
+}
+
+class BoundaryCondition : public IBoundaryCondition {
 public:
-    ReflectiveBoundaryCondition(IGrid const& grid, VariableStore& vs) {
-        m_context = std::make_unique<BoundaryConditionContext>(grid, vs);
+    BoundaryCondition(IGrid const& grid, VariableStore& vs, std::vector<BoundaryConditionOption> const& options,
+                      std::vector<bool> const& exchanged) {
+        m_context = std::make_unique<BoundaryConditionContext>(grid, vs, options, exchanged);
     };
 
     void ApplyBoundaryConditions(ExecutionController const& execCtrl) {
-        ReflectiveBoundaryConditionKernel kern(*m_context);
-        execCtrl.LaunchKernel(kern, m_context->numBoundaries);
+        if (!m_context->outflow.extIdxs.empty()) {
+            OutflowBoundaryConditionKernel kern(*m_context);
+            execCtrl.LaunchKernel(kern, m_context->outflow.extIdxs.size());
+        }
+        if (!m_context->reflective.extIdxs.empty()) {
+            ReflectiveBoundaryConditionKernel kern(*m_context);
+            execCtrl.LaunchKernel(kern, m_context->reflective.extIdxs.size());
+        }
+        if (!m_context->periodic.extIdxs.empty()) {
+            PeriodicBoundaryConditionKernel kern(*m_context);
+            execCtrl.LaunchKernel(kern, m_context->periodic.extIdxs.size());
+        }
     }
 };
 
-std::unique_ptr<IBoundaryCondition> boundaryConditionFactory(Profile const& profile, IGrid const& grid, VariableStore& vs) {
-    if (BoundaryConditionOption::REFLECTIVE == profile.m_boundaryConditionOption) {
-        return std::make_unique<ReflectiveBoundaryCondition>(grid, vs);
+std::unique_ptr<IBoundaryCondition> boundaryConditionFactory(Profile const& profile, IGrid const& grid, VariableStore& vs,
+                                                             std::vector<bool> const& exchanged) {
+    std::size_t const numBoundaries = grid.NumBoundaries();
+    std::vector<bool> isExchanged = exchanged;
+    if (isExchanged.empty()) {
+        isExchanged.assign(numBoundaries, false);
+    }
+    if (isExchanged.size() != numBoundaries) {
+        throw Error::INVALID_DECOMPOSITION;
+    }
+
+    // A single option applies to every boundary unless per-boundary options are given
+    std::vector<BoundaryConditionOption> options = profile.m_boundaryConditionsOption;
+    if (options.empty()) {
+        options.assign(numBoundaries, profile.m_boundaryConditionOption);
     }
-    if (BoundaryConditionOption::OUTFLOW == profile.m_boundaryConditionOption) {
-        return std::make_unique<OutflowBoundaryCondition>(grid, vs);
+    if (options.size() != numBoundaries) {
+        throw Error::INVALID_BOUNDARY_CONDITION;
     }
-    return nullptr;
+
+    // Periodicity must be imposed on both ends of the domain, unless a neighbour rank owns the other end
+    for (std::size_t b = 0; b < numBoundaries; ++b) {
+        if (isExchanged[b] || isExchanged[numBoundaries - 1 - b]) {
+            continue;
+        }
+        bool const isPeriodic = BoundaryConditionOption::PERIODIC == options[b];
+        bool const partnerIsPeriodic = BoundaryConditionOption::PERIODIC == options[numBoundaries - 1 - b];
+        if (isPeriodic != partnerIsPeriodic) {
+            throw Error::INVALID_BOUNDARY_CONDITION;
+        }
+
+        // Faces at a periodic end must see the same cells as they would inside the domain, or the
+        // fluxes through the two ends differ and mass leaks across them
+        if (isPeriodic && grid.NumGhostLayers() < reconstructionStencilReach(profile)) {
+            throw Error::INVALID_NUM_GHOST_LAYERS;
+        }
+    }
+
+    return std::make_unique<BoundaryCondition>(grid, vs, options, isExchanged);
 }
 
-} // namespace MHD
\ No newline at end of file
+} // namespace MHD
@@ -4,18 +4,30 @@
 #include <profile.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace MHD {
 
 class ExecutionController;
 class VariableStore;
 
+// Flat gather/scatter lists for one boundary condition type, one entry per ghost cell
+struct BoundaryIdxList {
+    std::vector<std::size_t> intIdxs;   // interior (donor) node
+    std::vector<std::size_t> extIdxs;   // ghost node
+    std::vector<std::size_t> faceIdxs;  // boundary face the ghost node lies behind
+};
+
 struct BoundaryConditionContext {
-    BoundaryConditionContext(IGrid const& grid, VariableStore& vs);
+    BoundaryConditionContext(IGrid const& grid, VariableStore& vs, std::vector<BoundaryConditionOption> const& options,
+                             std::vector<bool> const& exchanged);
 
     std::size_t const numBoundaries;
-    std::vector<std::size_t> const boundaryIdxs;
-    std::map<std::size_t, std::vector<std::size_t>> boundaryIdxToCellIdxs;
+
+    // Index lists built once at setup for each boundary condition type
+    BoundaryIdxList outflow;
+    BoundaryIdxList reflective;
+    BoundaryIdxList periodic;
 
     // Properties of the face
     std::vector<double> const& faceNormalX;
@@ -46,6 +58,8 @@ protected:
     std::unique_ptr<BoundaryConditionContext> m_context;
 };
 
-std::unique_ptr<IBoundaryCondition> boundaryConditionFactory(Profile const& profile, IGrid const& grid, VariableStore& vs);
+// Boundaries flagged in exchanged are filled by a halo exchange instead and get no condition here
+std::unique_ptr<IBoundaryCondition> boundaryConditionFactory(Profile const& profile, IGrid const& grid, VariableStore& vs,
+                                                             std::vector<bool> const& exchanged = {});
 
-} // namespace MHD
\ No newline at end of file
+} // namespace MHD
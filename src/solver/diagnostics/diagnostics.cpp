@@ -0,0 +1,193 @@
+#include <communicator.hpp>
+#include <diagnostics/diagnostics.hpp>
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <grid.hpp>
+#include <profile.hpp>
+#include <variable_store.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace MHD {
+
+namespace {
+
+std::string integralName(DiagnosticIntegralOption const integral) {
+    switch (integral) {
+        case DiagnosticIntegralOption::MASS: return "mass";
+        case DiagnosticIntegralOption::MOMENTUM_X: return "momentumX";
+        case DiagnosticIntegralOption::TOTAL_ENERGY: return "totalEnergy";
+        case DiagnosticIntegralOption::KINETIC_ENERGY: return "kineticEnergy";
+        case DiagnosticIntegralOption::MAGNETIC_ENERGY: return "magneticEnergy";
+    }
+    throw Error::INVALID_DIAGNOSTIC;
+}
+
+// Fields recorded by every probe, in column order
+char const* const PROBE_FIELD_NAMES[] = {"rho", "u", "v", "w", "p", "bx", "by", "bz"};
+std::size_t constexpr NUM_PROBE_FIELDS = sizeof(PROBE_FIELD_NAMES) / sizeof(PROBE_FIELD_NAMES[0]);
+
+} // namespace
+
+struct IntegralKernel {
+    static constexpr KernelTraits TRAITS = {"DiagnosticIntegral", 3 * sizeof(double), 6};
+
+    IntegralKernel(DiagnosticsContext const& context, DiagnosticIntegralOption const integral) :
+        m_context(context), m_integral(integral) {}
+
+    double operator()(std::size_t const i) const {
+        double const density = Density(i);
+        return m_context.uniform ? density : density * m_context.cellWidths[i];
+    }
+
+    double Density(std::size_t const i) const {
+        switch (m_integral) {
+            case DiagnosticIntegralOption::MASS:
+                return m_context.rho[i];
+            case DiagnosticIntegralOption::MOMENTUM_X:
+                return m_context.rhoU[i];
+            case DiagnosticIntegralOption::TOTAL_ENERGY:
+                return m_context.rhoE[i];
+            case DiagnosticIntegralOption::KINETIC_ENERGY:
+                return 0.5 * (m_context.rhoU[i] * m_context.rhoU[i] +
+                              m_context.rhoV[i] * m_context.rhoV[i] +
+                              m_context.rhoW[i] * m_context.rhoW[i]) / m_context.rho[i];
+            case DiagnosticIntegralOption::MAGNETIC_ENERGY:
+                return 0.5 * (m_context.bx[i] * m_context.bx[i] +
+                              m_context.by[i] * m_context.by[i] +
+                              m_context.bz[i] * m_context.bz[i]);
+        }
+        return 0.0;
+    }
+
+    DiagnosticsContext const& m_context;
+    DiagnosticIntegralOption const m_integral;
+};
+
+struct ProbeKernel {
+    static constexpr KernelTraits TRAITS = {"DiagnosticProbe", 16 * sizeof(double), 0};
+
+    ProbeKernel(DiagnosticsContext const& context, std::vector<std::size_t> const& cellIdxs,
+                std::vector<std::size_t> const& slots, double* values) :
+        m_context(context), m_cellIdxs(cellIdxs), m_slots(slots), m_values(values) {}
+
+    void operator()(std::size_t const k) {
+        std::size_t const i = m_cellIdxs[k];
+        double* values = m_values + m_slots[k] * NUM_PROBE_FIELDS;
+        values[0] = m_context.rho[i];
+        values[1] = m_context.u[i];
+        values[2] = m_context.v[i];
+        values[3] = m_context.w[i];
+        values[4] = m_context.p[i];
+        values[5] = m_context.bx[i];
+        values[6] = m_context.by[i];
+        values[7] = m_context.bz[i];
+    }
+
+    DiagnosticsContext const& m_context;
+    std::vector<std::size_t> const& m_cellIdxs;
+    std::vector<std::size_t> const& m_slots;
+    double* m_values;
+};
+
+DiagnosticsContext::DiagnosticsContext(IGrid const& grid, VariableStore const& vs) :
+    numCells(grid.NumCells()), uniform(grid.IsUniform()), cellVolume(grid.CellSize()[0]), cellWidths(grid.CellWidths()),
+    rho(vs.rho), rhoU(vs.rhoU), rhoV(vs.rhoV), rhoW(vs.rhoW), rhoE(vs.rhoE), bx(vs.bx), by(vs.by), bz(vs.bz),
+    u(vs.u), v(vs.v), w(vs.w), p(vs.p) {}
+
+Diagnostics::Diagnostics(Profile const& profile, IGrid const& grid, VariableStore const& vs,
+                         ICommunicator const* communicator) :
+    m_context(grid, vs), m_integrals(profile.m_diagnosticIntegralsOption), m_communicator(communicator) {
+    // Agreement across ranks, the local value itself without a communicator
+    auto globalMax = [communicator](double const value) {
+        return communicator ? communicator->AllReduceMax(value) : value;
+    };
+    auto globalSum = [communicator](double value) {
+        if (communicator) {
+            communicator->AllReduceSum(&value, 1);
+        }
+        return value;
+    };
+    int const rank = communicator ? communicator->Rank() : 0;
+    int const size = communicator ? communicator->Size() : 1;
+
+    for (DiagnosticIntegralOption const integral : m_integrals) {
+        m_names.push_back(integralName(integral));
+    }
+
+    // Interior cells come first in the node list and are ordered along x
+    std::size_t const numCells = grid.NumCells();
+    auto const& nodes = grid.Nodes();
+    double const lower = nodes[0][0] - 0.5 * grid.CellWidths()[0];
+    double const upper = nodes[numCells - 1][0] + 0.5 * grid.CellWidths()[numCells - 1];
+
+    for (double const x : profile.m_probeLocationsOption) {
+        bool const inside = x >= lower && x <= upper;
+        if (globalMax(inside ? 1.0 : 0.0) == 0.0) {
+            throw Error::INVALID_DIAGNOSTIC;
+        }
+        std::size_t nearest = 0;
+        double nearestDistance = std::numeric_limits<double>::max();
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const distance = std::abs(nodes[i][0] - x);
+            if (distance < nearestDistance) {
+                nearest = i;
+                nearestDistance = distance;
+            }
+        }
+
+        std::string const prefix = "probe" + std::to_string(m_numProbes) + ".";
+        for (char const* field : PROBE_FIELD_NAMES) {
+            m_names.push_back(prefix + field);
+        }
+
+        // The rank with the nearest cell reads the probe, the lowest one on a tie as in a single part
+        double const globalDistance = -globalMax(-nearestDistance);
+        double const candidate = nearestDistance == globalDistance ? rank : size;
+        if (-globalMax(-candidate) == rank) {
+            m_probeCellIdxs.push_back(nearest);
+            m_probeSlots.push_back(m_numProbes);
+        }
+        ++m_numProbes;
+    }
+
+    std::vector<double> const& sliceBounds = profile.m_sliceBoundsOption;
+    if (sliceBounds.size() % 2 != 0) {
+        throw Error::INVALID_DIAGNOSTIC;
+    }
+    for (std::size_t s = 0; s < sliceBounds.size(); s += 2) {
+        SliceRange slice = {0, 0};
+        for (std::size_t i = 0; i < numCells; ++i) {
+            if (nodes[i][0] >= sliceBounds[s] && nodes[i][0] <= sliceBounds[s + 1]) {
+                slice.first = slice.count == 0 ? i : slice.first;
+                ++slice.count;
+            }
+        }
+        if (globalSum(static_cast<double>(slice.count)) == 0.0) {
+            throw Error::INVALID_DIAGNOSTIC;
+        }
+        m_slices.push_back(slice);
+    }
+}
+
+void Diagnostics::Sample(ExecutionController const& execCtrl, double* values) const {
+    double const volume = m_context.uniform ? m_context.cellVolume : 1.0;
+    for (DiagnosticIntegralOption const integral : m_integrals) {
+        IntegralKernel kernel(m_context, integral);
+        *values++ = execCtrl.LaunchReduction(kernel, m_context.numCells) * volume;
+    }
+
+    // Probes read on other ranks stay zero, so a sum over the ranks leaves the one reading
+    std::fill(values, values + m_numProbes * NUM_PROBE_FIELDS, 0.0);
+    ProbeKernel probeKernel(m_context, m_probeCellIdxs, m_probeSlots, values);
+    execCtrl.LaunchKernel(probeKernel, m_probeCellIdxs.size());
+
+    if (m_communicator) {
+        double* const first = values - m_integrals.size();
+        m_communicator->AllReduceSum(first, m_integrals.size() + m_numProbes * NUM_PROBE_FIELDS);
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <grid.hpp>
+#include <profile.hpp>
+
+#include <string>
+#include <vector>
+
+namespace MHD {
+
+class ExecutionController;
+class ICommunicator;
+class VariableStore;
+
+struct DiagnosticsContext {
+    DiagnosticsContext(IGrid const& grid, VariableStore const& vs);
+
+    std::size_t const numCells;
+
+    // Every cell has the same volume on a uniform grid, otherwise its width per unit face area
+    bool const uniform;
+    double const cellVolume;
+    std::vector<double> const& cellWidths;
+
+    // Conserved states
+    std::vector<double> const& rho;
+    std::vector<double> const& rhoU;
+    std::vector<double> const& rhoV;
+    std::vector<double> const& rhoW;
+    std::vector<double> const& rhoE;
+    std::vector<double> const& bx;
+    std::vector<double> const& by;
+    std::vector<double> const& bz;
+
+    // Primitive states
+    std::vector<double> const& u;
+    std::vector<double> const& v;
+    std::vector<double> const& w;
+    std::vector<double> const& p;
+};
+
+// Contiguous run of interior cells written out as a slice
+struct SliceRange {
+    std::size_t first;
+    std::size_t count;
+};
+
+/**
+ * Reduces the state to a handful of numbers per sample: domain integrals, evaluated as reductions
+ * through the execution controller, and probe values read from the cell nearest each probe. Slices
+ * are resolved to cell ranges once here and written out by the caller.
+ *
+ * With a communicator the grid is one part of the domain: integrals are summed over the ranks, each
+ * probe is read by the one rank holding its nearest cell, and a slice may be empty on some ranks.
+ */
+class Diagnostics {
+public:
+    Diagnostics(Profile const& profile, IGrid const& grid, VariableStore const& vs,
+                ICommunicator const* communicator = nullptr);
+
+    // Names of the values filled in by Sample, in order
+    std::vector<std::string> const& Names() const { return m_names; }
+    std::vector<SliceRange> const& Slices() const { return m_slices; }
+
+    // Expects primitive variables that are up to date with the conserved ones
+    void Sample(ExecutionController const& execCtrl, double* values) const;
+
+private:
+    DiagnosticsContext m_context;
+    std::vector<DiagnosticIntegralOption> m_integrals;
+    std::size_t m_numProbes = 0;
+    std::vector<std::size_t> m_probeCellIdxs;  // of the probes read on this rank
+    std::vector<std::size_t> m_probeSlots;     // position of each of those among all probes
+    ICommunicator const* m_communicator;
+    std::vector<SliceRange> m_slices;
+    std::vector<std::string> m_names;
+};
+
+} // namespace MHD
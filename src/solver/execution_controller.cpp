@@ -0,0 +1,317 @@
+#include <error.hpp>
+#include <execution_controller.hpp>
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+namespace MHD {
+
+namespace {
+
+void writeJsonString(std::ostream& os, std::string const& value) {
+    os << '"';
+    for (char const c : value) {
+        if (c == '"' || c == '\\') {
+            os << '\\';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+// Serial number of each thread that launches a kernel, unlike its id never reused once it exits
+std::uint64_t nextThreadSerial() {
+    static std::atomic<std::uint64_t> nextSerial{1};
+    return nextSerial++;
+}
+
+std::size_t constexpr NO_POSITION = static_cast<std::size_t>(-1);
+
+// Every last-level cache miss is taken to move one line from memory
+double constexpr CACHE_LINE_BYTES = 64.0;
+
+void writeRatio(std::ostream& os, int const width, double const numerator, double const denominator,
+                bool const available = true) {
+    if (available && denominator > 0.0) {
+        os << std::setw(width) << numerator / denominator;
+    } else {
+        os << std::setw(width) << "-";
+    }
+}
+
+} // namespace
+
+std::string demangledTypeName(char const* mangledName) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangledName, nullptr, nullptr, &status);
+    std::string name = status == 0 && demangled ? demangled : mangledName;
+    std::free(demangled);
+    return name;
+}
+
+std::size_t nextControllerId() {
+    static std::atomic<std::size_t> nextId{1};
+    return nextId++;
+}
+
+std::vector<KernelStats> ExecutionController::KernelStatistics() const {
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    std::vector<KernelStats> stats;
+    std::vector<std::size_t> positions;
+    for (ThreadStats const& thread : m_threadStats) {
+        for (std::size_t const id : thread.kernelOrder) {
+            KernelStats const& local = thread.kernelStats[id];
+            if (id >= positions.size()) {
+                positions.resize(id + 1, NO_POSITION);
+            }
+            if (positions[id] == NO_POSITION) {
+                positions[id] = stats.size();
+                stats.push_back(local);
+                continue;
+            }
+            KernelStats& merged = stats[positions[id]];
+            merged.numLaunches += local.numLaunches;
+            merged.numItems += local.numItems;
+            merged.seconds += local.seconds;
+            merged.bytes += local.bytes;
+            merged.flops += local.flops;
+            for (std::size_t c = 0; c < NUM_HARDWARE_COUNTERS; ++c) {
+                merged.counters[c] += local.counters[c];
+            }
+        }
+    }
+    return stats;
+}
+
+void ExecutionController::ResetStatistics() {
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    for (ThreadStats& thread : m_threadStats) {
+        for (std::size_t const id : thread.kernelOrder) {
+            thread.kernelStats[id] = KernelStats{thread.kernelStats[id].name};
+        }
+        thread.kernelOrder.clear();
+    }
+    m_regionStats.clear();
+}
+
+ExecutionController::ThreadStats& ExecutionController::RegisterThread() const {
+    thread_local std::uint64_t const t_serial = nextThreadSerial();
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    for (ThreadStats& thread : m_threadStats) {
+        if (thread.thread == t_serial) {
+            return thread;
+        }
+    }
+
+    // Counters count only the thread that opened them, so each thread opens its own
+    ThreadStats& thread = m_threadStats.emplace_back();
+    thread.thread = t_serial;
+    if (m_hardwareCounters) {
+        thread.perfCounters = std::make_unique<PerfCounters>();
+    }
+    return thread;
+}
+
+bool ExecutionController::EnableHardwareCounters() {
+    ThreadStats& local = LocalStats();
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    local.perfCounters = std::make_unique<PerfCounters>();
+    if (!local.perfCounters->AnyAvailable()) {
+        local.perfCounters.reset();
+        return false;
+    }
+    for (std::size_t c = 0; c < NUM_HARDWARE_COUNTERS; ++c) {
+        m_countersAvailable[c] = local.perfCounters->Available(static_cast<HardwareCounter>(c));
+    }
+    m_hardwareCounters = true;
+    return true;
+}
+
+RegionStats& ExecutionController::Region(char const* name) const {
+    for (RegionStats& stats : m_regionStats) {
+        if (stats.name == name) {
+            return stats;
+        }
+    }
+    m_regionStats.push_back(RegionStats{name});
+    return m_regionStats.back();
+}
+
+void ExecutionController::PrintSummary(std::ostream& os) const {
+    std::vector<KernelStats> kernels = KernelStatistics();
+    std::sort(kernels.begin(), kernels.end(), [](KernelStats const& a, KernelStats const& b) {
+        return a.seconds > b.seconds;
+    });
+    double totalSeconds = 0.0;
+    for (KernelStats const& stats : kernels) {
+        totalSeconds += stats.seconds;
+    }
+
+    std::ios_base::fmtflags const flags = os.flags();
+    std::streamsize const precision = os.precision();
+    os << std::fixed;
+
+    if (!m_regionStats.empty()) {
+        os << std::left << std::setw(32) << "Region" << std::right << std::setw(10) << "Calls"
+           << std::setw(12) << "Time [s]" << std::setw(14) << "Allocs/call" << std::setw(14) << "Bytes/call" << "\n";
+        for (RegionStats const& stats : m_regionStats) {
+            double const numCalls = std::max<double>(stats.numCalls, 1.0);
+            os << std::left << std::setw(32) << stats.name << std::right << std::setw(10) << stats.numCalls
+               << std::setw(12) << std::setprecision(4) << stats.seconds << std::setprecision(1)
+               << std::setw(14) << stats.numAllocations / numCalls << std::setw(14) << stats.allocatedBytes / numCalls
+               << "\n";
+        }
+        os << "\n";
+    }
+
+    os << std::left << std::setw(32) << "Kernel" << std::right << std::setw(10) << "Launches" << std::setw(14) << "Items"
+       << std::setw(12) << "Time [s]" << std::setw(8) << "%" << std::setw(10) << "ns/item" << std::setw(10) << "GB/s"
+       << std::setw(10) << "GFLOP/s" << "\n";
+    for (KernelStats const& stats : kernels) {
+        double const share = totalSeconds > 0.0 ? 100.0 * stats.seconds / totalSeconds : 0.0;
+        double const nsPerItem = stats.numItems > 0 ? 1e9 * stats.seconds / stats.numItems : 0.0;
+        double const bandwidth = stats.seconds > 0.0 ? 1e-9 * stats.bytes / stats.seconds : 0.0;
+        double const flopRate = stats.seconds > 0.0 ? 1e-9 * stats.flops / stats.seconds : 0.0;
+        os << std::left << std::setw(32) << stats.name << std::right << std::setw(10) << stats.numLaunches
+           << std::setw(14) << stats.numItems << std::setw(12) << std::setprecision(4) << stats.seconds
+           << std::setw(8) << std::setprecision(1) << share << std::setw(10) << nsPerItem
+           << std::setw(10) << std::setprecision(2) << bandwidth << std::setw(10) << flopRate << "\n";
+    }
+
+    if (m_hardwareCounters) {
+        auto const available = [this](HardwareCounter const counter) { return HardwareCounterAvailable(counter); };
+        auto const count = [](KernelStats const& stats, HardwareCounter const counter) {
+            return static_cast<double>(stats.counters[static_cast<std::size_t>(counter)]);
+        };
+
+        os << "\n" << std::left << std::setw(32) << "Kernel" << std::right << std::setw(14) << "Cycles/item"
+           << std::setw(8) << "IPC" << std::setw(12) << "LLC miss %" << std::setw(14) << "LLC B/item"
+           << std::setw(12) << "FLOP/cycle" << "\n";
+        for (KernelStats const& stats : kernels) {
+            double const cycles = count(stats, HardwareCounter::CYCLES);
+            os << std::left << std::setw(32) << stats.name << std::right << std::setprecision(2);
+            writeRatio(os, 14, cycles, stats.numItems, available(HardwareCounter::CYCLES));
+            writeRatio(os, 8, count(stats, HardwareCounter::INSTRUCTIONS), cycles,
+                       available(HardwareCounter::INSTRUCTIONS));
+            writeRatio(os, 12, 100.0 * count(stats, HardwareCounter::LLC_MISSES),
+                       count(stats, HardwareCounter::LLC_REFERENCES),
+                       available(HardwareCounter::LLC_MISSES) && available(HardwareCounter::LLC_REFERENCES));
+            writeRatio(os, 14, CACHE_LINE_BYTES * count(stats, HardwareCounter::LLC_MISSES), stats.numItems,
+                       available(HardwareCounter::LLC_MISSES));
+            writeRatio(os, 12, count(stats, HardwareCounter::FP_OPS), cycles, available(HardwareCounter::FP_OPS));
+            os << "\n";
+        }
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void ExecutionController::PrintRoofline(std::ostream& os, double const peakBandwidth, double const peakFlopRate) const {
+    std::vector<KernelStats> kernels = KernelStatistics();
+    std::sort(kernels.begin(), kernels.end(), [](KernelStats const& a, KernelStats const& b) {
+        return a.seconds > b.seconds;
+    });
+    bool const measuredFlops = HardwareCounterAvailable(HardwareCounter::FP_OPS);
+    bool const measuredBytes = HardwareCounterAvailable(HardwareCounter::LLC_MISSES);
+    bool const haveRoof = peakBandwidth > 0.0 && peakFlopRate > 0.0;
+    double const ridge = haveRoof ? peakFlopRate / peakBandwidth : 0.0;
+
+    std::ios_base::fmtflags const flags = os.flags();
+    std::streamsize const precision = os.precision();
+    os << std::fixed << std::setprecision(2);
+
+    os << "Roofline, flops from " << (measuredFlops ? "counters" : "traits") << ", bytes from "
+       << (measuredBytes ? "LLC misses" : "traits");
+    if (haveRoof) {
+        os << ", ridge at " << ridge << " FLOP/byte";
+    }
+    os << "\n" << std::left << std::setw(32) << "Kernel" << std::right << std::setw(12) << "FLOP/byte"
+       << std::setw(10) << "GFLOP/s" << std::setw(10) << "Roof" << std::setw(10) << "% roof" << std::setw(10)
+       << "Bound" << "\n";
+    for (KernelStats const& stats : kernels) {
+        double const flops = measuredFlops ? static_cast<double>(stats.counters[static_cast<std::size_t>(HardwareCounter::FP_OPS)])
+                                           : stats.flops;
+        double const bytes = measuredBytes
+            ? CACHE_LINE_BYTES * stats.counters[static_cast<std::size_t>(HardwareCounter::LLC_MISSES)]
+            : stats.bytes;
+        double const flopRate = stats.seconds > 0.0 ? 1e-9 * flops / stats.seconds : 0.0;
+
+        os << std::left << std::setw(32) << stats.name << std::right;
+        writeRatio(os, 12, flops, bytes);
+        os << std::setw(10) << flopRate;
+        if (haveRoof && bytes > 0.0) {
+            double const intensity = flops / bytes;
+            double const roof = std::min(peakFlopRate, intensity * peakBandwidth);
+            writeRatio(os, 10, roof, 1.0);
+            writeRatio(os, 10, 100.0 * flopRate, roof);
+            os << std::setw(10) << (intensity < ridge ? "memory" : "compute");
+        } else {
+            os << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        os << "\n";
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void ExecutionController::WriteJson(std::string const& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+
+    file << std::setprecision(9) << "{\n  \"regions\": [";
+    for (std::size_t r = 0; r < m_regionStats.size(); ++r) {
+        RegionStats const& stats = m_regionStats[r];
+        file << (r > 0 ? "," : "") << "\n    {\"name\": ";
+        writeJsonString(file, stats.name);
+        file << ", \"calls\": " << stats.numCalls << ", \"seconds\": " << stats.seconds
+             << ", \"allocations\": " << stats.numAllocations << ", \"allocatedBytes\": " << stats.allocatedBytes << "}";
+    }
+    file << "\n  ],\n  \"kernels\": [";
+    std::vector<KernelStats> const kernels = KernelStatistics();
+    for (std::size_t k = 0; k < kernels.size(); ++k) {
+        KernelStats const& stats = kernels[k];
+        file << (k > 0 ? "," : "") << "\n    {\"name\": ";
+        writeJsonString(file, stats.name);
+        file << ", \"launches\": " << stats.numLaunches << ", \"items\": " << stats.numItems
+             << ", \"seconds\": " << stats.seconds << ", \"bytes\": " << stats.bytes << ", \"flops\": " << stats.flops;
+        if (m_hardwareCounters) {
+            file << ", \"counters\": {";
+            bool first = true;
+            for (std::size_t c = 0; c < NUM_HARDWARE_COUNTERS; ++c) {
+                if (HardwareCounterAvailable(static_cast<HardwareCounter>(c))) {
+                    file << (first ? "" : ", ") << "\"" << hardwareCounterName(static_cast<HardwareCounter>(c))
+                         << "\": " << stats.counters[c];
+                    first = false;
+                }
+            }
+            file << "}";
+        }
+        file << "}";
+    }
+    file << "\n  ],\n  \"hardwareCounters\": [";
+    bool first = true;
+    for (std::size_t c = 0; c < NUM_HARDWARE_COUNTERS; ++c) {
+        if (HardwareCounterAvailable(static_cast<HardwareCounter>(c))) {
+            file << (first ? "" : ", ") << "\"" << hardwareCounterName(static_cast<HardwareCounter>(c)) << "\"";
+            first = false;
+        }
+    }
+    file << "]\n}\n";
+
+    if (!file) {
+        throw Error::FILE_IO;
+    }
+}
+
+} // namespace MHD
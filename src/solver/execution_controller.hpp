@@ -1,31 +1,276 @@
 #pragma once
 
+#include <allocation_tracker.hpp>
+#include <perf_counters.hpp>
+#include <trace.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 namespace MHD {
 
+// Static description of a kernel, estimated per item for the instrumentation
+struct KernelTraits {
+    char const* name;
+    double bytesPerItem;    // compulsory memory traffic, each array read or written counted once
+    double flopsPerItem;
+};
+
+struct KernelStats {
+    std::string name;
+    std::size_t numLaunches = 0;
+    std::size_t numItems = 0;
+    double seconds = 0.0;
+    double bytes = 0.0;
+    double flops = 0.0;
+    CounterValues counters = {};    // hardware counts, only filled while counters are enabled
+};
+
+struct RegionStats {
+    std::string name;
+    std::size_t numCalls = 0;
+    double seconds = 0.0;
+    std::uint64_t numAllocations = 0;   // heap allocations by the calling thread inside the region
+    std::uint64_t allocatedBytes = 0;
+};
+
+template <typename Kernel, typename = void> struct HasKernelTraits : std::false_type {};
+template <typename Kernel> struct HasKernelTraits<Kernel, std::void_t<decltype(Kernel::TRAITS)>> : std::true_type {};
+
+std::string demangledTypeName(char const* mangledName);
+
+// Process-wide unique id of each controller, never reused, so a thread's cached slot cannot go stale
+std::size_t nextControllerId();
+
+inline std::size_t nextKernelId() {
+    static std::atomic<std::size_t> nextId{0};
+    return nextId++;
+}
+
+// Dense id per kernel type, shared by every controller in the process
+template <typename Kernel> std::size_t kernelId() {
+    static std::size_t const id = nextKernelId();
+    return id;
+}
+
+/**
+ * Launches kernels and keeps per-kernel launch counts, items, wall time and the estimated bytes
+ * and flops from each kernel's TRAITS. Stages made of several launches are timed with a
+ * ScopedRegion. Bookkeeping is two clock reads per launch, so it is always on. When the Tracer is
+ * enabled every launch and region is also recorded as a timeline event. Hardware counters are
+ * opt-in, reading them costs a few system calls per launch.
+ *
+ * Kernel statistics and hardware counters are kept per launching thread, so the workers of a task
+ * graph neither share a lock nor read each other's counters; they are merged when read.
+ */
 class ExecutionController {
 public:
+    using Clock = std::chrono::steady_clock;
+
+    class ScopedRegion {
+    public:
+        ScopedRegion(ExecutionController const& execCtrl, char const* name) :
+            m_name(name), m_stats(execCtrl.Region(name)), m_startAllocations(threadAllocationCounts()),
+            m_start(Clock::now()) {}
+
+        ~ScopedRegion() {
+            Clock::time_point const end = Clock::now();
+            AllocationCounts const allocations = threadAllocationCounts();
+            m_stats.seconds += std::chrono::duration<double>(end - m_start).count();
+            m_stats.numAllocations += allocations.numAllocations - m_startAllocations.numAllocations;
+            m_stats.allocatedBytes += allocations.numBytes - m_startAllocations.numBytes;
+            ++m_stats.numCalls;
+            if (Tracer::Enabled()) {
+                Tracer::Record(m_name, "stage", m_start, end);
+            }
+        }
+
+    private:
+        char const* m_name;
+        RegionStats& m_stats;
+        AllocationCounts const m_startAllocations;
+        Clock::time_point const m_start;
+    };
+
     template <typename Kernel> void LaunchKernel(Kernel& kernel, std::size_t const n) const {
+        LaunchStart const start = BeginLaunch();
         for (std::size_t i = 0; i < n; ++i) {
             kernel(i);
         }
+        Record<Kernel>(start, n);
     }
-    
+
     template <typename Kernel> void LaunchKernel(Kernel& kernel, std::size_t const m, std::size_t const n) const {
+        LaunchStart const start = BeginLaunch();
         for (std::size_t i = 0; i < m; ++i) {
             for (std::size_t j = 0; j < n; ++j) {
                 kernel(i, j);
             }
         }
+        Record<Kernel>(start, m * n);
     }
 
     template <typename Kernel> void LaunchKernel(Kernel& kernel, std::vector<std::size_t> const& idxs) const {
+        LaunchStart const start = BeginLaunch();
         for (std::size_t i : idxs) {
             kernel(i);
         }
+        Record<Kernel>(start, idxs.size());
+    }
+
+    // Sums kernel(i) over [0, n). Partial sums over fixed chunks are combined in chunk order, so the
+    // result does not depend on how the chunks are later distributed.
+    template <typename Kernel> double LaunchReduction(Kernel& kernel, std::size_t const n) const {
+        LaunchStart const start = BeginLaunch();
+        double sum = 0.0;
+        for (std::size_t begin = 0; begin < n; begin += REDUCTION_CHUNK_SIZE) {
+            std::size_t const end = std::min(n, begin + REDUCTION_CHUNK_SIZE);
+            double partial = 0.0;
+            for (std::size_t i = begin; i < end; ++i) {
+                partial += kernel(i);
+            }
+            sum += partial;
+        }
+        Record<Kernel>(start, n);
+        return sum;
+    }
+
+    static std::size_t constexpr REDUCTION_CHUNK_SIZE = 4096;
+
+    // Opens the hardware counters for the calling thread, and for every thread at its first launch
+    // from then on, false if none are available
+    bool EnableHardwareCounters();
+    bool HardwareCountersEnabled() const { return m_hardwareCounters; }
+    bool HardwareCounterAvailable(HardwareCounter const counter) const {
+        return m_hardwareCounters && m_countersAvailable[static_cast<std::size_t>(counter)];
+    }
+
+    // Statistics of every kernel and region used so far, in order of first use
+    std::vector<KernelStats> KernelStatistics() const;
+    std::vector<RegionStats> RegionStatistics() const { return {m_regionStats.begin(), m_regionStats.end()}; }
+    void ResetStatistics();
+
+    // Table sorted by time, with bandwidth and flop rates from the kernel traits
+    void PrintSummary(std::ostream& os) const;
+    void WriteJson(std::string const& filename) const;
+
+    /**
+     * Arithmetic intensity and attained rate of every kernel against the roofline of the given peaks
+     * (GB/s and GFLOP/s, zero when unknown). Measured flops and LLC miss traffic are used when the
+     * counters provide them, the kernel traits otherwise.
+     */
+    void PrintRoofline(std::ostream& os, double const peakBandwidth, double const peakFlopRate) const;
+
+private:
+    // Statistics of the launches made by one thread, and that thread's hardware counters
+    struct ThreadStats {
+        std::uint64_t thread = 0;
+        std::vector<KernelStats> kernelStats;    // by kernel id
+        std::vector<std::size_t> kernelOrder;
+        std::unique_ptr<PerfCounters> perfCounters;
+    };
+
+    struct LaunchStart {
+        ThreadStats* thread;
+        Clock::time_point time;
+        CounterValues counters;
+    };
+
+    // The calling thread's statistics; a thread mostly launches for one controller, which is cached
+    ThreadStats& LocalStats() const {
+        thread_local std::size_t t_controller = 0;
+        thread_local ThreadStats* t_stats = nullptr;
+        if (t_controller != m_id) {
+            t_stats = &RegisterThread();
+            t_controller = m_id;
+        }
+        return *t_stats;
+    }
+
+    ThreadStats& RegisterThread() const;
+
+    LaunchStart BeginLaunch() const {
+        LaunchStart start;
+        start.thread = &LocalStats();
+        if (start.thread->perfCounters) {
+            start.counters = start.thread->perfCounters->Read();
+        }
+        start.time = Clock::now();
+        return start;
+    }
+
+    template <typename Kernel> void Record(LaunchStart const& start, std::size_t const numItems) const {
+        Clock::time_point const end = Clock::now();
+        ThreadStats& local = *start.thread;
+        CounterValues const endCounters = local.perfCounters ? local.perfCounters->Read() : CounterValues{};
+        if (Tracer::Enabled()) {
+            Tracer::Record(TraceName<Kernel>(), "kernel", start.time, end, numItems);
+        }
+        double const seconds = std::chrono::duration<double>(end - start.time).count();
+
+        std::size_t const id = kernelId<Kernel>();
+        if (id >= local.kernelStats.size()) {
+            local.kernelStats.resize(id + 1);
+        }
+        KernelStats& stats = local.kernelStats[id];
+        if (stats.numLaunches == 0) {
+            if (stats.name.empty()) {
+                stats.name = KernelName<Kernel>();
+            }
+            local.kernelOrder.push_back(id);
+        }
+        ++stats.numLaunches;
+        stats.numItems += numItems;
+        stats.seconds += seconds;
+        if constexpr (HasKernelTraits<Kernel>::value) {
+            stats.bytes += Kernel::TRAITS.bytesPerItem * numItems;
+            stats.flops += Kernel::TRAITS.flopsPerItem * numItems;
+        }
+        if (local.perfCounters) {
+            // Multiplexed counts are extrapolated and can step backwards over a short launch
+            for (std::size_t c = 0; c < NUM_HARDWARE_COUNTERS; ++c) {
+                stats.counters[c] += endCounters[c] > start.counters[c] ? endCounters[c] - start.counters[c] : 0;
+            }
+        }
+    }
+
+    template <typename Kernel> static std::string KernelName() {
+        if constexpr (HasKernelTraits<Kernel>::value) {
+            return Kernel::TRAITS.name;
+        } else {
+            return demangledTypeName(typeid(Kernel).name());
+        }
     }
+
+    // Trace events keep the pointer, so the name has to live as long as the process
+    template <typename Kernel> static char const* TraceName() {
+        if constexpr (HasKernelTraits<Kernel>::value) {
+            return Kernel::TRAITS.name;
+        } else {
+            static std::string const name = KernelName<Kernel>();
+            return name.c_str();
+        }
+    }
+
+    RegionStats& Region(char const* name) const;
+
+    std::size_t const m_id = nextControllerId();
+    mutable std::mutex m_threadsMutex;
+    mutable std::deque<ThreadStats> m_threadStats;   // launches hold pointers, so entries must not move
+    mutable std::deque<RegionStats> m_regionStats;   // regions hold references, so entries must not move
+    bool m_hardwareCounters = false;
+    std::array<bool, NUM_HARDWARE_COUNTERS> m_countersAvailable = {};
 };
 
 } // namespace MHD
@@ -11,8 +11,11 @@
 
 namespace MHD {
 
+template <typename Real>
 struct KTFluxKernel {
-    KTFluxKernel(FluxContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"KTFlux", 4 * sizeof(double) + 28 * sizeof(Real), 180};
+
+    KTFluxKernel(FluxContext<Real>& context) : m_context(context) {}
 
     inline void operator()(std::size_t const i) {
         std::size_t const faceIdx = m_context.faceIdxs[i];
@@ -144,11 +147,12 @@ struct KTFluxKernel {
                                        maxEigenVal * (m_context.bzRight[faceIdx] - m_context.bzLeft[faceIdx]));
     }
 
-    FluxContext& m_context;
+    FluxContext<Real>& m_context;
 };
 
+template <typename Real>
 struct GodunovConstantFluxKernel {
-    GodunovConstantFluxKernel(FluxContext& context) : m_context(context) {}
+    GodunovConstantFluxKernel(FluxContext<Real>& context) : m_context(context) {}
 
     inline void operator()(std::size_t const i) {
         std::size_t const faceIdx = m_context.faceIdxs[i];
@@ -192,10 +196,11 @@ struct GodunovConstantFluxKernel {
                                       ((rhoELeft + m_context.pLeft[faceIdx]) * uDotNLeft);
     }
 
-    FluxContext& m_context;
+    FluxContext<Real>& m_context;
 };
 
-FluxContext::FluxContext(IGrid const& grid, ReconstructionContext const& rc) :
+template <typename Real>
+FluxContext<Real>::FluxContext(IGrid const& grid, ReconstructionContext<Real> const& rc) :
     numFaces(grid.NumFaces()), faceIdxToNodeIdxs(grid.FaceIdxToCellIdxs()), faceArea(grid.FaceAreas()),
     faceNormalX(grid.FaceNormalX()), faceNormalY(grid.FaceNormalY()), faceNormalZ(grid.FaceNormalZ()), faceIdxs(grid.FaceIdxs()),
     rhoLeft(rc.rhoLeft), uLeft(rc.uLeft), vLeft(rc.vLeft), wLeft(rc.wLeft), pLeft(rc.pLeft), eLeft(rc.eLeft), csLeft(rc.csLeft),
@@ -211,35 +216,51 @@ FluxContext::FluxContext(IGrid const& grid, ReconstructionContext const& rc) :
     bzFlux.resize(numFaces, 0.0);
 }
 
-class GodunovConstantFlux : public IFlux {
+template <typename Real>
+class GodunovConstantFlux : public IFlux<Real> {
 public:
-    GodunovConstantFlux(IGrid const& grid, ReconstructionContext const& rc) {
-        m_context = std::make_unique<FluxContext>(grid, rc);
+    GodunovConstantFlux(IGrid const& grid, ReconstructionContext<Real> const& rc) {
+        this->m_context = std::make_unique<FluxContext<Real>>(grid, rc);
     }
 
     void ComputeInterfaceFluxes(ExecutionController const& execCtrl) const {
-        GodunovConstantFluxKernel kern(*m_context);
-        execCtrl.LaunchKernel(kern, m_context->numFaces);
+        GodunovConstantFluxKernel<Real> kern(*this->m_context);
+        execCtrl.LaunchKernel(kern, this->m_context->numFaces);
+    }
+
+    void ComputeInterfaceFluxes(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) const {
+        GodunovConstantFluxKernel<Real> kern(*this->m_context);
+        execCtrl.LaunchKernel(kern, faces);
     }
 };
 
-class KTFlux : public IFlux {
+template <typename Real>
+class KTFlux : public IFlux<Real> {
 public:
-    KTFlux(IGrid const& grid, ReconstructionContext const& rc) {
-        m_context = std::make_unique<FluxContext>(grid, rc);
+    KTFlux(IGrid const& grid, ReconstructionContext<Real> const& rc) {
+        this->m_context = std::make_unique<FluxContext<Real>>(grid, rc);
     }
 
     void ComputeInterfaceFluxes(ExecutionController const& execCtrl) const {
-        KTFluxKernel kern(*m_context);
-        execCtrl.LaunchKernel(kern, m_context->numFaces);
+        KTFluxKernel<Real> kern(*this->m_context);
+        execCtrl.LaunchKernel(kern, this->m_context->numFaces);
+    }
+
+    void ComputeInterfaceFluxes(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) const {
+        KTFluxKernel<Real> kern(*this->m_context);
+        execCtrl.LaunchKernel(kern, faces);
     }
 };
 
-std::unique_ptr<IFlux> fluxFactory(Profile const& profile, IGrid const& grid, ReconstructionContext const& rc) {
+template <typename Real>
+std::unique_ptr<IFlux<Real>> fluxFactory(Profile const& profile, IGrid const& grid, ReconstructionContext<Real> const& rc) {
     if (FluxScheme::KT == profile.m_fluxOption) {
-        return std::make_unique<KTFlux>(grid, rc);
+        return std::make_unique<KTFlux<Real>>(grid, rc);
     }
     throw Error::INVALID_FLUX_SCHEME;
 }
 
+template std::unique_ptr<IFlux<double>> fluxFactory<double>(Profile const&, IGrid const&, ReconstructionContext<double> const&);
+template std::unique_ptr<IFlux<float>> fluxFactory<float>(Profile const&, IGrid const&, ReconstructionContext<float> const&);
+
 } // namespace MHD
\ No newline at end of file
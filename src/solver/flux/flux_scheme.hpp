@@ -7,13 +7,16 @@ namespace MHD {
 
 class ExecutionController;
 class Profile;
-class ReconstructionContext;
+template <typename Real>
+struct ReconstructionContext;
 
+// Face states and fluxes are stored as Real, the face geometry stays double
+template <typename Real>
 struct FluxContext {
-    FluxContext(IGrid const& grid, ReconstructionContext const& rc);
+    FluxContext(IGrid const& grid, ReconstructionContext<Real> const& rc);
 
     std::size_t const numFaces;
-    std::vector<std::size_t> const faceIdxs;
+    std::vector<std::size_t> const& faceIdxs;
     std::map<std::size_t, std::vector<std::size_t>> const& faceIdxToNodeIdxs;
 
     // properties of the faces
@@ -23,50 +26,55 @@ struct FluxContext {
     std::vector<double> const& faceNormalZ;
 
     // Face-centered left states
-    std::vector<double> const& rhoLeft;
-    std::vector<double> const& uLeft;
-    std::vector<double> const& vLeft;
-    std::vector<double> const& wLeft;
-    std::vector<double> const& pLeft;
-    std::vector<double> const& eLeft;
-    std::vector<double> const& csLeft;
-    std::vector<double> const& bxLeft;
-    std::vector<double> const& byLeft;
-    std::vector<double> const& bzLeft;
+    std::vector<Real> const& rhoLeft;
+    std::vector<Real> const& uLeft;
+    std::vector<Real> const& vLeft;
+    std::vector<Real> const& wLeft;
+    std::vector<Real> const& pLeft;
+    std::vector<Real> const& eLeft;
+    std::vector<Real> const& csLeft;
+    std::vector<Real> const& bxLeft;
+    std::vector<Real> const& byLeft;
+    std::vector<Real> const& bzLeft;
 
     // Face-centered right states
-    std::vector<double> const& rhoRight;
-    std::vector<double> const& uRight;
-    std::vector<double> const& vRight;
-    std::vector<double> const& wRight;
-    std::vector<double> const& pRight;
-    std::vector<double> const& eRight;
-    std::vector<double> const& csRight;
-    std::vector<double> const& bxRight;
-    std::vector<double> const& byRight;
-    std::vector<double> const& bzRight;
+    std::vector<Real> const& rhoRight;
+    std::vector<Real> const& uRight;
+    std::vector<Real> const& vRight;
+    std::vector<Real> const& wRight;
+    std::vector<Real> const& pRight;
+    std::vector<Real> const& eRight;
+    std::vector<Real> const& csRight;
+    std::vector<Real> const& bxRight;
+    std::vector<Real> const& byRight;
+    std::vector<Real> const& bzRight;
 
     // Face-centered fluxes
-    std::vector<double> rhoFlux;
-    std::vector<double> rhoUFlux;
-    std::vector<double> rhoVFlux;
-    std::vector<double> rhoWFlux;
-    std::vector<double> rhoEFlux;
-    std::vector<double> bxFlux;
-    std::vector<double> byFlux;
-    std::vector<double> bzFlux;
+    std::vector<Real> rhoFlux;
+    std::vector<Real> rhoUFlux;
+    std::vector<Real> rhoVFlux;
+    std::vector<Real> rhoWFlux;
+    std::vector<Real> rhoEFlux;
+    std::vector<Real> bxFlux;
+    std::vector<Real> byFlux;
+    std::vector<Real> bzFlux;
 };
 
+template <typename Real>
 class IFlux {
 public:
     virtual ~IFlux() = default;
     virtual void ComputeInterfaceFluxes(ExecutionController const& execCtrl) const = 0;
-    FluxContext const& GetContext() const { return *m_context; }
+
+    // Only the faces at the given positions in the face list, whose left and right states are ready
+    virtual void ComputeInterfaceFluxes(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) const = 0;
+    FluxContext<Real> const& GetContext() const { return *m_context; }
 
 protected:
-    std::unique_ptr<FluxContext> m_context;
+    std::unique_ptr<FluxContext<Real>> m_context;
 };
 
-std::unique_ptr<IFlux> fluxFactory(Profile const& profile, IGrid const& grid, ReconstructionContext const& rc);
+template <typename Real>
+std::unique_ptr<IFlux<Real>> fluxFactory(Profile const& profile, IGrid const& grid, ReconstructionContext<Real> const& rc);
 
 } // namespace MHD
\ No newline at end of file
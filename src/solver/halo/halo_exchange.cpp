@@ -0,0 +1,112 @@
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <halo/halo_exchange.hpp>
+#include <variable_store.hpp>
+
+namespace MHD {
+
+struct HaloPackKernel {
+    static constexpr KernelTraits TRAITS = {"HaloPack", 2 * HaloExchange::NUM_FIELDS * sizeof(double), 0};
+
+    HaloPackKernel(std::array<std::vector<double>*, HaloExchange::NUM_FIELDS> const& fields, HaloExchange::Side& side) :
+        m_fields(fields), m_side(side) {}
+
+    void operator()(std::size_t const k) {
+        std::size_t const i = m_side.sendIdxs[k];
+        double* values = m_side.sendBuffer.data() + k * HaloExchange::NUM_FIELDS;
+        for (std::size_t f = 0; f < HaloExchange::NUM_FIELDS; ++f) {
+            values[f] = (*m_fields[f])[i];
+        }
+    }
+
+    std::array<std::vector<double>*, HaloExchange::NUM_FIELDS> const& m_fields;
+    HaloExchange::Side& m_side;
+};
+
+struct HaloUnpackKernel {
+    static constexpr KernelTraits TRAITS = {"HaloUnpack", 2 * HaloExchange::NUM_FIELDS * sizeof(double), 0};
+
+    HaloUnpackKernel(std::array<std::vector<double>*, HaloExchange::NUM_FIELDS> const& fields, HaloExchange::Side& side) :
+        m_fields(fields), m_side(side) {}
+
+    void operator()(std::size_t const k) {
+        std::size_t const i = m_side.receiveIdxs[k];
+        double const* values = m_side.receiveBuffer.data() + k * HaloExchange::NUM_FIELDS;
+        for (std::size_t f = 0; f < HaloExchange::NUM_FIELDS; ++f) {
+            (*m_fields[f])[i] = values[f];
+        }
+    }
+
+    std::array<std::vector<double>*, HaloExchange::NUM_FIELDS> const& m_fields;
+    HaloExchange::Side& m_side;
+};
+
+Decomposition decompose1D(std::shared_ptr<ICommunicator> communicator, bool const periodic) {
+    int const rank = communicator->Rank();
+    int const size = communicator->Size();
+    Decomposition decomposition;
+    decomposition.communicator = std::move(communicator);
+
+    // A single rank keeps its own boundary conditions, periodic ones included
+    if (size == 1) {
+        decomposition.neighbourRanks = {NO_NEIGHBOUR, NO_NEIGHBOUR};
+        return decomposition;
+    }
+    decomposition.neighbourRanks = {
+        rank > 0 ? rank - 1 : (periodic ? size - 1 : NO_NEIGHBOUR),
+        rank + 1 < size ? rank + 1 : (periodic ? 0 : NO_NEIGHBOUR),
+    };
+    return decomposition;
+}
+
+HaloExchange::HaloExchange(IGrid const& grid, VariableStore& vs, Decomposition const& decomposition) :
+    m_communicator(*decomposition.communicator),
+    m_fields({&vs.rho, &vs.u, &vs.v, &vs.w, &vs.p, &vs.e, &vs.t, &vs.cs, &vs.bx, &vs.by, &vs.bz}) {
+    if (decomposition.neighbourRanks.size() != grid.NumBoundaries()) {
+        throw Error::INVALID_DECOMPOSITION;
+    }
+
+    // A message leaves through one side of its sender and arrives through the opposite side of its
+    // receiver, so tagging it with the sender's side tells the two apart when both neighbours are one rank
+    for (std::size_t b = 0; b < grid.NumBoundaries(); ++b) {
+        if (decomposition.neighbourRanks[b] < 0) {
+            continue;
+        }
+        Side side;
+        side.neighbourRank = decomposition.neighbourRanks[b];
+        side.sendTag = static_cast<int>(b);
+        side.receiveTag = static_cast<int>(grid.NumBoundaries() - 1 - b);
+
+        // Pairs of {interior k from the boundary, ghost layer k}, see Cartesian1DGrid
+        std::vector<std::size_t> const& pairs = grid.BoundaryIdxToCellIdxs().at(grid.BoundaryIdxs()[b]);
+        for (std::size_t k = 0; k < pairs.size(); k += 2) {
+            side.sendIdxs.push_back(pairs[k]);
+            side.receiveIdxs.push_back(pairs[k + 1]);
+            m_ghostIdxs.push_back(pairs[k + 1]);
+        }
+        side.sendBuffer.resize(side.sendIdxs.size() * NUM_FIELDS);
+        side.receiveBuffer.resize(side.receiveIdxs.size() * NUM_FIELDS);
+        m_sides.push_back(std::move(side));
+    }
+}
+
+void HaloExchange::Begin(ExecutionController const& execCtrl) {
+    for (Side& side : m_sides) {
+        m_communicator.PostReceive(side.neighbourRank, side.receiveTag, side.receiveBuffer.data(), side.receiveBuffer.size());
+    }
+    for (Side& side : m_sides) {
+        HaloPackKernel kernel(m_fields, side);
+        execCtrl.LaunchKernel(kernel, side.sendIdxs.size());
+        m_communicator.PostSend(side.neighbourRank, side.sendTag, side.sendBuffer.data(), side.sendBuffer.size());
+    }
+}
+
+void HaloExchange::End(ExecutionController const& execCtrl) {
+    m_communicator.WaitAll();
+    for (Side& side : m_sides) {
+        HaloUnpackKernel kernel(m_fields, side);
+        execCtrl.LaunchKernel(kernel, side.receiveIdxs.size());
+    }
+}
+
+} // namespace MHD
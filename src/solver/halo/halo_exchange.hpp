@@ -0,0 +1,64 @@
+#pragma once
+
+#include <communicator.hpp>
+#include <grid.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace MHD {
+
+class ExecutionController;
+class VariableStore;
+
+// Neighbour of a boundary whose ghost layers the owner of the solver fills itself, between steps
+int constexpr FILLED_BY_OWNER = -2;
+
+// Where a part of the domain sits among the ranks that share it
+struct Decomposition {
+    std::shared_ptr<ICommunicator> communicator; // may be null when no boundary has a neighbour rank
+    std::vector<int> neighbourRanks; // per boundary of the local grid, NO_NEIGHBOUR where the domain ends
+};
+
+// Contiguous parts of a 1D domain, one per rank, with periodic ends joined across the first and last rank
+Decomposition decompose1D(std::shared_ptr<ICommunicator> communicator, bool const periodic);
+
+/**
+ * Fills the ghost layers behind every boundary with a neighbour from the interior cells of that
+ * neighbour, in place of a boundary condition. Begin packs the primitive fields of the cells next
+ * to each such boundary and posts the messages; End waits for them and unpacks into the ghost
+ * cells. Anything that does not read those ghost cells may run in between.
+ */
+class HaloExchange {
+public:
+    HaloExchange(IGrid const& grid, VariableStore& vs, Decomposition const& decomposition);
+
+    void Begin(ExecutionController const& execCtrl);
+    void End(ExecutionController const& execCtrl);
+
+    // Ghost cells written by End, which nothing may read between Begin and End
+    std::vector<std::size_t> const& GhostIdxs() const { return m_ghostIdxs; }
+
+    // Primitive fields carried by the halo, the same ones the boundary conditions fill
+    static std::size_t constexpr NUM_FIELDS = 11;
+
+    struct Side {
+        int neighbourRank;
+        int sendTag;
+        int receiveTag;
+        std::vector<std::size_t> sendIdxs;     // interior cells, nearest the boundary first
+        std::vector<std::size_t> receiveIdxs;  // ghost cells, in the same order
+        std::vector<double> sendBuffer;
+        std::vector<double> receiveBuffer;
+    };
+
+private:
+    ICommunicator& m_communicator;
+    std::array<std::vector<double>*, NUM_FIELDS> m_fields;
+    std::vector<Side> m_sides;
+    std::vector<std::size_t> m_ghostIdxs;
+};
+
+} // namespace MHD
@@ -9,7 +9,8 @@
 namespace MHD {
 
 struct IntegrationContext {
-    IntegrationContext(ResidualContext const& rc, VariableStore& vs, double const& tStep) : 
+    template <typename Real>
+    IntegrationContext(ResidualContext<Real> const& rc, VariableStore& vs, double const& tStep) : 
         tStep(tStep), numCells(rc.numCells), rhoRes(rc.rhoRes), rhoURes(rc.rhoURes), rhoVRes(rc.rhoVRes),
         rhoWRes(rc.rhoWRes), rhoERes(rc.rhoERes), bxRes(rc.bxRes), byRes(rc.byRes), bzRes(rc.bzRes),
         rho(vs.rho), rhoU(vs.rhoU), rhoV(vs.rhoV), rhoW(vs.rhoW),
@@ -43,6 +44,9 @@ class IIntegrator {
 public:
     virtual ~IIntegrator() = default;
     virtual void Integrate(ExecutionController const& execCtrl) = 0;
+
+    // Only the given interior cells, whose residuals are ready
+    virtual void Integrate(ExecutionController const& execCtrl, std::vector<std::size_t> const& cells) = 0;
     IntegrationContext const& GetContext() const { return *m_context; }
 
 protected:
@@ -50,6 +54,8 @@ protected:
 };
 
 struct ForwardEulerKernel {
+    static constexpr KernelTraits TRAITS = {"ForwardEuler", 24 * sizeof(double), 16};
+
     ForwardEulerKernel(IntegrationContext const& context) : m_context(context) {}
 
     void operator()(std::size_t const i) {
@@ -68,7 +74,8 @@ struct ForwardEulerKernel {
 
 class ForwardEuler : public IIntegrator {
 public:
-    ForwardEuler(ResidualContext const& rc, VariableStore& vs, double const& tStep) {
+    template <typename Real>
+    ForwardEuler(ResidualContext<Real> const& rc, VariableStore& vs, double const& tStep) {
         m_context = std::make_unique<IntegrationContext>(rc, vs, tStep);
     }
 
@@ -76,9 +83,15 @@ public:
         ForwardEulerKernel kern(*m_context);
         execCtrl.LaunchKernel(kern, m_context->numCells);
     }
+
+    void Integrate(ExecutionController const& execCtrl, std::vector<std::size_t> const& cells) {
+        ForwardEulerKernel kern(*m_context);
+        execCtrl.LaunchKernel(kern, cells);
+    }
 };
 
-std::unique_ptr<IIntegrator> integratorFactory(ResidualContext const& rc, VariableStore& vs, double const& tStep) {
+template <typename Real>
+std::unique_ptr<IIntegrator> integratorFactory(ResidualContext<Real> const& rc, VariableStore& vs, double const& tStep) {
     return std::make_unique<ForwardEuler>(rc, vs, tStep);
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <error.hpp>
+#include <execution_controller.hpp>
 #include <variable_store.hpp>
 
 #include <cmath>
@@ -9,12 +11,14 @@
 namespace MHD {
 
 struct VelocityKernel {
+    static constexpr KernelTraits TRAITS = {"Velocity", 7 * sizeof(double), 4};
+
     VelocityKernel(VariableStore& vs) :
         rho(vs.rho), rhoU(vs.rhoU), rhoV(vs.rhoV), rhoW(vs.rhoW), u(vs.u), v(vs.v), w(vs.w) {}
     
     inline void operator()(std::size_t const i) {
         if (rho[i] < 0.0) {
-            throw;
+            throw Error::NON_PHYSICAL_STATE;
         }
         double const rhoInv = 1.0 / rho[i];
         u[i] = rhoU[i] * rhoInv;
@@ -32,6 +36,8 @@ struct VelocityKernel {
 };
 
 struct SpecificInternalEnergyKernel {
+    static constexpr KernelTraits TRAITS = {"SpecificInternalEnergy", 9 * sizeof(double), 17};
+
     SpecificInternalEnergyKernel(VariableStore& vs) :
         rho(vs.rho), rhoE(vs.rhoE), rhoU(vs.rhoU), rhoV(vs.rhoV), rhoW(vs.rhoW),
         bx(vs.bx), by(vs.by), bz(vs.bz), e(vs.e) {}
@@ -54,12 +60,14 @@ struct SpecificInternalEnergyKernel {
 };
 
 struct CaloricallyPerfectGasPressureKernel {
+    static constexpr KernelTraits TRAITS = {"Pressure", 6 * sizeof(double), 9};
+
     CaloricallyPerfectGasPressureKernel(VariableStore& vs) :
         gammaMinusOne(vs.gamma - 1.0), rho(vs.rho), e(vs.e), bx(vs.bx), by(vs.by), bz(vs.bz), p(vs.p) {}
 
     inline void operator()(std::size_t const i) {
         if (rho[i] < 0.0 || e[i] < 0.0) {
-            throw;
+            throw Error::NON_PHYSICAL_STATE;
         }
         p[i] = gammaMinusOne * rho[i] * e[i] + 0.5 * (bx[i] * bx[i] + by[i] * by[i] + bz[i] * bz[i]);
     }
@@ -74,6 +82,8 @@ struct CaloricallyPerfectGasPressureKernel {
 };
 
 struct CaloricallyPerfectGasTemperatureKernel {
+    static constexpr KernelTraits TRAITS = {"Temperature", 2 * sizeof(double), 2};
+
     CaloricallyPerfectGasTemperatureKernel(VariableStore& vs) :
         gammaMinusOne(vs.gamma - 1.0), rInv(1.0 / vs.r), e(vs.e), t(vs.t) {}
 
@@ -88,6 +98,8 @@ struct CaloricallyPerfectGasTemperatureKernel {
 };
 
 struct CaloricallyPerfectGasSoundSpeedKernel {
+    static constexpr KernelTraits TRAITS = {"SoundSpeed", 2 * sizeof(double), 2};
+
     CaloricallyPerfectGasSoundSpeedKernel(VariableStore& vs) :
         gammaTimesGammaMinusOne(vs.gamma * (vs.gamma - 1.0)), e(vs.e), cs(vs.cs) {}
 
@@ -101,6 +113,8 @@ struct CaloricallyPerfectGasSoundSpeedKernel {
 };
 
 struct MaximumWaveSpeedKernel {
+    static constexpr KernelTraits TRAITS = {"MaximumWaveSpeed", 2 * sizeof(double), 2};
+
     MaximumWaveSpeedKernel(VariableStore& vs) :
         u(vs.u), cs(vs.cs), sMax(vs.sMax) { sMax = 0.0; }
 
@@ -116,7 +130,29 @@ struct MaximumWaveSpeedKernel {
     double& sMax;
 };
 
+// The CFL limit of a stretched grid is set by the cell its fastest wave crosses soonest
+struct MaximumWaveRateKernel {
+    static constexpr KernelTraits TRAITS = {"MaximumWaveRate", 3 * sizeof(double), 3};
+
+    MaximumWaveRateKernel(VariableStore& vs, std::vector<double> const& cellWidths) :
+        u(vs.u), cs(vs.cs), cellWidths(cellWidths), sMaxOverWidth(vs.sMaxOverWidth) { sMaxOverWidth = 0.0; }
+
+    inline void operator()(std::size_t const i) {
+        double const waveRate = (std::abs(u[i]) + cs[i]) / cellWidths[i];
+        if (waveRate > sMaxOverWidth) {
+            sMaxOverWidth = waveRate;
+        }
+    }
+
+    std::vector<double> const& u;
+    std::vector<double> const& cs;
+    std::vector<double> const& cellWidths;
+    double& sMaxOverWidth;
+};
+
 struct MomentumDensityKernel {
+    static constexpr KernelTraits TRAITS = {"MomentumDensity", 7 * sizeof(double), 3};
+
     MomentumDensityKernel(VariableStore& vs) :
         rho(vs.rho), u(vs.u), v(vs.v), w(vs.w), rhoU(vs.rhoU), rhoV(vs.rhoV), rhoW(vs.rhoW) {}
     
@@ -136,6 +172,8 @@ struct MomentumDensityKernel {
 };
 
 struct TotalEnergyDensityKernel {
+    static constexpr KernelTraits TRAITS = {"TotalEnergyDensity", 9 * sizeof(double), 15};
+
     TotalEnergyDensityKernel(VariableStore& vs) :
         rho(vs.rho), u(vs.u), v(vs.v), w(vs.w), e(vs.e), bx(vs.bx), by(vs.by), bz(vs.bz), rhoE(vs.rhoE) {}
 
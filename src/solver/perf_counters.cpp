@@ -0,0 +1,132 @@
+#include <perf_counters.hpp>
+
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace MHD {
+
+namespace {
+
+#if defined(__linux__)
+bool isIntelCpu() {
+    std::ifstream cpuInfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuInfo, line)) {
+        if (line.compare(0, 9, "vendor_id") == 0) {
+            return line.find("GenuineIntel") != std::string::npos;
+        }
+    }
+    return false;
+}
+
+// FP_ARITH_INST_RETIRED umasks and the double-precision operations per instruction
+struct FpArithEvent {
+    std::uint64_t umask;
+    std::uint64_t weight;
+};
+
+FpArithEvent const FP_ARITH_EVENTS[] = {{0x01, 1}, {0x04, 2}, {0x10, 4}, {0x40, 8}};
+std::uint64_t constexpr FP_ARITH_INST_RETIRED = 0xc7;
+#endif
+
+} // namespace
+
+char const* hardwareCounterName(HardwareCounter const counter) {
+    switch (counter) {
+        case HardwareCounter::CYCLES: return "cycles";
+        case HardwareCounter::INSTRUCTIONS: return "instructions";
+        case HardwareCounter::LLC_REFERENCES: return "llcReferences";
+        case HardwareCounter::LLC_MISSES: return "llcMisses";
+        case HardwareCounter::FP_OPS: return "fpOps";
+    }
+    return "";
+}
+
+PerfCounters::PerfCounters() {
+#if defined(__linux__)
+    Open(HardwareCounter::CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    Open(HardwareCounter::INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    Open(HardwareCounter::LLC_REFERENCES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+    Open(HardwareCounter::LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+    if (isIntelCpu()) {
+        for (FpArithEvent const& event : FP_ARITH_EVENTS) {
+            Open(HardwareCounter::FP_OPS, PERF_TYPE_RAW, (event.umask << 8) | FP_ARITH_INST_RETIRED, event.weight);
+        }
+
+        // A partial set of widths would undercount, so use all of them or none
+        std::size_t numFpEvents = 0;
+        for (Event const& event : m_events) {
+            numFpEvents += HardwareCounter::FP_OPS == event.counter;
+        }
+        if (numFpEvents != sizeof(FP_ARITH_EVENTS) / sizeof(FP_ARITH_EVENTS[0])) {
+            for (auto it = m_events.begin(); it != m_events.end();) {
+                if (HardwareCounter::FP_OPS == it->counter) {
+                    close(it->fd);
+                    it = m_events.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            m_available[static_cast<std::size_t>(HardwareCounter::FP_OPS)] = false;
+        }
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for (Event const& event : m_events) {
+        close(event.fd);
+    }
+#endif
+}
+
+void PerfCounters::Open(HardwareCounter const counter, std::uint32_t const type, std::uint64_t const config,
+                        std::uint64_t const weight) {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // This thread on any CPU; failures (no PMU, paranoid setting, seccomp) leave the counter off
+    int const fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd < 0) {
+        return;
+    }
+    m_events.push_back({fd, counter, weight});
+    m_available[static_cast<std::size_t>(counter)] = true;
+#else
+    (void)counter, (void)type, (void)config, (void)weight;
+#endif
+}
+
+CounterValues PerfCounters::Read() const {
+    CounterValues values = {};
+#if defined(__linux__)
+    for (Event const& event : m_events) {
+        std::uint64_t data[3];   // value, time enabled, time running
+        if (read(event.fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+            continue;
+        }
+        double const scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        values[static_cast<std::size_t>(event.counter)] += event.weight * static_cast<std::uint64_t>(data[0] * scale);
+    }
+#endif
+    return values;
+}
+
+} // namespace MHD
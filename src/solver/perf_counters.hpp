@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MHD {
+
+enum class HardwareCounter {
+    CYCLES,
+    INSTRUCTIONS,
+    LLC_REFERENCES,
+    LLC_MISSES,
+    FP_OPS,         // double-precision operations, packed instructions weighted by their width
+};
+
+std::size_t constexpr NUM_HARDWARE_COUNTERS = 5;
+
+using CounterValues = std::array<std::uint64_t, NUM_HARDWARE_COUNTERS>;
+
+char const* hardwareCounterName(HardwareCounter const counter);
+
+/**
+ * Per-thread hardware counters of the calling process through Linux perf_event_open, user space
+ * only. Every event is opened on its own, so counters the PMU, the kernel or the container does not
+ * provide are simply unavailable and the rest still count. Floating-point events are model specific
+ * and only opened on Intel cores with FP_ARITH_INST_RETIRED.
+ *
+ * Counts are scaled by enabled over running time in case the kernel multiplexes the events.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    bool Available(HardwareCounter const counter) const { return m_available[static_cast<std::size_t>(counter)]; }
+    bool AnyAvailable() const { return !m_events.empty(); }
+
+    // Running totals since construction, zero for unavailable counters
+    CounterValues Read() const;
+
+private:
+    struct Event {
+        int fd;
+        HardwareCounter counter;
+        std::uint64_t weight;
+    };
+
+    void Open(HardwareCounter const counter, std::uint32_t const type, std::uint64_t const config,
+              std::uint64_t const weight = 1);
+
+    std::vector<Event> m_events;
+    std::array<bool, NUM_HARDWARE_COUNTERS> m_available = {};
+};
+
+} // namespace MHD
@@ -4,6 +4,7 @@
 #include <reconstruction/reconstruction.hpp>
 #include <variable_store.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cmath>
@@ -11,15 +12,16 @@
 
 namespace MHD {
 
+template <typename Real>
 struct ConstantReconstructionKernel {
-    ConstantReconstructionKernel(ReconstructionContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"ConstantReconstruction", 7 * sizeof(double) + 14 * sizeof(Real), 0};
 
-    void operator()(std::size_t const i) {
-        std::size_t const faceIdx = m_context.faceIdxs[i];
+    ConstantReconstructionKernel(ReconstructionContext<Real>& context) : m_context(context) {}
 
+    void operator()(std::size_t const i) {
         // Get the left and right cell indices for this face
-        std::size_t const iLeft = m_context.faceIdxToNodeIdxs.at(faceIdx)[0];
-        std::size_t const iRight = m_context.faceIdxToNodeIdxs.at(faceIdx)[1];
+        std::size_t const iLeft = m_context.faceStencils[i][0];
+        std::size_t const iRight = m_context.faceStencils[i][1];
 
         m_context.rhoLeft[i] = m_context.rho[iLeft];
         m_context.uLeft[i] = m_context.u[iLeft];
@@ -38,18 +40,19 @@ struct ConstantReconstructionKernel {
         m_context.csRight[i] = m_context.cs[iRight];
     }
 
-    ReconstructionContext& m_context;
+    ReconstructionContext<Real>& m_context;
 };
 
+template <typename Real>
 struct LinearReconstructionKernel {
-    LinearReconstructionKernel(ReconstructionContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"LinearReconstruction", 7 * sizeof(double) + 14 * sizeof(Real), 28};
+
+    LinearReconstructionKernel(ReconstructionContext<Real>& context) : m_context(context) {}
     
     void operator()(std::size_t const i) {
-        std::size_t const faceIdx = m_context.faceIdxs[i];
-        
         // Get the left and right cell indices for this face
-        std::size_t const iLeft = m_context.faceIdxToNodeIdxs.at(faceIdx)[0];
-        std::size_t const iRight = m_context.faceIdxToNodeIdxs.at(faceIdx)[1];
+        std::size_t const iLeft = m_context.faceStencils[i][0];
+        std::size_t const iRight = m_context.faceStencils[i][1];
         
         m_context.rhoLeft[i] = 0.5 * (m_context.rho[iLeft] + m_context.rho[iRight]);
         m_context.uLeft[i] = 0.5 * (m_context.u[iLeft] + m_context.u[iRight]);
@@ -68,7 +71,7 @@ struct LinearReconstructionKernel {
         m_context.csRight[i] = 0.5 * (m_context.cs[iLeft] + m_context.cs[iRight]);
     }
     
-    ReconstructionContext& m_context;
+    ReconstructionContext<Real>& m_context;
 };
 
 double vanLeer(double const r) {
@@ -78,16 +81,17 @@ double vanLeer(double const r) {
     return (r + std::abs(r)) / (1.0 + std::abs(r));
 }
 
+template <typename Real>
 struct MUSCLReconstructionKernel {
-    MUSCLReconstructionKernel(ReconstructionContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"MUSCLReconstruction", 10 * sizeof(double) + 20 * sizeof(Real), 440};
 
-    void operator()(std::size_t const i) {
-        std::size_t const iFace = m_context.faceIdxs.at(i);
+    MUSCLReconstructionKernel(ReconstructionContext<Real>& context) : m_context(context) {}
 
-        std::size_t const iLeft = m_context.faceIdxToNodeIdxs.at(i)[0];
-        std::size_t const iRight = m_context.faceIdxToNodeIdxs.at(i)[1];
-        std::size_t const iLeftMinusOne = m_context.faceIdxToNodeIdxs.at(i)[2];
-        std::size_t const iRightPlusOne = m_context.faceIdxToNodeIdxs.at(i)[3];
+    void operator()(std::size_t const i) {
+        std::size_t const iLeft = m_context.faceStencils[i][0];
+        std::size_t const iRight = m_context.faceStencils[i][1];
+        std::size_t const iLeftMinusOne = m_context.faceStencils[i][2];
+        std::size_t const iRightPlusOne = m_context.faceStencils[i][3];
 
         double rLeftRho = (m_context.rho[iRight] - m_context.rho[iLeft]) / (m_context.rho[iLeft] - m_context.rho[iLeftMinusOne]);
         double rLeftU = (m_context.u[iRight] - m_context.u[iLeft]) / (m_context.u[iLeft] - m_context.u[iLeftMinusOne]);
@@ -198,16 +202,122 @@ struct MUSCLReconstructionKernel {
                                                                     (1.0 - m_kappa) * phiRightBzInv * (m_context.bz[iRightPlusOne] - m_context.bz[iRight]));
     }
 
-    ReconstructionContext& m_context;
+    ReconstructionContext<Real>& m_context;
     double const m_phi = 1.0;
     double const m_kappa = 1.0 / 3.0;
 };
 
-ReconstructionContext::ReconstructionContext(VariableStore const& vs, IGrid const& grid) :
+template <typename Real>
+struct StretchedLinearReconstructionKernel {
+    static constexpr KernelTraits TRAITS = {"StretchedLinearReconstruction", 9 * sizeof(double) + 14 * sizeof(Real), 31};
+
+    StretchedLinearReconstructionKernel(ReconstructionContext<Real>& context) : m_context(context) {}
+
+    void operator()(std::size_t const i) {
+        std::size_t const iLeft = m_context.faceStencils[i][0];
+        std::size_t const iRight = m_context.faceStencils[i][1];
+
+        // Interpolated to the face, which lies nearer the centre of the narrower cell
+        double const widthLeft = m_context.faceGeometry[i][0];
+        double const widthRight = m_context.faceGeometry[i][1];
+        double const weightLeft = widthRight / (widthLeft + widthRight);
+        double const weightRight = widthLeft / (widthLeft + widthRight);
+        auto interpolate = [&](std::vector<double> const& q, std::vector<Real>& left, std::vector<Real>& right) {
+            left[i] = right[i] = weightLeft * q[iLeft] + weightRight * q[iRight];
+        };
+
+        interpolate(m_context.rho, m_context.rhoLeft, m_context.rhoRight);
+        interpolate(m_context.u, m_context.uLeft, m_context.uRight);
+        interpolate(m_context.v, m_context.vLeft, m_context.vRight);
+        interpolate(m_context.w, m_context.wLeft, m_context.wRight);
+        interpolate(m_context.p, m_context.pLeft, m_context.pRight);
+        interpolate(m_context.e, m_context.eLeft, m_context.eRight);
+        interpolate(m_context.cs, m_context.csLeft, m_context.csRight);
+    }
+
+    ReconstructionContext<Real>& m_context;
+};
+
+// Value at a face offset from a cell centre, from the slopes per unit length towards the cells below
+// and above, limited as in the uniform kappa scheme with the differences taken across the cell. On
+// even spacing the limiter keeps the offset within both differences to the neighbouring cells, which
+// bounds the CFL number of a monotone step, but a cell wider than a neighbour would carry its slope
+// past them, so the offset is held to those differences
+double stretchedFaceValue(double const centre, double const behind, double const across, double const offset,
+                          double const slopeBelow, double const slopeAbove, double const kappa) {
+    double const r = slopeAbove / slopeBelow;
+    double const side = offset > 0.0 ? 1.0 : -1.0;
+    double const change = 0.5 * offset * ((1.0 - side * kappa) * vanLeer(r) * slopeBelow +
+                                          (1.0 + side * kappa) * vanLeer(1.0 / r) * slopeAbove);
+    double const bound = std::min(std::abs(across - centre), std::abs(centre - behind));
+    return centre + std::clamp(change, -bound, bound);
+}
+
+template <typename Real>
+struct StretchedMUSCLReconstructionKernel {
+    static constexpr KernelTraits TRAITS = {"StretchedMUSCLReconstruction", 15 * sizeof(double) + 20 * sizeof(Real), 460};
+
+    StretchedMUSCLReconstructionKernel(ReconstructionContext<Real>& context) : m_context(context) {}
+
+    void operator()(std::size_t const i) {
+        std::size_t const iLeft = m_context.faceStencils[i][0];
+        std::size_t const iRight = m_context.faceStencils[i][1];
+        std::size_t const iLeftMinusOne = m_context.faceStencils[i][2];
+        std::size_t const iRightPlusOne = m_context.faceStencils[i][3];
+        std::array<double, 5> const& geometry = m_context.faceGeometry[i];
+
+        auto reconstruct = [&](std::vector<double> const& q, std::vector<Real>& left, std::vector<Real>& right) {
+            double const slopeLeft = (q[iLeft] - q[iLeftMinusOne]) * geometry[2];
+            double const slopeFace = (q[iRight] - q[iLeft]) * geometry[3];
+            double const slopeRight = (q[iRightPlusOne] - q[iRight]) * geometry[4];
+            left[i] = stretchedFaceValue(q[iLeft], q[iLeftMinusOne], q[iRight], 0.5 * geometry[0],
+                                         slopeLeft, slopeFace, m_kappa);
+            right[i] = stretchedFaceValue(q[iRight], q[iRightPlusOne], q[iLeft], -0.5 * geometry[1],
+                                          slopeFace, slopeRight, m_kappa);
+        };
+
+        reconstruct(m_context.rho, m_context.rhoLeft, m_context.rhoRight);
+        reconstruct(m_context.u, m_context.uLeft, m_context.uRight);
+        reconstruct(m_context.v, m_context.vLeft, m_context.vRight);
+        reconstruct(m_context.w, m_context.wLeft, m_context.wRight);
+        reconstruct(m_context.p, m_context.pLeft, m_context.pRight);
+        reconstruct(m_context.e, m_context.eLeft, m_context.eRight);
+        reconstruct(m_context.cs, m_context.csLeft, m_context.csRight);
+        reconstruct(m_context.bx, m_context.bxLeft, m_context.bxRight);
+        reconstruct(m_context.by, m_context.byLeft, m_context.byRight);
+        reconstruct(m_context.bz, m_context.bzLeft, m_context.bzRight);
+    }
+
+    ReconstructionContext<Real>& m_context;
+    double const m_kappa = 1.0 / 3.0;
+};
+
+template <typename Real>
+ReconstructionContext<Real>::ReconstructionContext(VariableStore const& vs, IGrid const& grid) :
     rho(vs.rho), u(vs.u), v(vs.v), w(vs.w), p(vs.p), e(vs.e), cs(vs.cs),
     faceIdxToNodeIdxs(grid.FaceIdxToCellIdxs()), numFaces(grid.NumFaces()), faceIdxs(grid.FaceIdxs()),
     bx(vs.bx), by(vs.by), bz(vs.bz) {
         std::size_t const size = numFaces;
+        faceStencils.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            std::vector<std::size_t> const& nodeIdxs = faceIdxToNodeIdxs.at(faceIdxs[i]);
+            faceStencils.push_back({nodeIdxs[0], nodeIdxs[1], nodeIdxs[2], nodeIdxs[3]});
+        }
+        if (!grid.IsUniform()) {
+            // Centres of neighbouring cells lie half of each width apart, which unlike their positions does
+            // not depend on where a part of a periodic domain sits. The outermost ghost layer stands in
+            // for the layer beyond it, which lies at no distance
+            auto const& widths = grid.CellWidths();
+            auto inverseDistance = [&widths](std::size_t const lower, std::size_t const upper) {
+                return lower == upper ? 0.0 : 2.0 / (widths[lower] + widths[upper]);
+            };
+            faceGeometry.reserve(size);
+            for (auto const& stencil : faceStencils) {
+                faceGeometry.push_back({grid.CellWidths()[stencil[0]], grid.CellWidths()[stencil[1]],
+                                        inverseDistance(stencil[2], stencil[0]), inverseDistance(stencil[0], stencil[1]),
+                                        inverseDistance(stencil[1], stencil[3])});
+            }
+        }
         rhoLeft.resize(size, 0.0);
         uLeft.resize(size, 0.0);
         vLeft.resize(size, 0.0);
@@ -230,53 +340,128 @@ ReconstructionContext::ReconstructionContext(VariableStore const& vs, IGrid cons
         bzRight.resize(size, 0.0);
 }
 
-class ConstantReconstruction : public IReconstruction {
+template <typename Real>
+class ConstantReconstruction : public IReconstruction<Real> {
 public:
     ConstantReconstruction(VariableStore const& varStore, IGrid const& grid) {
-        m_context = std::make_unique<ReconstructionContext>(varStore, grid);
+        this->m_context = std::make_unique<ReconstructionContext<Real>>(varStore, grid);
     }
     
     void ComputeLeftRightStates(ExecutionController const& execCtrl) {
-        ConstantReconstructionKernel kernel(*m_context);
-        execCtrl.LaunchKernel(kernel, m_context->numFaces);
+        ConstantReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, this->m_context->numFaces);
+    }
+
+    void ComputeLeftRightStates(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) {
+        ConstantReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, faces);
     }
 };
 
-class LinearReconstruction : public IReconstruction {
+template <typename Real>
+class LinearReconstruction : public IReconstruction<Real> {
 public:
     LinearReconstruction(VariableStore const& varStore, IGrid const& grid) {
-        m_context = std::make_unique<ReconstructionContext>(varStore, grid);
+        this->m_context = std::make_unique<ReconstructionContext<Real>>(varStore, grid);
     }
     
     void ComputeLeftRightStates(ExecutionController const& execCtrl) {
-        LinearReconstructionKernel kernel(*m_context);
-        execCtrl.LaunchKernel(kernel, m_context->numFaces);
+        LinearReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, this->m_context->numFaces);
+    }
+
+    void ComputeLeftRightStates(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) {
+        LinearReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, faces);
     }
 };
 
-class MUSCLReconstruction : public IReconstruction {
+template <typename Real>
+class MUSCLReconstruction : public IReconstruction<Real> {
     public:
         MUSCLReconstruction(VariableStore const& varStore, IGrid const& grid) {
-            m_context = std::make_unique<ReconstructionContext>(varStore, grid);
+            this->m_context = std::make_unique<ReconstructionContext<Real>>(varStore, grid);
         }
         
         void ComputeLeftRightStates(ExecutionController const& execCtrl) {
-            MUSCLReconstructionKernel kernel(*m_context);
-            execCtrl.LaunchKernel(kernel, m_context->numFaces);
+            MUSCLReconstructionKernel<Real> kernel(*this->m_context);
+            execCtrl.LaunchKernel(kernel, this->m_context->numFaces);
+        }
+
+        void ComputeLeftRightStates(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) {
+            MUSCLReconstructionKernel<Real> kernel(*this->m_context);
+            execCtrl.LaunchKernel(kernel, faces);
         }
     };
 
-std::unique_ptr<IReconstruction> reconstructionFactory(Profile const& profile, VariableStore const& varStore, IGrid const& grid) {
+template <typename Real>
+class StretchedLinearReconstruction : public IReconstruction<Real> {
+public:
+    StretchedLinearReconstruction(VariableStore const& varStore, IGrid const& grid) {
+        this->m_context = std::make_unique<ReconstructionContext<Real>>(varStore, grid);
+    }
+
+    void ComputeLeftRightStates(ExecutionController const& execCtrl) {
+        StretchedLinearReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, this->m_context->numFaces);
+    }
+
+    void ComputeLeftRightStates(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) {
+        StretchedLinearReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, faces);
+    }
+};
+
+template <typename Real>
+class StretchedMUSCLReconstruction : public IReconstruction<Real> {
+public:
+    StretchedMUSCLReconstruction(VariableStore const& varStore, IGrid const& grid) {
+        this->m_context = std::make_unique<ReconstructionContext<Real>>(varStore, grid);
+    }
+
+    void ComputeLeftRightStates(ExecutionController const& execCtrl) {
+        StretchedMUSCLReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, this->m_context->numFaces);
+    }
+
+    void ComputeLeftRightStates(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) {
+        StretchedMUSCLReconstructionKernel<Real> kernel(*this->m_context);
+        execCtrl.LaunchKernel(kernel, faces);
+    }
+};
+
+template <typename Real>
+std::unique_ptr<IReconstruction<Real>> reconstructionFactory(Profile const& profile, VariableStore const& varStore, IGrid const& grid) {
     if (ReconstructionOption::CONSTANT == profile.m_reconstructionOption) {
-        return std::make_unique<ConstantReconstruction>(varStore, grid);
+        return std::make_unique<ConstantReconstruction<Real>>(varStore, grid);
     }
     if (ReconstructionOption::LINEAR == profile.m_reconstructionOption) {
-        return std::make_unique<LinearReconstruction>(varStore, grid);
+        if (!grid.IsUniform()) {
+            return std::make_unique<StretchedLinearReconstruction<Real>>(varStore, grid);
+        }
+        return std::make_unique<LinearReconstruction<Real>>(varStore, grid);
     }
     if (ReconstructionOption::MUSCL == profile.m_reconstructionOption) {
-        return std::make_unique<MUSCLReconstruction>(varStore, grid);
+        if (!grid.IsUniform()) {
+            return std::make_unique<StretchedMUSCLReconstruction<Real>>(varStore, grid);
+        }
+        return std::make_unique<MUSCLReconstruction<Real>>(varStore, grid);
     }
     throw Error::INVALID_RECONSTRUCTION_OPTION;
 }
+
+std::size_t reconstructionStencilReach(Profile const& profile) {
+    if (ReconstructionOption::CONSTANT == profile.m_reconstructionOption ||
+        ReconstructionOption::LINEAR == profile.m_reconstructionOption) {
+        return 1;
+    }
+    if (ReconstructionOption::MUSCL == profile.m_reconstructionOption) {
+        return 2;
+    }
+    throw Error::INVALID_RECONSTRUCTION_OPTION;
+}
+
+template std::unique_ptr<IReconstruction<double>> reconstructionFactory<double>(Profile const&, VariableStore const&, IGrid const&);
+template std::unique_ptr<IReconstruction<float>> reconstructionFactory<float>(Profile const&, VariableStore const&, IGrid const&);
     
 } // namespace MHD
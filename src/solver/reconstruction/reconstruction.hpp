@@ -1,7 +1,10 @@
 #pragma once
 
 #include <grid.hpp>
+
+#include <array>
 #include <memory>
+#include <vector>
 
 namespace MHD {
 
@@ -9,13 +12,22 @@ class ExecutionController;
 class Profile;
 class VariableStore;
 
+// Face states are stored as Real, float in mixed precision, while the cell states they come from stay double
+template <typename Real>
 struct ReconstructionContext {
     ReconstructionContext(VariableStore const& vs, IGrid const& grid);
 
     std::size_t const numFaces;
-    std::vector<std::size_t> const faceIdxs;
+    std::vector<std::size_t> const& faceIdxs;
     std::map<std::size_t, std::vector<std::size_t>> const& faceIdxToNodeIdxs;
 
+    // Left, right, left - 1 and right + 1 node of each face, flattened from the map once at setup
+    std::vector<std::array<std::size_t, 4>> faceStencils;
+
+    // On a stretched grid, the widths of the left and right cell of each face and the inverse
+    // distances between the centres of left - 1 and left, left and right, and right and right + 1
+    std::vector<std::array<double, 5>> faceGeometry;
+
     // Cell-centered states
     std::vector<double> const& rho;
     std::vector<double> const& u;
@@ -29,40 +41,49 @@ struct ReconstructionContext {
     std::vector<double> const& bz;
 
     // Left states
-    std::vector<double> rhoLeft;
-    std::vector<double> uLeft;
-    std::vector<double> vLeft;
-    std::vector<double> wLeft;
-    std::vector<double> pLeft;
-    std::vector<double> eLeft;
-    std::vector<double> csLeft;
-    std::vector<double> bxLeft;
-    std::vector<double> byLeft;
-    std::vector<double> bzLeft;
+    std::vector<Real> rhoLeft;
+    std::vector<Real> uLeft;
+    std::vector<Real> vLeft;
+    std::vector<Real> wLeft;
+    std::vector<Real> pLeft;
+    std::vector<Real> eLeft;
+    std::vector<Real> csLeft;
+    std::vector<Real> bxLeft;
+    std::vector<Real> byLeft;
+    std::vector<Real> bzLeft;
 
     // Right states
-    std::vector<double> rhoRight;
-    std::vector<double> uRight;
-    std::vector<double> vRight;
-    std::vector<double> wRight;
-    std::vector<double> pRight;
-    std::vector<double> eRight;
-    std::vector<double> csRight;
-    std::vector<double> bxRight;
-    std::vector<double> byRight;
-    std::vector<double> bzRight;
+    std::vector<Real> rhoRight;
+    std::vector<Real> uRight;
+    std::vector<Real> vRight;
+    std::vector<Real> wRight;
+    std::vector<Real> pRight;
+    std::vector<Real> eRight;
+    std::vector<Real> csRight;
+    std::vector<Real> bxRight;
+    std::vector<Real> byRight;
+    std::vector<Real> bzRight;
 };
 
+template <typename Real>
 class IReconstruction {
 public:
     virtual ~IReconstruction() = default;
     virtual void ComputeLeftRightStates(ExecutionController const& execCtrl) = 0;
-    ReconstructionContext const& GetContext() const { return *m_context; }
+
+    // Only the faces at the given positions in the face list, so a step can finish the rest later
+    virtual void ComputeLeftRightStates(ExecutionController const& execCtrl, std::vector<std::size_t> const& faces) = 0;
+    ReconstructionContext<Real> const& GetContext() const { return *m_context; }
 
 protected:
-    std::unique_ptr<ReconstructionContext> m_context;
+    std::unique_ptr<ReconstructionContext<Real>> m_context;
 };
 
-std::unique_ptr<IReconstruction> reconstructionFactory(Profile const& profile, VariableStore const& varStore, IGrid const& grid);
+template <typename Real>
+std::unique_ptr<IReconstruction<Real>> reconstructionFactory(Profile const& profile, VariableStore const& varStore, IGrid const& grid);
+
+// Cells on either side of a face that its states are reconstructed from, which the ghost layers
+// must hold wherever they stand in for cells of the domain, i.e. across periodic ends and ranks
+std::size_t reconstructionStencilReach(Profile const& profile);
 
 } // namespace MHD
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <error.hpp>
+#include <reference/exact_riemann.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace MHD {
+
+namespace {
+
+std::size_t constexpr MAX_NEWTON_ITERATIONS = 100;
+double constexpr PRESSURE_TOLERANCE = 1e-12;
+
+} // namespace
+
+ExactRiemannSolver::ExactRiemannSolver(GasState const& left, GasState const& right, double const gamma) :
+    m_left(left), m_right(right), m_gamma(gamma),
+    m_cLeft(std::sqrt(gamma * left.p / left.rho)), m_cRight(std::sqrt(gamma * right.p / right.rho)) {
+    double const du = m_right.u - m_left.u;
+    if (2.0 * (m_cLeft + m_cRight) / (m_gamma - 1.0) <= du) {
+        throw Error::INVALID_INITIAL_CONDITION;
+    }
+
+    // Primitive-variable linearisation as the starting guess
+    double const pPvrs = 0.5 * (m_left.p + m_right.p) -
+                         0.125 * du * (m_left.rho + m_right.rho) * (m_cLeft + m_cRight);
+    double p = std::max(PRESSURE_TOLERANCE, pPvrs);
+
+    for (std::size_t iteration = 0; iteration < MAX_NEWTON_ITERATIONS; ++iteration) {
+        double fLeft, dfLeft, fRight, dfRight;
+        PressureFunction(m_left, m_cLeft, p, fLeft, dfLeft);
+        PressureFunction(m_right, m_cRight, p, fRight, dfRight);
+        double const pNext = std::max(PRESSURE_TOLERANCE, p - (fLeft + fRight + du) / (dfLeft + dfRight));
+        double const change = 2.0 * std::abs(pNext - p) / (pNext + p);
+        p = pNext;
+        if (change < PRESSURE_TOLERANCE) {
+            break;
+        }
+    }
+
+    double fLeft, dfLeft, fRight, dfRight;
+    PressureFunction(m_left, m_cLeft, p, fLeft, dfLeft);
+    PressureFunction(m_right, m_cRight, p, fRight, dfRight);
+    m_pStar = p;
+    m_uStar = 0.5 * (m_left.u + m_right.u) + 0.5 * (fRight - fLeft);
+}
+
+void ExactRiemannSolver::PressureFunction(GasState const& state, double const soundSpeed, double const p,
+                                          double& f, double& df) const {
+    if (p > state.p) {
+        // Shock
+        double const a = 2.0 / ((m_gamma + 1.0) * state.rho);
+        double const b = (m_gamma - 1.0) / (m_gamma + 1.0) * state.p;
+        double const root = std::sqrt(a / (p + b));
+        f = (p - state.p) * root;
+        df = root * (1.0 - 0.5 * (p - state.p) / (p + b));
+    } else {
+        // Rarefaction
+        double const exponent = 0.5 * (m_gamma - 1.0) / m_gamma;
+        double const ratio = p / state.p;
+        f = 2.0 * soundSpeed / (m_gamma - 1.0) * (std::pow(ratio, exponent) - 1.0);
+        df = 1.0 / (state.rho * soundSpeed) * std::pow(ratio, -0.5 * (m_gamma + 1.0) / m_gamma);
+    }
+}
+
+GasState ExactRiemannSolver::Sample(double const xOverT) const {
+    double const g = m_gamma;
+    double const gm = (g - 1.0) / (g + 1.0);
+
+    // Mirror the right side onto the left so both are sampled by the same expressions
+    bool const leftOfContact = xOverT <= m_uStar;
+    double const sign = leftOfContact ? 1.0 : -1.0;
+    GasState const& side = leftOfContact ? m_left : m_right;
+    double const c = leftOfContact ? m_cLeft : m_cRight;
+    double const s = sign * xOverT;
+    double const u = sign * side.u;
+    double const uStar = sign * m_uStar;
+
+    if (m_pStar > side.p) {
+        // Shock
+        double const pRatio = m_pStar / side.p;
+        double const shockSpeed = u - c * std::sqrt(0.5 * (g + 1.0) / g * pRatio + 0.5 * (g - 1.0) / g);
+        if (s <= shockSpeed) {
+            return side;
+        }
+        double const rhoStar = side.rho * (pRatio + gm) / (gm * pRatio + 1.0);
+        return {rhoStar, m_uStar, m_pStar};
+    }
+
+    // Rarefaction fan between head and tail
+    double const cStar = c * std::pow(m_pStar / side.p, 0.5 * (g - 1.0) / g);
+    double const head = u - c;
+    double const tail = uStar - cStar;
+    if (s <= head) {
+        return side;
+    }
+    if (s >= tail) {
+        return {side.rho * std::pow(m_pStar / side.p, 1.0 / g), m_uStar, m_pStar};
+    }
+    double const fanC = 2.0 / (g + 1.0) * (c + 0.5 * (g - 1.0) * (u - s));
+    double const rho = side.rho * std::pow(fanC / c, 2.0 / (g - 1.0));
+    double const fanU = 2.0 / (g + 1.0) * (c + 0.5 * (g - 1.0) * u + s);
+    return {rho, sign * fanU, side.p * std::pow(fanC / c, 2.0 * g / (g - 1.0))};
+}
+
+} // namespace MHD
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace MHD {
+
+// Primitive state of a one-dimensional polytropic gas
+struct GasState {
+    double rho;
+    double u;
+    double p;
+};
+
+/**
+ * Exact solution of the Riemann problem for the Euler equations of a polytropic gas (Toro,
+ * "Riemann Solvers and Numerical Methods for Fluid Dynamics", ch. 4). The star-region pressure is
+ * found by Newton iteration on the pressure function, the self-similar solution is then sampled at
+ * any x / t.
+ */
+class ExactRiemannSolver {
+public:
+    // Throws Error::INVALID_INITIAL_CONDITION if the states generate a vacuum
+    ExactRiemannSolver(GasState const& left, GasState const& right, double const gamma);
+
+    double StarPressure() const { return m_pStar; }
+    double StarVelocity() const { return m_uStar; }
+
+    // State at speed xOverT relative to the initial discontinuity
+    GasState Sample(double const xOverT) const;
+
+private:
+    // Pressure function of one side and its derivative with respect to p
+    void PressureFunction(GasState const& state, double const soundSpeed, double const p,
+                          double& f, double& df) const;
+
+    GasState const m_left;
+    GasState const m_right;
+    double const m_gamma;
+    double const m_cLeft;
+    double const m_cRight;
+    double m_pStar = 0.0;
+    double m_uStar = 0.0;
+};
+
+} // namespace MHD
@@ -0,0 +1,396 @@
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <grid.hpp>
+#include <halo/halo_exchange.hpp>
+#include <kernels.hpp>
+#include <profile.hpp>
+#include <refinement/adaptive_refinement.hpp>
+#include <solver.hpp>
+#include <variable_store.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace MHD {
+
+namespace {
+
+std::array<std::vector<double>*, AdaptiveRefinement::NUM_CONSERVED> conservedFields(VariableStore& vs) {
+    return {&vs.rho, &vs.rhoU, &vs.rhoV, &vs.rhoW, &vs.rhoE, &vs.bx, &vs.by, &vs.bz};
+}
+
+// A jump between neighbouring cells larger than threshold relative to the larger of the two
+bool steep(double const a, double const b, double const threshold) {
+    return std::abs(a - b) > threshold * std::max(std::abs(a), std::abs(b));
+}
+
+} // namespace
+
+struct ProlongKernel {
+    static constexpr KernelTraits TRAITS = {"Prolong", 7 * AdaptiveRefinement::NUM_CONSERVED * sizeof(double), 0};
+
+    ProlongKernel(std::array<std::vector<double>*, AdaptiveRefinement::NUM_CONSERVED> const& fields,
+                  std::array<std::vector<double>, AdaptiveRefinement::NUM_CONSERVED> const& previous,
+                  double const fraction, std::size_t const numCells, bool const periodic,
+                  AdaptiveRefinement::Patch& patch, std::vector<std::size_t> const& targets,
+                  std::vector<long> const& positions) :
+        m_fields(fields), m_previous(previous), m_fraction(fraction), m_numCells(static_cast<long>(numCells)),
+        m_periodic(periodic), m_patch(patch), m_targets(targets), m_positions(positions) {}
+
+    void operator()(std::size_t const k) {
+        // Fine cell of the grid, and the coarse cell it is the lower or upper half of
+        long const fine = 2 * static_cast<long>(m_patch.firstCell) + m_positions[k];
+        long const coarse = (fine >= 0 ? fine : fine - 1) / 2;
+        double const half = fine - 2 * coarse == 0 ? -0.25 : 0.25;
+        std::array<double, AdaptiveRefinement::NUM_CONSERVED> centres;
+        std::array<double, AdaptiveRefinement::NUM_CONSERVED> values;
+        for (std::size_t f = 0; f < AdaptiveRefinement::NUM_CONSERVED; ++f) {
+            centres[f] = Value(f, coarse);
+            double const lower = centres[f] - Value(f, coarse - 1);
+            double const upper = Value(f, coarse + 1) - centres[f];
+            double const slope = lower * upper > 0.0 ? (std::abs(lower) < std::abs(upper) ? lower : upper) : 0.0;
+            values[f] = centres[f] + half * slope;
+        }
+
+        // Slopes of each conserved variable limited on their own can still leave the fine cell without
+        // internal energy, where it takes the coarse cell's state as it is
+        double const kinetic = 0.5 * (values[1] * values[1] + values[2] * values[2] + values[3] * values[3]) / values[0];
+        double const magnetic = 0.5 * (values[5] * values[5] + values[6] * values[6] + values[7] * values[7]);
+        std::array<double, AdaptiveRefinement::NUM_CONSERVED> const& state =
+            values[0] > 0.0 && values[4] - kinetic - magnetic > 0.0 ? values : centres;
+        for (std::size_t f = 0; f < AdaptiveRefinement::NUM_CONSERVED; ++f) {
+            (*m_patch.fields[f])[m_targets[k]] = state[f];
+        }
+    }
+
+    // Cells past the ends of the grid wrap around when they are joined, and repeat the end cell otherwise
+    double Value(std::size_t const f, long j) const {
+        j = m_periodic ? ((j % m_numCells) + m_numCells) % m_numCells : std::clamp(j, 0L, m_numCells - 1);
+        double const after = (*m_fields[f])[j];
+        return m_fraction == 1.0 ? after : (1.0 - m_fraction) * m_previous[f][j] + m_fraction * after;
+    }
+
+    std::array<std::vector<double>*, AdaptiveRefinement::NUM_CONSERVED> const& m_fields;
+    std::array<std::vector<double>, AdaptiveRefinement::NUM_CONSERVED> const& m_previous;
+    double const m_fraction;
+    long const m_numCells;
+    bool const m_periodic;
+    AdaptiveRefinement::Patch& m_patch;
+    std::vector<std::size_t> const& m_targets;
+    std::vector<long> const& m_positions;
+};
+
+struct RestrictKernel {
+    static constexpr KernelTraits TRAITS = {"Restrict", 3 * AdaptiveRefinement::NUM_CONSERVED * sizeof(double),
+                                            2 * AdaptiveRefinement::NUM_CONSERVED};
+
+    RestrictKernel(std::array<std::vector<double>*, AdaptiveRefinement::NUM_CONSERVED> const& fields,
+                   AdaptiveRefinement::Patch const& patch) :
+        m_fields(fields), m_patch(patch) {}
+
+    void operator()(std::size_t const k) {
+        for (std::size_t f = 0; f < AdaptiveRefinement::NUM_CONSERVED; ++f) {
+            std::vector<double> const& fine = *m_patch.fields[f];
+            (*m_fields[f])[m_patch.firstCell + k] = 0.5 * (fine[2 * k] + fine[2 * k + 1]);
+        }
+    }
+
+    std::array<std::vector<double>*, AdaptiveRefinement::NUM_CONSERVED> const& m_fields;
+    AdaptiveRefinement::Patch const& m_patch;
+};
+
+AdaptiveRefinement::AdaptiveRefinement(Profile const& profile, ExecutionController const& execCtrl,
+                                       VariableStore& varStore, IGrid const& grid, Solver& solver,
+                                       std::vector<bool> const& filledByOwner) :
+    m_patchProfile(profile), m_varStore(varStore), m_grid(grid), m_solver(solver),
+    m_blockCells(profile.m_refinementBlockCellsOption), m_threshold(profile.m_refinementThresholdOption),
+    m_periodic(!filledByOwner[0] && !filledByOwner[1] &&
+               BoundaryConditionOption::PERIODIC == (profile.m_boundaryConditionsOption.empty()
+                   ? profile.m_boundaryConditionOption : profile.m_boundaryConditionsOption.front())),
+    m_filledByOwner({filledByOwner[0], filledByOwner[1]}),
+    m_margin((grid.NumGhostLayers() + 1) / 2 + 1), m_fields(conservedFields(varStore)) {
+    (void)execCtrl;
+
+    // A patch splits a block into at least as many cells as it has ghost layers
+    if (m_blockCells == 0 || 2 * m_blockCells < grid.NumGhostLayers() || !(m_threshold > 0.0)) {
+        throw Error::INVALID_REFINEMENT;
+    }
+
+    // Patches are plain staged solvers at half the spacing, refining themselves with the levels left
+    m_patchProfile.m_gridSpacingsOption[0] *= 0.5;
+    m_patchProfile.m_refinementLevelsOption = profile.m_refinementLevelsOption - 1;
+    m_patchProfile.m_stepScheduleOption = StepScheduleOption::STAGED;
+    m_patchProfile.m_numThreadsOption = 1;
+    m_patchProfile.m_temporalBlockStepsOption = 1;
+    m_patchProfile.m_activityTrackingOption = ActivityTrackingOption::NO;
+
+    for (std::vector<double>& previous : m_previous) {
+        previous.resize(grid.NumNodes(), 0.0);
+    }
+    m_flagged.assign((grid.NumCells() + m_blockCells - 1) / m_blockCells, 0);
+    m_runs.reserve(m_flagged.size());
+}
+
+AdaptiveRefinement::~AdaptiveRefinement() = default;
+
+void AdaptiveRefinement::BeginStep(ExecutionController const& execCtrl) {
+    (void)execCtrl;
+    if (m_patches.empty()) {
+        return;
+    }
+    for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+        std::copy(m_fields[f]->begin(), m_fields[f]->end(), m_previous[f].begin());
+    }
+}
+
+void AdaptiveRefinement::EndStep(ExecutionController const& execCtrl, double const timeStep) {
+    // Every patch reads the grid's cells as its step left them, before any is folded back in
+    for (std::unique_ptr<Patch> const& patch : m_patches) {
+        patch->lowerFlux.fill(0.0);
+        patch->upperFlux.fill(0.0);
+        patch->numSubsteps = 0;
+        std::size_t const lastFace = patch->grid->NumFaces() - 1;
+        double elapsed = 0.0;
+        while (elapsed < timeStep) {
+            Prolong(execCtrl, *patch, patch->ghostIdxs, patch->ghostCells, elapsed / timeStep);
+            VelocityKernel velKern(*patch->varStore);
+            execCtrl.LaunchKernel(velKern, patch->ghostIdxs);
+            SpecificInternalEnergyKernel eKern(*patch->varStore);
+            execCtrl.LaunchKernel(eKern, patch->ghostIdxs);
+            CaloricallyPerfectGasPressureKernel pKern(*patch->varStore);
+            execCtrl.LaunchKernel(pKern, patch->ghostIdxs);
+            CaloricallyPerfectGasTemperatureKernel tKern(*patch->varStore);
+            execCtrl.LaunchKernel(tKern, patch->ghostIdxs);
+            CaloricallyPerfectGasSoundSpeedKernel csKern(*patch->varStore);
+            execCtrl.LaunchKernel(csKern, patch->ghostIdxs);
+
+            patch->solver->PrimFromCons();
+
+            // Even substeps over what is left of the step, as many as the patch's own CFL limit needs,
+            // which is two while the waves keep their speed and more while they speed up
+            double const remaining = timeStep - elapsed;
+            double const numSubsteps = std::max(1.0, std::ceil(remaining / patch->solver->StableTimeStep()));
+            double const substep = remaining / numSubsteps;
+            patch->solver->PerformTimeStep(substep);
+            elapsed = numSubsteps == 1.0 ? timeStep : elapsed + substep;
+            ++patch->numSubsteps;
+
+            std::array<double, NUM_CONSERVED> const lower = patch->solver->FaceFluxes(0);
+            std::array<double, NUM_CONSERVED> const upper = patch->solver->FaceFluxes(lastFace);
+            for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+                patch->lowerFlux[f] += substep / timeStep * lower[f];
+                patch->upperFlux[f] += substep / timeStep * upper[f];
+            }
+        }
+    }
+
+    // Patches meeting where a periodic domain wraps around each took their own fine flux through the
+    // edge they share, so the one above the wrap takes the other's instead, in its first fine cell
+    std::size_t const numCells = m_grid.NumCells();
+    double const ratio = timeStep / m_grid.CellSize()[0];
+    Patch* const wrapped = m_periodic && !m_patches.empty() && m_patches.front()->firstCell == 0 &&
+        m_patches.back()->firstCell + m_patches.back()->numCells == numCells && m_patches.size() > 1
+        ? m_patches.back().get() : nullptr;
+    if (wrapped) {
+        Patch& patch = *m_patches.front();
+        for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+            (*patch.fields[f])[0] += 2.0 * ratio * (wrapped->upperFlux[f] - patch.lowerFlux[f]);
+        }
+    }
+
+    // The coarse cells beside a patch took the coarse flux through its edge, the fine cells inside the fine ones
+    for (std::unique_ptr<Patch> const& patch : m_patches) {
+        RestrictKernel restrictKern(m_fields, *patch);
+        execCtrl.LaunchKernel(restrictKern, patch->numCells);
+
+        std::size_t const first = patch->firstCell;
+        std::size_t const end = first + patch->numCells;
+        if (!patch->ownsLower && !(wrapped && first == 0)) {
+            std::size_t const cell = first == 0 ? numCells - 1 : first - 1;
+            std::array<double, NUM_CONSERVED> const coarse = m_solver.FaceFluxes(cell + 1);
+            for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+                (*m_fields[f])[cell] -= ratio * (patch->lowerFlux[f] - coarse[f]);
+            }
+        }
+        if (!patch->ownsUpper && !(wrapped && end == numCells)) {
+            std::size_t const cell = end == numCells ? 0 : end;
+            std::array<double, NUM_CONSERVED> const coarse = m_solver.FaceFluxes(cell);
+            for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+                (*m_fields[f])[cell] += ratio * (patch->upperFlux[f] - coarse[f]);
+            }
+        }
+    }
+
+    Regrid(execCtrl, true);
+}
+
+void AdaptiveRefinement::Reset(ExecutionController const& execCtrl) {
+    Regrid(execCtrl, false);
+}
+
+std::size_t AdaptiveRefinement::NumCellUpdates() const {
+    std::size_t numCellUpdates = 0;
+    for (std::unique_ptr<Patch> const& patch : m_patches) {
+        numCellUpdates += patch->numSubsteps * patch->solver->NumCellUpdates();
+    }
+    return numCellUpdates;
+}
+
+void AdaptiveRefinement::FlagRuns() {
+    std::size_t const numCells = m_grid.NumCells();
+    std::size_t const numBlocks = m_flagged.size();
+    std::vector<double> const& rho = m_varStore.rho;
+    std::vector<double> const& rhoE = m_varStore.rhoE;
+
+    // Both blocks either side of a steep jump, whose ends are joined when the domain wraps around
+    std::fill(m_flagged.begin(), m_flagged.end(), 0);
+    std::size_t const numPairs = m_periodic ? numCells : numCells - 1;
+    for (std::size_t i = 0; i < numPairs; ++i) {
+        std::size_t const j = (i + 1) % numCells;
+        if (steep(rho[i], rho[j], m_threshold) || steep(rhoE[i], rhoE[j], m_threshold)) {
+            m_flagged[i / m_blockCells] = 1;
+            m_flagged[j / m_blockCells] = 1;
+        }
+    }
+
+    // And one more block either side, so a feature cannot leave its patch before the next regrid
+    for (std::size_t b = 0; b < numBlocks; ++b) {
+        if (m_flagged[b] != 1) {
+            continue;
+        }
+        if (b > 0 || m_periodic) {
+            char& lower = m_flagged[(b + numBlocks - 1) % numBlocks];
+            lower = lower == 0 ? 2 : lower;
+        }
+        if (b + 1 < numBlocks || m_periodic) {
+            char& upper = m_flagged[(b + 1) % numBlocks];
+            upper = upper == 0 ? 2 : upper;
+        }
+    }
+
+    // Blocks near a boundary the grid's parent fills would need ghost cells this grid does not have
+    for (std::size_t b = 0; b < numBlocks; ++b) {
+        std::size_t const first = b * m_blockCells;
+        std::size_t const end = std::min(numCells, first + m_blockCells);
+        if ((m_filledByOwner[0] && first < m_margin) || (m_filledByOwner[1] && end + m_margin > numCells)) {
+            m_flagged[b] = 0;
+        }
+    }
+
+    // Runs of flagged blocks, reaching a boundary of the domain when they come within the margin of it
+    m_runs.clear();
+    for (std::size_t b = 0; b < numBlocks;) {
+        if (!m_flagged[b]) {
+            ++b;
+            continue;
+        }
+        std::size_t const firstBlock = b;
+        while (b < numBlocks && m_flagged[b]) {
+            ++b;
+        }
+        std::size_t first = firstBlock * m_blockCells;
+        std::size_t end = std::min(numCells, b * m_blockCells);
+        if (!m_periodic && !m_filledByOwner[0] && first < m_margin) {
+            first = 0;
+        }
+        if (!m_periodic && !m_filledByOwner[1] && end + m_margin > numCells) {
+            end = numCells;
+        }
+        m_runs.push_back({first, end - first});
+    }
+}
+
+void AdaptiveRefinement::Regrid(ExecutionController const& execCtrl, bool const keepFineData) {
+    FlagRuns();
+    bool const unchanged = keepFineData && m_runs.size() == m_patches.size() &&
+        std::equal(m_runs.begin(), m_runs.end(), m_patches.begin(),
+                   [](std::array<std::size_t, 2> const& run, std::unique_ptr<Patch> const& patch) {
+                       return run[0] == patch->firstCell && run[1] == patch->numCells;
+                   });
+    if (unchanged) {
+        return;
+    }
+
+    // Patches that stay are kept whole, new ones copy the fine cells of the old patches they overlap
+    // and split the grid's cells everywhere else
+    std::vector<std::unique_ptr<Patch>> patches;
+    for (std::array<std::size_t, 2> const& run : m_runs) {
+        auto const kept = std::find_if(m_patches.begin(), m_patches.end(), [&run](std::unique_ptr<Patch> const& patch) {
+            return patch && run[0] == patch->firstCell && run[1] == patch->numCells;
+        });
+        if (keepFineData && kept != m_patches.end()) {
+            patches.push_back(std::move(*kept));
+            continue;
+        }
+
+        std::unique_ptr<Patch> patch = MakePatch(execCtrl, run[0], run[1]);
+        std::vector<std::size_t> targets;
+        std::vector<long> positions;
+        for (std::size_t k = 0; k < run[1]; ++k) {
+            std::size_t const cell = run[0] + k;
+            auto const old = std::find_if(m_patches.begin(), m_patches.end(), [cell](std::unique_ptr<Patch> const& p) {
+                return p && cell >= p->firstCell && cell < p->firstCell + p->numCells;
+            });
+            if (keepFineData && old != m_patches.end()) {
+                std::size_t const from = 2 * (cell - (*old)->firstCell);
+                for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+                    (*patch->fields[f])[2 * k] = (*(*old)->fields[f])[from];
+                    (*patch->fields[f])[2 * k + 1] = (*(*old)->fields[f])[from + 1];
+                }
+                continue;
+            }
+            for (std::size_t const half : {0, 1}) {
+                targets.push_back(2 * k + half);
+                positions.push_back(static_cast<long>(2 * k + half));
+            }
+        }
+        Prolong(execCtrl, *patch, targets, positions, 1.0);
+
+        // The patch's own patches start from its cells
+        patch->solver->StateReplaced();
+        patches.push_back(std::move(patch));
+    }
+    m_patches = std::move(patches);
+}
+
+std::unique_ptr<AdaptiveRefinement::Patch> AdaptiveRefinement::MakePatch(ExecutionController const& execCtrl,
+                                                                         std::size_t const firstCell,
+                                                                         std::size_t const numCells) {
+    auto patch = std::make_unique<Patch>();
+    patch->numSubsteps = 2;
+    patch->firstCell = firstCell;
+    patch->numCells = numCells;
+    patch->ownsLower = !m_periodic && !m_filledByOwner[0] && firstCell == 0;
+    patch->ownsUpper = !m_periodic && !m_filledByOwner[1] && firstCell + numCells == m_grid.NumCells();
+    patch->grid = cellRangeGridFactory(m_patchProfile, 2 * (m_grid.FirstCell() + firstCell), 2 * numCells);
+    patch->varStore = std::make_unique<VariableStore>(*patch->grid);
+    patch->fields = conservedFields(*patch->varStore);
+    Decomposition decomposition;
+    decomposition.neighbourRanks = {patch->ownsLower ? NO_NEIGHBOUR : FILLED_BY_OWNER,
+                                    patch->ownsUpper ? NO_NEIGHBOUR : FILLED_BY_OWNER};
+    patch->solver = std::make_unique<Solver>(m_patchProfile, execCtrl, *patch->varStore, *patch->grid, &decomposition);
+
+    // Ghost layers away from each boundary, see Cartesian1DGrid
+    std::size_t const fineCells = patch->grid->NumCells();
+    std::size_t const numGhostLayers = patch->grid->NumGhostLayers();
+    for (std::size_t k = 0; k < numGhostLayers; ++k) {
+        if (!patch->ownsLower) {
+            patch->ghostIdxs.push_back(fineCells + k);
+            patch->ghostCells.push_back(-1 - static_cast<long>(k));
+        }
+        if (!patch->ownsUpper) {
+            patch->ghostIdxs.push_back(fineCells + numGhostLayers + k);
+            patch->ghostCells.push_back(static_cast<long>(fineCells + k));
+        }
+    }
+    return patch;
+}
+
+void AdaptiveRefinement::Prolong(ExecutionController const& execCtrl, Patch& patch,
+                                 std::vector<std::size_t> const& targets, std::vector<long> const& positions,
+                                 double const fraction) {
+    ProlongKernel kernel(m_fields, m_previous, fraction, m_grid.NumCells(), m_periodic, patch, targets, positions);
+    execCtrl.LaunchKernel(kernel, targets.size());
+}
+
+} // namespace MHD
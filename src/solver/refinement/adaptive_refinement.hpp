@@ -0,0 +1,97 @@
+#pragma once
+
+#include <profile.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace MHD {
+
+class ExecutionController;
+class IGrid;
+class Solver;
+class VariableStore;
+
+/**
+ * Patches of cells half the size of the grid's, over the runs of fixed-size blocks where a detector
+ * finds steep jumps. Each patch is a staged solver of its own, taking as many even substeps through
+ * the grid's step as its own CFL limit needs, two while the waves keep their speed. The ghost cells
+ * at its inner edges are filled from the grid's cells, interpolated in time over the step and
+ * limited linearly in space so each pair of fine cells averages to the coarse cell they split.
+ * After the grid's step the fine cells are averaged onto the coarse cells under them, and the coarse
+ * cells beside each patch are corrected by the difference between the fine fluxes through the patch
+ * edge and the coarse flux they took, which keeps the hierarchy as conservative as a single grid.
+ * A patch refines itself the same way when levels remain, so the hierarchy is a tree of solvers,
+ * each level subcycling within the step of the one below.
+ */
+class AdaptiveRefinement {
+public:
+    // filledByOwner marks the boundaries of the grid whose ghost cells its own parent fills, which
+    // patches keep clear of so their ghost cells only ever read cells of the grid
+    AdaptiveRefinement(Profile const& profile, ExecutionController const& execCtrl, VariableStore& varStore,
+                       IGrid const& grid, Solver& solver, std::vector<bool> const& filledByOwner);
+    ~AdaptiveRefinement();
+
+    // Keeps the conserved state before the grid's step, which the patch ghost cells interpolate from
+    void BeginStep(ExecutionController const& execCtrl);
+
+    // Steps the patches through the grid's step just taken, folds them back into it and regrids
+    void EndStep(ExecutionController const& execCtrl, double const timeStep);
+
+    // Rebuilds every patch from the grid's cells, after its state was set from outside
+    void Reset(ExecutionController const& execCtrl);
+
+    // Cell updates of every patch in the last step of the grid, counting the substeps each took
+    std::size_t NumCellUpdates() const;
+
+    static std::size_t constexpr NUM_CONSERVED = 8;
+
+    struct Patch {
+        std::size_t firstCell;     // first cell of the grid the patch covers
+        std::size_t numCells;      // cells of the grid it covers, each split in two
+        bool ownsLower;            // edge on a boundary of the domain, filled by the patch's own condition
+        bool ownsUpper;
+        std::unique_ptr<IGrid> grid;
+        std::unique_ptr<VariableStore> varStore;
+        std::unique_ptr<Solver> solver;
+        std::array<std::vector<double>*, NUM_CONSERVED> fields;
+        std::vector<std::size_t> ghostIdxs;  // fine ghost nodes filled from the grid
+        std::vector<long> ghostCells;        // position of each in fine cells of the grid, from its first cell
+        std::array<double, NUM_CONSERVED> lowerFlux; // fine fluxes through each edge, averaged over the step
+        std::array<double, NUM_CONSERVED> upperFlux;
+        std::size_t numSubsteps;
+    };
+
+private:
+    void Regrid(ExecutionController const& execCtrl, bool const keepFineData);
+    void FlagRuns();
+    std::unique_ptr<Patch> MakePatch(ExecutionController const& execCtrl, std::size_t const firstCell,
+                                     std::size_t const numCells);
+
+    // Fine cells of a patch from the grid's cells, weighting the state after the step by fraction
+    void Prolong(ExecutionController const& execCtrl, Patch& patch, std::vector<std::size_t> const& targets,
+                 std::vector<long> const& positions, double const fraction);
+
+    Profile m_patchProfile;
+    VariableStore& m_varStore;
+    IGrid const& m_grid;
+    Solver& m_solver;
+    std::size_t const m_blockCells;
+    double const m_threshold;
+    bool const m_periodic;
+    std::array<bool, 2> m_filledByOwner;
+
+    // Cells of the grid a patch edge keeps from a boundary filled by the grid's parent, enough for
+    // the slopes of the cells its ghost layers are interpolated from
+    std::size_t const m_margin;
+
+    std::array<std::vector<double>*, NUM_CONSERVED> m_fields;
+    std::array<std::vector<double>, NUM_CONSERVED> m_previous;
+    std::vector<char> m_flagged;
+    std::vector<std::array<std::size_t, 2>> m_runs; // first cell and cells of each patch the flags call for
+    std::vector<std::unique_ptr<Patch>> m_patches;
+};
+
+} // namespace MHD
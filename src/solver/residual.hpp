@@ -2,11 +2,15 @@
 
 #include <execution_controller.hpp>
 
+#include <array>
+
 namespace MHD {
 
+// Fluxes are read as Real, the residuals are double, so the update accumulates in double
+template <typename Real>
 struct ResidualContext {
-    ResidualContext(IGrid const& grid, FluxContext const& flux) :
-        numCells(grid.NumCells()), cellToFaceIndices(grid.CellIdxToFaceIdxs()), cellSize(grid.CellSize()),
+    ResidualContext(IGrid const& grid, FluxContext<Real> const& flux) :
+        numCells(grid.NumCells()), cellToFaceIndices(grid.CellIdxToFaceIdxs()), cellWidths(grid.CellWidths()),
         rhoFlux(flux.rhoFlux), rhoUFlux(flux.rhoUFlux), rhoVFlux(flux.rhoVFlux),
         rhoWFlux(flux.rhoWFlux), rhoEFlux(flux.rhoEFlux), bxFlux(flux.bxFlux), byFlux(flux.byFlux), bzFlux(flux.bzFlux) {
             rhoRes.resize(numCells, 0.0);
@@ -17,21 +21,28 @@ struct ResidualContext {
             bxRes.resize(numCells, 0.0);
             byRes.resize(numCells, 0.0);
             bzRes.resize(numCells, 0.0);
+            cellFaces.reserve(numCells);
+            for (std::size_t i = 0; i < numCells; ++i) {
+                cellFaces.push_back({cellToFaceIndices.at(i)[0], cellToFaceIndices.at(i)[1]});
+            }
         }
 
     std::size_t const numCells;
     std::map<std::size_t, std::vector<std::size_t>> const& cellToFaceIndices;
-    std::vector<double> const& cellSize;
+    std::vector<double> const& cellWidths; // volume of each cell per unit face area
+
+    // Left and right face of each cell, flattened from the map once at setup
+    std::vector<std::array<std::size_t, 2>> cellFaces;
 
     // Face-centered fluxes
-    std::vector<double> const& rhoFlux;
-    std::vector<double> const& rhoUFlux;
-    std::vector<double> const& rhoVFlux;
-    std::vector<double> const& rhoWFlux;
-    std::vector<double> const& rhoEFlux;
-    std::vector<double> const& bxFlux;
-    std::vector<double> const& byFlux;
-    std::vector<double> const& bzFlux;
+    std::vector<Real> const& rhoFlux;
+    std::vector<Real> const& rhoUFlux;
+    std::vector<Real> const& rhoVFlux;
+    std::vector<Real> const& rhoWFlux;
+    std::vector<Real> const& rhoEFlux;
+    std::vector<Real> const& bxFlux;
+    std::vector<Real> const& byFlux;
+    std::vector<Real> const& bzFlux;
 
     // Cell-centered residuals
     std::vector<double> rhoRes;     // mass density residual
@@ -44,46 +55,55 @@ struct ResidualContext {
     std::vector<double> bzRes;      // z magnetic field residual
 };
 
+template <typename Real>
 struct TransportKernel {
 public:
-    TransportKernel(ResidualContext& context) : m_context(context) {}
+    static constexpr KernelTraits TRAITS = {"Transport", 9 * sizeof(double) + 8 * sizeof(Real), 17};
+
+    TransportKernel(ResidualContext<Real>& context) : m_context(context) {}
 
     void operator()(std::size_t const i) {
         // Get the left and right face indices for this cell
-        std::size_t const iLeft = m_context.cellToFaceIndices.at(i)[0];
-        std::size_t const iRight = m_context.cellToFaceIndices.at(i)[1];
-        double c = -1.0 / m_context.cellSize[0];
-
-        m_context.rhoRes[i] = c * (m_context.rhoFlux[iRight] - m_context.rhoFlux[iLeft]);
-        m_context.rhoURes[i] = c * (m_context.rhoUFlux[iRight] - m_context.rhoUFlux[iLeft]);
-        m_context.rhoVRes[i] = c * (m_context.rhoVFlux[iRight] - m_context.rhoVFlux[iLeft]);
-        m_context.rhoWRes[i] = c * (m_context.rhoWFlux[iRight] - m_context.rhoWFlux[iLeft]);
-        m_context.rhoERes[i] = c * (m_context.rhoEFlux[iRight] - m_context.rhoEFlux[iLeft]);
-        m_context.bxRes[i] = c * (m_context.bxFlux[iRight] - m_context.bxFlux[iLeft]);
-        m_context.byRes[i] = c * (m_context.byFlux[iRight] - m_context.byFlux[iLeft]);
-        m_context.bzRes[i] = c * (m_context.bzFlux[iRight] - m_context.bzFlux[iLeft]);
+        std::size_t const iLeft = m_context.cellFaces[i][0];
+        std::size_t const iRight = m_context.cellFaces[i][1];
+        double c = -1.0 / m_context.cellWidths[i];
+
+        m_context.rhoRes[i] = c * (static_cast<double>(m_context.rhoFlux[iRight]) - m_context.rhoFlux[iLeft]);
+        m_context.rhoURes[i] = c * (static_cast<double>(m_context.rhoUFlux[iRight]) - m_context.rhoUFlux[iLeft]);
+        m_context.rhoVRes[i] = c * (static_cast<double>(m_context.rhoVFlux[iRight]) - m_context.rhoVFlux[iLeft]);
+        m_context.rhoWRes[i] = c * (static_cast<double>(m_context.rhoWFlux[iRight]) - m_context.rhoWFlux[iLeft]);
+        m_context.rhoERes[i] = c * (static_cast<double>(m_context.rhoEFlux[iRight]) - m_context.rhoEFlux[iLeft]);
+        m_context.bxRes[i] = c * (static_cast<double>(m_context.bxFlux[iRight]) - m_context.bxFlux[iLeft]);
+        m_context.byRes[i] = c * (static_cast<double>(m_context.byFlux[iRight]) - m_context.byFlux[iLeft]);
+        m_context.bzRes[i] = c * (static_cast<double>(m_context.bzFlux[iRight]) - m_context.bzFlux[iLeft]);
     }
 
-    ResidualContext& m_context;
+    ResidualContext<Real>& m_context;
 };
 
+template <typename Real>
 class Residual {
 public:
-    Residual(IGrid const& grid, FluxContext const& fc) {
-        m_context = std::make_unique<ResidualContext>(grid, fc);
+    Residual(IGrid const& grid, FluxContext<Real> const& fc) {
+        m_context = std::make_unique<ResidualContext<Real>>(grid, fc);
     }
 
     ~Residual() = default;
 
     void ComputeResidual(ExecutionController const& execCtrl) {
-        TransportKernel kernel(*m_context);
+        TransportKernel<Real> kernel(*m_context);
         execCtrl.LaunchKernel(kernel, m_context->numCells);
     }
 
-    ResidualContext const& GetContext() const { return *m_context; }
+    void ComputeResidual(ExecutionController const& execCtrl, std::vector<std::size_t> const& cells) {
+        TransportKernel<Real> kernel(*m_context);
+        execCtrl.LaunchKernel(kernel, cells);
+    }
+
+    ResidualContext<Real> const& GetContext() const { return *m_context; }
 
 private:
-    std::unique_ptr<ResidualContext> m_context;
+    std::unique_ptr<ResidualContext<Real>> m_context;
 };
 
 } // namespace MHD
\ No newline at end of file
@@ -1,66 +1,555 @@
+#include <activity/activity_tracker.hpp>
 #include <boundary_condition/boundary_condition.hpp>
+#include <error.hpp>
 #include <execution_controller.hpp>
 #include <flux/flux_scheme.hpp>
 #include <grid.hpp>
+#include <halo/halo_exchange.hpp>
 #include <integration/integration.hpp>
 #include <kernels.hpp>
 #include <profile.hpp>
 #include <reconstruction/reconstruction.hpp>
+#include <refinement/adaptive_refinement.hpp>
 #include <solver.hpp>
 #include <residual.hpp>
+#include <task_graph.hpp>
+#include <temporal_blocking/temporal_blocking.hpp>
+#include <topology.hpp>
 #include <variable_store.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <memory>
+#include <vector>
 
 namespace MHD {
 
-Solver::Solver(Profile const& profile, ExecutionController const& execCtrl, VariableStore& varStore, IGrid const& grid) :
+template <typename Real>
+struct Solver::FaceStages {
+    FaceStages(Profile const& profile, VariableStore const& varStore, IGrid const& grid) :
+        reconstruction(reconstructionFactory<Real>(profile, varStore, grid)),
+        flux(fluxFactory<Real>(profile, grid, reconstruction->GetContext())),
+        residual(std::make_unique<Residual<Real>>(grid, flux->GetContext())) {}
+
+    std::unique_ptr<IReconstruction<Real>> reconstruction;
+    std::unique_ptr<IFlux<Real>> flux;
+    std::unique_ptr<Residual<Real>> residual;
+};
+
+template <typename Stage>
+void Solver::WithFaceStages(Stage&& stage) {
+    if (m_mixedStages) {
+        stage(*m_mixedStages);
+    } else {
+        stage(*m_doubleStages);
+    }
+}
+
+Solver::Solver(Profile const& profile, ExecutionController const& execCtrl, VariableStore& varStore, IGrid const& grid,
+               Decomposition const* decomposition) :
     m_execCtrl(execCtrl), m_varStore(varStore), m_grid(grid)
 {
-    m_boundCon = boundaryConditionFactory(profile, grid, varStore);
-    m_reconstruction = reconstructionFactory(profile, varStore, grid);
-    m_flux = fluxFactory(profile, grid, m_reconstruction->GetContext());
-    m_residual = std::make_unique<Residual>(grid, m_flux->GetContext());
-    m_integrator = integratorFactory(m_residual->GetContext(), m_varStore, timeStep);
+    std::vector<bool> exchanged(grid.NumBoundaries(), false);
+    if (decomposition) {
+        std::vector<int> const& ranks = decomposition->neighbourRanks;
+        if (std::any_of(ranks.begin(), ranks.end(), [](int const rank) { return rank >= 0; })) {
+            // The halo carries one layer per ghost layer, which must cover every cell the faces at a part's edge read
+            if (grid.NumGhostLayers() < reconstructionStencilReach(profile)) {
+                throw Error::INVALID_DECOMPOSITION;
+            }
+            m_haloExchange = std::make_unique<HaloExchange>(grid, varStore, *decomposition);
+        }
+        m_communicator = decomposition->communicator;
+        for (std::size_t b = 0; b < grid.NumBoundaries(); ++b) {
+            exchanged[b] = ranks[b] != NO_NEIGHBOUR;
+        }
+    }
+    m_boundCon = boundaryConditionFactory(profile, grid, varStore, exchanged);
+
+    // Mixed precision stores the face states and fluxes as float, and still integrates in double
+    if (PrecisionOption::MIXED == profile.m_precisionOption) {
+        m_mixedStages = std::make_unique<FaceStages<float>>(profile, varStore, grid);
+    } else {
+        m_doubleStages = std::make_unique<FaceStages<double>>(profile, varStore, grid);
+    }
+    WithFaceStages([this](auto& stages) {
+        m_integrator = integratorFactory(stages.residual->GetContext(), m_varStore, timeStep);
+    });
+
+    // Faces that can be reconstructed and fluxed while the halo messages are in flight
+    m_overlapHalo = m_haloExchange && HaloOverlapOption::YES == profile.m_haloOverlapOption;
+    if (m_overlapHalo) {
+        std::vector<bool> isHaloCell(grid.NumNodes(), false);
+        for (std::size_t const i : m_haloExchange->GhostIdxs()) {
+            isHaloCell[i] = true;
+        }
+        for (std::size_t f = 0; f < grid.NumFaces(); ++f) {
+            std::vector<std::size_t> const& stencil = grid.FaceIdxToCellIdxs().at(grid.FaceIdxs()[f]);
+            bool const needsHalo = std::any_of(stencil.begin(), stencil.end(),
+                                               [&isHaloCell](std::size_t const i) { return isHaloCell[i]; });
+            (needsHalo ? m_haloFaces : m_interiorFaces).push_back(f);
+        }
+    }
+
+    // Quiescent tiles are skipped by staged steps, whose stages run over lists of faces and cells
+    if (ActivityTrackingOption::YES == profile.m_activityTrackingOption) {
+        if (profile.m_temporalBlockStepsOption > 1 || StepScheduleOption::TILED == profile.m_stepScheduleOption ||
+            profile.m_numThreadsOption != 1) {
+            throw Error::INVALID_ACTIVITY_TRACKING;
+        }
+        std::size_t const tileCells = profile.m_tileCellsOption > 0 ? profile.m_tileCellsOption : DEFAULT_ACTIVITY_TILE_CELLS;
+        WithFaceStages([this, &grid, tileCells](auto& stages) {
+            m_activity = std::make_unique<ActivityTracker>(grid, stages.reconstruction->GetContext().faceStencils,
+                                                           stages.residual->GetContext().cellFaces, tileCells,
+                                                           m_haloFaces);
+        });
+    }
+
+    // Patches are filled by this grid, which must itself be uniform and stepped whole, once per call, by one thread
+    if (profile.m_refinementLevelsOption > 0) {
+        if (m_haloExchange || m_activity || profile.m_temporalBlockStepsOption > 1 || !grid.IsUniform() ||
+            StepScheduleOption::TILED == profile.m_stepScheduleOption || profile.m_numThreadsOption != 1) {
+            throw Error::INVALID_REFINEMENT;
+        }
+        std::vector<bool> filledByOwner(grid.NumBoundaries(), false);
+        for (std::size_t b = 0; decomposition && b < grid.NumBoundaries(); ++b) {
+            filledByOwner[b] = decomposition->neighbourRanks[b] == FILLED_BY_OWNER;
+        }
+        m_refinement = std::make_unique<AdaptiveRefinement>(profile, execCtrl, varStore, grid, *this, filledByOwner);
+    }
+
+    // A window needs its neighbours' cells several steps deep, which the halo exchange does not carry
+    if (profile.m_temporalBlockStepsOption > 1) {
+        if (m_haloExchange) {
+            throw Error::INVALID_TEMPORAL_BLOCK;
+        }
+        std::size_t const tileCells = profile.m_tileCellsOption > 0 ? profile.m_tileCellsOption : DEFAULT_BLOCK_TILE_CELLS;
+        m_temporalBlocking = std::make_unique<TemporalBlocking>(profile, execCtrl, varStore, grid,
+                                                                profile.m_temporalBlockStepsOption, tileCells);
+        return;
+    }
+
+    // One thread runs the tiles in turn, each through every stage while its data is still in cache
+    if (StepScheduleOption::TILED == profile.m_stepScheduleOption || profile.m_numThreadsOption != 1) {
+        m_staticTiles = PinThreadsOption::YES == profile.m_pinThreadsOption;
+        // Ranks the launcher left unbound start their pinned workers at different CPUs of a shared node
+        std::size_t const cpuOffset = m_communicator
+            ? static_cast<std::size_t>(m_communicator->Rank()) * profile.m_numThreadsOption : 0;
+        m_scheduler = std::make_unique<TaskScheduler>(profile.m_numThreadsOption, "solver", m_staticTiles, cpuOffset);
+        std::size_t const numThreads = m_scheduler->NumThreads();
+        if (profile.m_tileCellsOption > 0) {
+            BuildTaskGraph(profile.m_tileCellsOption);
+        } else if (m_staticTiles) {
+            // Pages stay where their first tiles put them, so the tiles stay as they are
+            BuildTaskGraph((grid.NumCells() + numThreads - 1) / numThreads);
+        } else {
+            // Powers of two from a few cache lines per field up to one tile per thread
+            std::size_t const largest = std::max<std::size_t>(1, grid.NumCells() / numThreads);
+            for (std::size_t tileCells = 256; tileCells < largest; tileCells *= 2) {
+                m_tileCandidates.push_back(tileCells);
+            }
+            m_tileCandidates.push_back(largest);
+            m_tileSeconds.assign(m_tileCandidates.size(), std::numeric_limits<double>::infinity());
+            BuildTaskGraph(m_tileCandidates.front());
+        }
+        if (m_staticTiles) {
+            PlacePages();
+        }
+    }
+}
+
+void Solver::BuildTaskGraph(std::size_t const tileCells) {
+    std::size_t const numCells = m_grid.NumCells();
+    std::size_t const numFaces = m_grid.NumFaces();
+    std::size_t const numTiles = (numCells + tileCells - 1) / tileCells;
+    m_tileCellsPerTile = tileCells;
+    m_tileCells.clear();
+    m_tileFaces.clear();
+
+    // Cells are tiled in runs, and faces in as many near-equal runs, so tile t of each lines up in 1D
+    std::vector<std::size_t> faceTile(numFaces);
+    for (std::size_t t = 0; t < numTiles; ++t) {
+        std::vector<std::size_t>& cells = m_tileCells.emplace_back();
+        for (std::size_t i = t * tileCells; i < std::min(numCells, (t + 1) * tileCells); ++i) {
+            cells.push_back(i);
+        }
+        std::vector<std::size_t>& faces = m_tileFaces.emplace_back();
+        for (std::size_t f = t * numFaces / numTiles; f < (t + 1) * numFaces / numTiles; ++f) {
+            faces.push_back(f);
+            faceTile[f] = t;
+        }
+    }
+
+    std::vector<bool> isHaloCell(m_grid.NumNodes(), false);
+    if (m_haloExchange) {
+        for (std::size_t const i : m_haloExchange->GhostIdxs()) {
+            isHaloCell[i] = true;
+        }
+    }
+
+    m_taskGraph = std::make_unique<TaskGraph>();
+    TaskGraph& graph = *m_taskGraph;
+    using TaskId = TaskGraph::TaskId;
+    std::size_t const numThreads = m_scheduler->NumThreads();
+    auto home = [this, numTiles, numThreads](std::size_t const t) {
+        return m_staticTiles ? t * numThreads / numTiles : TaskGraph::ANY_WORKER;
+    };
+
+    // Messages are posted and completed on the calling thread, the only one that may use MPI
+    TaskId haloBegin = 0;
+    TaskId haloEnd = 0;
+    if (m_haloExchange) {
+        haloBegin = graph.AddTask("HaloExchange", [this] { m_haloExchange->Begin(m_execCtrl); }, 0);
+        haloEnd = graph.AddTask("HaloWait", [this] { m_haloExchange->End(m_execCtrl); }, 0);
+        graph.AddDependency(haloBegin, haloEnd);
+    }
+    TaskId const boundaryConditions = graph.AddTask("BoundaryConditions", [this] {
+        m_boundCon->ApplyBoundaryConditions(m_execCtrl);
+    });
+
+    std::vector<std::array<std::size_t, 4>> const* faceStencils = nullptr;
+    std::vector<std::array<std::size_t, 2>> const* cellFaces = nullptr;
+    WithFaceStages([&faceStencils, &cellFaces](auto& stages) {
+        faceStencils = &stages.reconstruction->GetContext().faceStencils;
+        cellFaces = &stages.residual->GetContext().cellFaces;
+    });
+
+    // A tile's faces wait only for the ghost cells their stencils reach
+    std::vector<std::vector<TaskId>> readers(numTiles); // reconstructions reading the cells of each tile
+    std::vector<TaskId> fluxTasks;
+    for (std::size_t t = 0; t < numTiles; ++t) {
+        TaskId const reconstruction = graph.AddTask("Reconstruction", [this, t] {
+            WithFaceStages([this, t](auto& stages) {
+                stages.reconstruction->ComputeLeftRightStates(m_execCtrl, m_tileFaces[t]);
+            });
+        }, home(t));
+        if (m_haloExchange && !m_overlapHalo) {
+            graph.AddDependency(haloEnd, reconstruction);
+        }
+        for (std::size_t const f : m_tileFaces[t]) {
+            for (std::size_t const i : (*faceStencils)[f]) {
+                if (isHaloCell[i]) {
+                    graph.AddDependency(haloEnd, reconstruction);
+                } else if (i >= numCells) {
+                    graph.AddDependency(boundaryConditions, reconstruction);
+                } else if (std::find(readers[i / tileCells].begin(), readers[i / tileCells].end(), reconstruction) ==
+                           readers[i / tileCells].end()) {
+                    readers[i / tileCells].push_back(reconstruction);
+                }
+            }
+        }
+        TaskId const flux = graph.AddTask("Flux", [this, t] {
+            WithFaceStages([this, t](auto& stages) { stages.flux->ComputeInterfaceFluxes(m_execCtrl, m_tileFaces[t]); });
+        }, home(t));
+        graph.AddDependency(reconstruction, flux);
+        fluxTasks.push_back(flux);
+    }
+
+    // A tile's cells wait for the fluxes on their faces, which may belong to the neighbouring tiles
+    for (std::size_t t = 0; t < numTiles; ++t) {
+        TaskId const residual = graph.AddTask("Residual", [this, t] {
+            WithFaceStages([this, t](auto& stages) { stages.residual->ComputeResidual(m_execCtrl, m_tileCells[t]); });
+        }, home(t));
+        for (std::size_t const i : m_tileCells[t]) {
+            for (std::size_t const f : (*cellFaces)[i]) {
+                graph.AddDependency(fluxTasks[faceTile[f]], residual);
+            }
+        }
+        TaskId const integration = graph.AddTask("Integration", [this, t] {
+            m_integrator->Integrate(m_execCtrl, m_tileCells[t]);
+        }, home(t));
+        graph.AddDependency(residual, integration);
+
+        // Integration overwrites the tile's cells, so everything that reads them in this step goes
+        // first: the boundary conditions, the packing of the halo messages and the stencils of every face
+        graph.AddDependency(boundaryConditions, integration);
+        if (m_haloExchange) {
+            graph.AddDependency(haloBegin, integration);
+        }
+        for (TaskId const reader : readers[t]) {
+            graph.AddDependency(reader, integration);
+        }
+    }
+}
+
+void Solver::PlacePages() {
+    // Face and cell scratch is written before it is read in every step, by the tasks of its tile,
+    // so handing its pages back is enough for those tasks to place them
+    WithFaceStages([](auto& stages) {
+        auto const& rc = stages.reconstruction->GetContext();
+        auto const& fc = stages.flux->GetContext();
+        auto const& resc = stages.residual->GetContext();
+        for (auto const* scratch : {
+                 &rc.rhoLeft, &rc.uLeft, &rc.vLeft, &rc.wLeft, &rc.pLeft, &rc.eLeft, &rc.csLeft, &rc.bxLeft, &rc.byLeft, &rc.bzLeft,
+                 &rc.rhoRight, &rc.uRight, &rc.vRight, &rc.wRight, &rc.pRight, &rc.eRight, &rc.csRight, &rc.bxRight, &rc.byRight, &rc.bzRight,
+                 &fc.rhoFlux, &fc.rhoUFlux, &fc.rhoVFlux, &fc.rhoWFlux, &fc.rhoEFlux, &fc.bxFlux, &fc.byFlux, &fc.bzFlux}) {
+            discardZeroPages(scratch->data(), scratch->size());
+        }
+        for (std::vector<double> const* scratch : {
+                 &resc.rhoRes, &resc.rhoURes, &resc.rhoVRes, &resc.rhoWRes, &resc.rhoERes, &resc.bxRes, &resc.byRes, &resc.bzRes}) {
+            discardZeroPages(scratch->data(), scratch->size());
+        }
+    });
+
+    // The fields are first written on the calling thread, by an initial condition and PrimFromCons,
+    // so the worker of each tile writes its cells first, while they still hold the zeros of setup
+    VariableStore& vs = m_varStore;
+    std::vector<std::vector<double>*> fields;
+    for (std::vector<double>* field : {&vs.rho, &vs.rhoU, &vs.rhoV, &vs.rhoW, &vs.rhoE, &vs.bx, &vs.by, &vs.bz,
+                                       &vs.u, &vs.v, &vs.w, &vs.e, &vs.p, &vs.t, &vs.cs}) {
+        if (discardZeroPages(field->data(), field->size())) {
+            fields.push_back(field);
+        }
+    }
+    TaskGraph graph;
+    std::size_t const numTiles = m_tileCells.size();
+    std::size_t const numThreads = m_scheduler->NumThreads();
+    for (std::size_t t = 0; t < numTiles; ++t) {
+        graph.AddTask("FirstTouch", [this, &fields, t] {
+            for (std::vector<double>* field : fields) {
+                for (std::size_t const i : m_tileCells[t]) {
+                    (*field)[i] = 0.0;
+                }
+            }
+        }, t * numThreads / numTiles);
+    }
+    m_scheduler->Run(graph);
+}
+
+Solver::~Solver() = default;
+
+void Solver::StateReplaced() {
+    if (m_activity) {
+        m_activity->ActivateAll();
+    }
+    if (m_refinement) {
+        m_refinement->Reset(m_execCtrl);
+    }
+}
+
+std::size_t Solver::NumActiveCells() const {
+    return m_activity ? m_activity->ActiveCells().size() : m_grid.NumCells();
+}
+
+std::size_t Solver::NumCellUpdates() const {
+    return NumActiveCells() + (m_refinement ? m_refinement->NumCellUpdates() : 0);
+}
+
+std::array<double, 8> Solver::FaceFluxes(std::size_t const face) const {
+    auto fluxes = [face](auto const& stages) -> std::array<double, 8> {
+        auto const& fc = stages.flux->GetContext();
+        return {fc.rhoFlux[face], fc.rhoUFlux[face], fc.rhoVFlux[face], fc.rhoWFlux[face],
+                fc.rhoEFlux[face], fc.bxFlux[face], fc.byFlux[face], fc.bzFlux[face]};
+    };
+    return m_mixedStages ? fluxes(*m_mixedStages) : fluxes(*m_doubleStages);
+}
+
+void Solver::TuneTileSize(double const seconds) {
+    // Every tile size computes the same step, so the tuning steps are real steps
+    std::size_t const candidate = m_tuningStep / TUNING_STEPS_PER_SIZE;
+    m_tileSeconds[candidate] = std::min(m_tileSeconds[candidate], seconds);
+    ++m_tuningStep;
+    if (m_tuningStep % TUNING_STEPS_PER_SIZE != 0) {
+        return;
+    }
+    if (candidate + 1 < m_tileCandidates.size()) {
+        BuildTaskGraph(m_tileCandidates[candidate + 1]);
+        return;
+    }
+    std::size_t const best = std::min_element(m_tileSeconds.begin(), m_tileSeconds.end()) - m_tileSeconds.begin();
+    BuildTaskGraph(m_tileCandidates[best]);
 }
 
 void Solver::PerformTimeStep() {
+    using Region = ExecutionController::ScopedRegion;
+    Region stepRegion(m_execCtrl, "TimeStep");
+
     // Use CFL condition to determine a timestep to maintain stability
-    CalculateTimeStep();
+    {
+        Region region(m_execCtrl, "CalculateTimeStep");
+        CalculateTimeStep();
+    }
+
+    if (m_temporalBlocking) {
+        Region region(m_execCtrl, "TemporalBlock");
+
+        // Waves that sped up past the limit within the block have it taken again on a shorter step
+        double const numSteps = static_cast<double>(m_temporalBlocking->NumSteps());
+        for (double stableTimeStep = m_temporalBlocking->Advance(m_execCtrl, timeStep); stableTimeStep < timeStep;
+             stableTimeStep = m_temporalBlocking->Advance(m_execCtrl, timeStep)) {
+            timeStep = BLOCK_CFL_FRACTION * stableTimeStep;
+            m_blockDuration = numSteps * timeStep;
+            if (timeStep < 1e-15) {
+                throw Error::NON_PHYSICAL_STATE;
+            }
+        }
+        return;
+    }
+    AdvanceLevels();
+}
+
+void Solver::PerformTimeStep(double const fixedTimeStep) {
+    ExecutionController::ScopedRegion stepRegion(m_execCtrl, "TimeStep");
+    timeStep = fixedTimeStep;
+    AdvanceLevels();
+}
+
+void Solver::AdvanceLevels() {
+    if (!m_refinement) {
+        AdvanceStages();
+        return;
+    }
+    m_refinement->BeginStep(m_execCtrl);
+    AdvanceStages();
+    ExecutionController::ScopedRegion region(m_execCtrl, "Refinement");
+    m_refinement->EndStep(m_execCtrl, timeStep);
+}
+
+void Solver::AdvanceStages() {
+    WithFaceStages([this](auto& stages) { AdvanceStages(stages); });
+}
+
+template <typename Real>
+void Solver::AdvanceStages(FaceStages<Real>& stages) {
+    using Region = ExecutionController::ScopedRegion;
+
+    // Every stage of every tile, each starting as soon as what it reads is ready
+    if (m_taskGraph) {
+        Region region(m_execCtrl, "TaskGraph");
+        auto const start = std::chrono::steady_clock::now();
+        m_scheduler->Run(*m_taskGraph);
+        if (m_tuningStep < TUNING_STEPS_PER_SIZE * m_tileCandidates.size()) {
+            TuneTileSize(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return;
+    }
+
+    // Post the halo messages, which read only interior cells
+    if (m_haloExchange) {
+        Region region(m_execCtrl, "HaloExchange");
+        m_haloExchange->Begin(m_execCtrl);
+    }
 
     // Apply boundary conditions
-    m_boundCon->ApplyBoundaryConditions(m_execCtrl);
+    {
+        Region region(m_execCtrl, "BoundaryConditions");
+        m_boundCon->ApplyBoundaryConditions(m_execCtrl);
+    }
+
+    if (m_haloExchange && !m_overlapHalo) {
+        Region region(m_execCtrl, "HaloWait");
+        m_haloExchange->End(m_execCtrl);
+    }
 
-    // Compute the face-centered states
-    m_reconstruction->ComputeLeftRightStates(m_execCtrl);
+    if (m_overlapHalo) {
+        // Faces clear of the halo go first, hiding the messages behind their work
+        std::vector<std::size_t> const& interiorFaces = m_activity ? m_activity->ActiveFaces() : m_interiorFaces;
+        {
+            Region region(m_execCtrl, "Reconstruction");
+            stages.reconstruction->ComputeLeftRightStates(m_execCtrl, interiorFaces);
+        }
+        {
+            Region region(m_execCtrl, "Flux");
+            stages.flux->ComputeInterfaceFluxes(m_execCtrl, interiorFaces);
+        }
 
-    // Compute the face-centered fluxes
-    m_flux->ComputeInterfaceFluxes(m_execCtrl);
+        // Whatever time is spent here is communication the interior faces did not cover
+        {
+            Region region(m_execCtrl, "HaloWait");
+            m_haloExchange->End(m_execCtrl);
+        }
+        {
+            Region region(m_execCtrl, "Reconstruction");
+            stages.reconstruction->ComputeLeftRightStates(m_execCtrl, m_haloFaces);
+        }
+        {
+            Region region(m_execCtrl, "Flux");
+            stages.flux->ComputeInterfaceFluxes(m_execCtrl, m_haloFaces);
+        }
+    } else if (m_activity) {
+        // Only the faces of the active tiles
+        {
+            Region region(m_execCtrl, "Reconstruction");
+            stages.reconstruction->ComputeLeftRightStates(m_execCtrl, m_activity->ActiveFaces());
+        }
+        {
+            Region region(m_execCtrl, "Flux");
+            stages.flux->ComputeInterfaceFluxes(m_execCtrl, m_activity->ActiveFaces());
+        }
+    } else {
+        // Compute the face-centered states
+        {
+            Region region(m_execCtrl, "Reconstruction");
+            stages.reconstruction->ComputeLeftRightStates(m_execCtrl);
+        }
+
+        // Compute the face-centered fluxes
+        {
+            Region region(m_execCtrl, "Flux");
+            stages.flux->ComputeInterfaceFluxes(m_execCtrl);
+        }
+    }
+
+    if (m_activity) {
+        {
+            Region region(m_execCtrl, "Residual");
+            stages.residual->ComputeResidual(m_execCtrl, m_activity->ActiveCells());
+        }
+        {
+            Region region(m_execCtrl, "Integration");
+            m_integrator->Integrate(m_execCtrl, m_activity->ActiveCells());
+        }
+
+        // The residuals just computed decide the tiles of the next step
+        Region region(m_execCtrl, "Activity");
+        ResidualContext<Real> const& rc = stages.residual->GetContext();
+        m_activity->Update(m_execCtrl, {&rc.rhoRes, &rc.rhoURes, &rc.rhoVRes, &rc.rhoWRes,
+                                        &rc.rhoERes, &rc.bxRes, &rc.byRes, &rc.bzRes});
+        return;
+    }
 
     // Compute the cell-centered residuals
-    m_residual->ComputeResidual(m_execCtrl);
+    {
+        Region region(m_execCtrl, "Residual");
+        stages.residual->ComputeResidual(m_execCtrl);
+    }
 
     // Integrate over the timestep to update the conserved variables
-    m_integrator->Integrate(m_execCtrl);
+    {
+        Region region(m_execCtrl, "Integration");
+        m_integrator->Integrate(m_execCtrl);
+    }
 }
 
 void Solver::PrimFromCons() {
+    ExecutionController::ScopedRegion region(m_execCtrl, "PrimFromCons");
     std::size_t const numCells = m_grid.NumCells();
 
+    // With activity tracking, only the cells changed since the primitives were last brought up to date
+    std::vector<std::size_t> const* const cells = m_activity ? &m_activity->TakeStaleCells() : nullptr;
+    auto launch = [this, numCells, cells](auto& kernel) {
+        if (cells) {
+            m_execCtrl.LaunchKernel(kernel, *cells);
+        } else {
+            m_execCtrl.LaunchKernel(kernel, numCells);
+        }
+    };
+
     VelocityKernel velKern(m_varStore);
-    m_execCtrl.LaunchKernel(velKern, numCells);
+    launch(velKern);
 
     SpecificInternalEnergyKernel eKern(m_varStore);
-    m_execCtrl.LaunchKernel(eKern, numCells);
+    launch(eKern);
 
     CaloricallyPerfectGasPressureKernel pKern(m_varStore);
-    m_execCtrl.LaunchKernel(pKern, numCells);
+    launch(pKern);
 
     CaloricallyPerfectGasTemperatureKernel tKern(m_varStore);
-    m_execCtrl.LaunchKernel(tKern, numCells);
+    launch(tKern);
 
     CaloricallyPerfectGasSoundSpeedKernel ccKern(m_varStore);
-    m_execCtrl.LaunchKernel(ccKern, numCells);
+    launch(ccKern);
 }
 
 void Solver::ConsFromPrim() {
@@ -73,20 +562,47 @@ void Solver::ConsFromPrim() {
     m_execCtrl.LaunchKernel(totalEnergyDensityKern, numCells);
 }
 
-void Solver::CalculateTimeStep() {
+double Solver::StableTimeStep() {
+    if (!m_grid.IsUniform()) {
+        MaximumWaveRateKernel rateKern(m_varStore, m_grid.CellWidths());
+        m_execCtrl.LaunchKernel(rateKern, m_grid.NumCells());
+        if (m_communicator) {
+            m_varStore.sMaxOverWidth = m_communicator->AllReduceMax(m_varStore.sMaxOverWidth);
+        }
+        return cfl / m_varStore.sMaxOverWidth;
+    }
+
     MaximumWaveSpeedKernel sMaxKern(m_varStore);
     m_execCtrl.LaunchKernel(sMaxKern, m_grid.NumCells());
 
-    timeStep = cfl * m_grid.CellSize()[0] / m_varStore.sMax;
+    // Every rank must take the same step
+    if (m_communicator) {
+        m_varStore.sMax = m_communicator->AllReduceMax(m_varStore.sMax);
+    }
+
+    return cfl * m_grid.CellSize()[0] / m_varStore.sMax;
+}
+
+void Solver::CalculateTimeStep() {
+    double const stableTimeStep = StableTimeStep();
+    if (m_temporalBlocking) {
+        // A limited block ends exactly on the limit, however its steps round
+        double const numSteps = static_cast<double>(m_temporalBlocking->NumSteps());
+        timeStep = std::min(BLOCK_CFL_FRACTION * stableTimeStep, maxTimeStep / numSteps);
+        m_blockDuration = timeStep < maxTimeStep / numSteps ? numSteps * timeStep : maxTimeStep;
+    } else {
+        timeStep = std::min(stableTimeStep, maxTimeStep);
+    }
     if (timeStep < 1e-15) {
-        throw;
+        throw Error::NON_PHYSICAL_STATE;
     }
 }
 
 std::unique_ptr<ISolver> solverFactory(Profile const& profile, ExecutionController const& execCtrl,
-                                       VariableStore& varStore, IGrid const& grid) {
+                                       VariableStore& varStore, IGrid const& grid,
+                                       Decomposition const* decomposition) {
     if (profile.m_compressibleOption == CompressibleOption::COMPRESSIBLE) {
-        return std::make_unique<Solver>(profile, execCtrl, varStore, grid);
+        return std::make_unique<Solver>(profile, execCtrl, varStore, grid, decomposition);
     }
     return nullptr;
 }
@@ -1,18 +1,27 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <limits>
 #include <memory>
+#include <vector>
 
 namespace MHD {
 
+class ActivityTracker;
+class AdaptiveRefinement;
 class ExecutionController;
+class HaloExchange;
 class IBoundaryCondition;
-class IFlux;
+class ICommunicator;
 class IGrid;
 class IIntegrator;
-class IReconstruction;
 class Profile;
-class Residual;
+class TaskGraph;
+class TaskScheduler;
+class TemporalBlocking;
 class VariableStore;
+struct Decomposition;
 
 class ISolver {
 public:
@@ -20,37 +29,133 @@ public:
     virtual void PerformTimeStep() = 0;
     virtual double const TimeStep() const = 0;
     virtual void PrimFromCons() = 0;
+
+    // Caps the CFL timestep of the following steps, so a driver can land exactly on a requested time
+    virtual void LimitTimeStep(double const maxTimeStep) = 0;
+
+    // The conserved variables were set from outside the solver, e.g. by an initial condition or a
+    // restart, so no cell may be assumed unchanged since the last step
+    virtual void StateReplaced() = 0;
 };
 
 class Solver : public ISolver {
 public:
+    // With a decomposition the grid is one part of the domain, and its boundaries with a neighbour
+    // rank are filled by a halo exchange and the timestep is agreed across ranks
     Solver(Profile const& profile, ExecutionController const& execCtrl,
-           VariableStore& varStore, IGrid const& grid);
+           VariableStore& varStore, IGrid const& grid, Decomposition const* decomposition = nullptr);
+    ~Solver();
     
     void ConsFromPrim();
     
     void PerformTimeStep();
 
+    // One step of the given length in place of the CFL timestep, e.g. for a window of a temporal block
+    void PerformTimeStep(double const fixedTimeStep);
+
     void PrimFromCons();
 
     void CalculateTimeStep();
 
-    double const TimeStep() const { return timeStep; }
+    // The longest step the CFL condition allows on this grid, whose patches subcycle within it
+    double StableTimeStep();
+
+    // With temporal blocking, the time covered by the whole block
+    double const TimeStep() const { return m_temporalBlocking ? m_blockDuration : timeStep; }
+
+    void LimitTimeStep(double const maxTimeStep) { this->maxTimeStep = maxTimeStep; }
+
+    void StateReplaced();
+
+    // Interior cells per tile of a tiled step, zero for a staged one; changes while the size is tuned
+    std::size_t TileCells() const { return m_tileCellsPerTile; }
+
+    // Cells the next step will update, all of them unless quiescent tiles are skipped
+    std::size_t NumActiveCells() const;
+
+    // Cell updates of the next step, counting those of every refined patch
+    std::size_t NumCellUpdates() const;
+
+    // Conserved fluxes through a face in the last step, in the order of the conserved variables
+    std::array<double, 8> FaceFluxes(std::size_t const face) const;
 
 private:
+    void BuildTaskGraph(std::size_t const tileCells);
+    void TuneTileSize(double const seconds);
+    void AdvanceStages();
+    void AdvanceLevels();
+    void PlacePages();
+
+    // Reconstruction, flux and residual, whose face states and fluxes are stored as Real
+    template <typename Real>
+    struct FaceStages;
+
+    // Calls stage with the face stages of this solver, whichever precision they store
+    template <typename Stage>
+    void WithFaceStages(Stage&& stage);
+
+    template <typename Real>
+    void AdvanceStages(FaceStages<Real>& stages);
+
+    // Steps timed per candidate tile size, keeping the fastest, so one slow step does not decide
+    static std::size_t constexpr TUNING_STEPS_PER_SIZE = 2;
+
+    // A block of steps shares the timestep of its first, which keeps this much of the CFL limit so
+    // the wave speeds have room to grow over the block; a block they outgrow anyway is taken again
+    // on this much of the limit at its fastest step
+    static double constexpr BLOCK_CFL_FRACTION = 0.8;
+    static std::size_t constexpr DEFAULT_BLOCK_TILE_CELLS = 2048;
+    static std::size_t constexpr DEFAULT_ACTIVITY_TILE_CELLS = 256;
+
     double cfl = 0.4;
     double timeStep = 1e-5;
+    double maxTimeStep = std::numeric_limits<double>::infinity();
     std::unique_ptr<IBoundaryCondition> m_boundCon;
+    std::shared_ptr<ICommunicator> m_communicator;
+    std::unique_ptr<HaloExchange> m_haloExchange;
+
+    // With an overlapped halo exchange, faces whose stencil reaches a ghost cell it fills, and all the others
+    bool m_overlapHalo = false;
+    std::vector<std::size_t> m_haloFaces;
+    std::vector<std::size_t> m_interiorFaces;
+
+    // Task graph mode: faces and cells of each tile, and the stages of every tile as tasks
+    std::vector<std::vector<std::size_t>> m_tileFaces;
+    std::vector<std::vector<std::size_t>> m_tileCells;
+    std::unique_ptr<TaskGraph> m_taskGraph;
+    std::unique_ptr<TaskScheduler> m_scheduler;
+    std::size_t m_tileCellsPerTile = 0;
+
+    // With pinned threads, every stage of tile t runs on worker t * threads / tiles
+    bool m_staticTiles = false;
+
+    // Tile sizes still to be timed, with the best time of each so far
+    std::vector<std::size_t> m_tileCandidates;
+    std::vector<double> m_tileSeconds;
+    std::size_t m_tuningStep = 0;
+
+    // Temporal blocking mode: several steps per call, tile by tile
+    std::unique_ptr<TemporalBlocking> m_temporalBlocking;
+    double m_blockDuration = 0.0;
+
+    // Activity tracking mode: the faces and cells of the tiles a step can change
+    std::unique_ptr<ActivityTracker> m_activity;
+
+    // Refinement mode: patches at half the spacing, stepped after this grid and folded back into it
+    std::unique_ptr<AdaptiveRefinement> m_refinement;
+
     std::unique_ptr<IIntegrator> m_integrator;
-    std::unique_ptr<IFlux> m_flux;
-    std::unique_ptr<IReconstruction> m_reconstruction;
-    std::unique_ptr<Residual> m_residual;
+
+    // Exactly one is set: double face states, or float ones for mixed precision
+    std::unique_ptr<FaceStages<double>> m_doubleStages;
+    std::unique_ptr<FaceStages<float>> m_mixedStages;
     ExecutionController const& m_execCtrl;
     IGrid const& m_grid;
     VariableStore& m_varStore;
 };
 
 std::unique_ptr<ISolver> solverFactory(Profile const& profile, ExecutionController const& execCtrl,
-                                       VariableStore& varStore, IGrid const& grid);
+                                       VariableStore& varStore, IGrid const& grid,
+                                       Decomposition const* decomposition = nullptr);
 
 } // namespace MHD
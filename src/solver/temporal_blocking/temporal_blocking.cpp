@@ -0,0 +1,186 @@
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <grid.hpp>
+#include <halo/halo_exchange.hpp>
+#include <profile.hpp>
+#include <solver.hpp>
+#include <temporal_blocking/temporal_blocking.hpp>
+#include <variable_store.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace MHD {
+
+namespace {
+
+// Cells either side of a cell that its update reads, through the stencils of its two faces
+std::size_t constexpr STENCIL_REACH = 2;
+
+std::array<std::vector<double>*, TemporalBlocking::NUM_FIELDS> blockFields(VariableStore& vs) {
+    return {&vs.rho, &vs.rhoU, &vs.rhoV, &vs.rhoW, &vs.rhoE, &vs.bx, &vs.by, &vs.bz,
+            &vs.u, &vs.v, &vs.w, &vs.e, &vs.p, &vs.t, &vs.cs};
+}
+
+} // namespace
+
+struct BlockGatherKernel {
+    static constexpr KernelTraits TRAITS = {"BlockGather", 2 * TemporalBlocking::NUM_FIELDS * sizeof(double), 0};
+
+    BlockGatherKernel(std::array<std::vector<double>*, TemporalBlocking::NUM_FIELDS> const& fields,
+                      TemporalBlocking::Window& window, TemporalBlocking::Tile const& tile) :
+        m_fields(fields), m_window(window), m_tile(tile) {}
+
+    void operator()(std::size_t const j) {
+        std::size_t const i = m_tile.sources[j];
+        for (std::size_t f = 0; f < TemporalBlocking::NUM_FIELDS; ++f) {
+            (*m_window.fields[f])[j] = (*m_fields[f])[i];
+        }
+    }
+
+    std::array<std::vector<double>*, TemporalBlocking::NUM_FIELDS> const& m_fields;
+    TemporalBlocking::Window& m_window;
+    TemporalBlocking::Tile const& m_tile;
+};
+
+struct BlockScatterKernel {
+    static constexpr KernelTraits TRAITS = {"BlockScatter", 2 * TemporalBlocking::NUM_CONSERVED * sizeof(double), 0};
+
+    BlockScatterKernel(std::array<std::vector<double>, TemporalBlocking::NUM_CONSERVED>& results,
+                       TemporalBlocking::Window& window, TemporalBlocking::Tile const& tile) :
+        m_results(results), m_window(window), m_tile(tile) {}
+
+    void operator()(std::size_t const k) {
+        for (std::size_t f = 0; f < TemporalBlocking::NUM_CONSERVED; ++f) {
+            m_results[f][m_tile.firstCell + k] = (*m_window.fields[f])[m_tile.firstWindowCell + k];
+        }
+    }
+
+    std::array<std::vector<double>, TemporalBlocking::NUM_CONSERVED>& m_results;
+    TemporalBlocking::Window& m_window;
+    TemporalBlocking::Tile const& m_tile;
+};
+
+TemporalBlocking::TemporalBlocking(Profile const& profile, ExecutionController const& execCtrl, VariableStore& varStore,
+                                   IGrid const& grid, std::size_t const numSteps, std::size_t const tileCells) :
+    m_numSteps(numSteps), m_numCells(grid.NumCells()), m_fields(blockFields(varStore)) {
+    if (numSteps == 0 || tileCells == 0) {
+        throw Error::INVALID_TEMPORAL_BLOCK;
+    }
+    std::size_t const numCells = grid.NumCells();
+    std::size_t const numGhostLayers = grid.NumGhostLayers();
+    std::vector<BoundaryConditionOption> options = profile.m_boundaryConditionsOption;
+    if (options.empty()) {
+        options.assign(grid.NumBoundaries(), profile.m_boundaryConditionOption);
+    }
+    bool const periodic = BoundaryConditionOption::PERIODIC == options.front();
+
+    // The ghost layers of a window are only right at the start of the block, and every step after
+    // the first spoils another reach of cells inward, so a tile needs this many more on each side
+    std::size_t const margin = std::max(STENCIL_REACH * numSteps, numGhostLayers) - numGhostLayers;
+
+    // Windows are plain staged solvers whose inner boundaries are filled here rather than by a condition
+    Profile windowProfile = profile;
+    windowProfile.m_stepScheduleOption = StepScheduleOption::STAGED;
+    windowProfile.m_numThreadsOption = 1;
+    windowProfile.m_temporalBlockStepsOption = 1;
+
+    // Windows of one shape share a solver, except on stretched cells, whose widths differ window to window
+    std::map<std::tuple<std::size_t, bool, bool, std::size_t>, std::size_t> windowShapes;
+    for (std::size_t first = 0; first < numCells; first += tileCells) {
+        Tile tile;
+        tile.firstCell = first;
+        tile.numCells = std::min(tileCells, numCells - first);
+
+        // A window that would reach the ghost layers of the grid takes the boundary condition instead,
+        // unless the ends are joined, where it wraps around to the cells at the other end
+        long windowFirst = static_cast<long>(first) - static_cast<long>(margin);
+        long windowEnd = static_cast<long>(first + tile.numCells + margin);
+        bool const ownsLower = !periodic && windowFirst < static_cast<long>(numGhostLayers);
+        bool const ownsUpper = !periodic && windowEnd + static_cast<long>(numGhostLayers) > static_cast<long>(numCells);
+        if (ownsLower) {
+            windowFirst = 0;
+        }
+        if (ownsUpper) {
+            windowEnd = static_cast<long>(numCells);
+        }
+        std::size_t const windowCells = static_cast<std::size_t>(windowEnd - windowFirst);
+        tile.firstWindowCell = static_cast<std::size_t>(static_cast<long>(first) - windowFirst);
+        long const n = static_cast<long>(numCells);
+        auto wrap = [n](long const j) { return static_cast<std::size_t>(((j % n) + n) % n); };
+
+        auto const shape = std::make_tuple(windowCells, ownsLower, ownsUpper, grid.IsUniform() ? 0 : wrap(windowFirst));
+        auto const found = windowShapes.find(shape);
+        if (found != windowShapes.end()) {
+            tile.window = found->second;
+        } else {
+            tile.window = m_windows.size();
+            windowShapes[shape] = tile.window;
+
+            // Placed where the first tile of its shape sits, which only a uniform grid's steps do not notice
+            Window window;
+            window.grid = cellRangeGridFactory(windowProfile, wrap(windowFirst), windowCells);
+            window.varStore = std::make_unique<VariableStore>(*window.grid);
+            window.fields = blockFields(*window.varStore);
+            Decomposition decomposition;
+            decomposition.neighbourRanks = {ownsLower ? NO_NEIGHBOUR : FILLED_BY_OWNER,
+                                            ownsUpper ? NO_NEIGHBOUR : FILLED_BY_OWNER};
+            window.solver = std::make_unique<Solver>(windowProfile, execCtrl, *window.varStore, *window.grid,
+                                                     &decomposition);
+            m_windows.push_back(std::move(window));
+        }
+
+        // Interior cells of the window, then its ghost layers away from each boundary, see Cartesian1DGrid
+        for (std::size_t j = 0; j < windowCells; ++j) {
+            tile.sources.push_back(wrap(windowFirst + static_cast<long>(j)));
+        }
+        for (std::size_t k = 0; k < numGhostLayers; ++k) {
+            tile.sources.push_back(ownsLower ? numCells + k : wrap(windowFirst - 1 - static_cast<long>(k)));
+        }
+        for (std::size_t k = 0; k < numGhostLayers; ++k) {
+            tile.sources.push_back(ownsUpper ? numCells + numGhostLayers + k : wrap(windowEnd + static_cast<long>(k)));
+        }
+        m_tiles.push_back(std::move(tile));
+    }
+
+    for (std::vector<double>& result : m_results) {
+        result.resize(grid.NumNodes(), 0.0);
+    }
+}
+
+TemporalBlocking::~TemporalBlocking() = default;
+
+double TemporalBlocking::Advance(ExecutionController const& execCtrl, double const timeStep) {
+    double stableTimeStep = std::numeric_limits<double>::infinity();
+    for (Tile const& tile : m_tiles) {
+        Window& window = m_windows[tile.window];
+        BlockGatherKernel gatherKern(m_fields, window, tile);
+        execCtrl.LaunchKernel(gatherKern, tile.sources.size());
+
+        // The gathered primitives are already consistent, so the first step skips recomputing them
+        for (std::size_t step = 0; step < m_numSteps; ++step) {
+            if (step > 0) {
+                window.solver->PrimFromCons();
+                stableTimeStep = std::min(stableTimeStep, window.solver->StableTimeStep());
+                if (stableTimeStep < timeStep) {
+                    return stableTimeStep;
+                }
+            }
+            window.solver->PerformTimeStep(timeStep);
+        }
+
+        BlockScatterKernel scatterKern(m_results, window, tile);
+        execCtrl.LaunchKernel(scatterKern, tile.numCells);
+    }
+
+    // Ghost nodes keep their values, which only a boundary condition of the whole grid would change
+    for (std::size_t f = 0; f < NUM_CONSERVED; ++f) {
+        std::copy(m_fields[f]->begin() + m_numCells, m_fields[f]->end(), m_results[f].begin() + m_numCells);
+        m_fields[f]->swap(m_results[f]);
+    }
+    return stableTimeStep;
+}
+
+} // namespace MHD
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace MHD {
+
+class ExecutionController;
+class IGrid;
+class Profile;
+class Solver;
+class VariableStore;
+
+/**
+ * Advances the grid several steps at a time, one tile after another. Each tile is copied into a
+ * small solver of its own, together with enough cells either side of it for every stencil of every
+ * step, stepped there while it stays in cache, and copied back. The cells either side are computed
+ * again by the neighbouring tiles, which is the price of reading and writing the grid once per block
+ * rather than once per stage of every step. Every cell of a tile sees the same inputs as a step of
+ * the whole grid would give it, so the blocks match single steps of the same length bitwise.
+ */
+class TemporalBlocking {
+public:
+    TemporalBlocking(Profile const& profile, ExecutionController const& execCtrl, VariableStore& varStore,
+                     IGrid const& grid, std::size_t const numSteps, std::size_t const tileCells);
+    ~TemporalBlocking();
+
+    /**
+     * Steps every tile numSteps times by timeStep, from primitives consistent with the conserved
+     * variables. Returns the longest step the CFL condition allows over every window at the start of
+     * every step after the first; the grid is only updated when that is no shorter than timeStep,
+     * so a block whose waves sped up past the limit can be taken again on a shorter step.
+     */
+    double Advance(ExecutionController const& execCtrl, double const timeStep);
+
+    std::size_t NumSteps() const { return m_numSteps; }
+
+    // Conserved and primitive fields copied into a window, and the conserved ones copied back out
+    static std::size_t constexpr NUM_FIELDS = 15;
+    static std::size_t constexpr NUM_CONSERVED = 8;
+
+    // A solver over a window of the grid, shared by every tile whose window has its shape
+    struct Window {
+        std::unique_ptr<IGrid> grid;
+        std::unique_ptr<VariableStore> varStore;
+        std::unique_ptr<Solver> solver;
+        std::array<std::vector<double>*, NUM_FIELDS> fields;
+    };
+
+    struct Tile {
+        std::size_t window;
+        std::size_t firstCell;          // first cell of the grid the tile writes back
+        std::size_t numCells;
+        std::size_t firstWindowCell;    // interior cell of the window holding firstCell
+        std::vector<std::size_t> sources; // node of the grid copied into each node of the window
+    };
+
+private:
+    std::size_t const m_numSteps;
+    std::size_t const m_numCells;
+    std::array<std::vector<double>*, NUM_FIELDS> m_fields;
+
+    // The conserved fields after the block, swapped into the store once every tile has read its inputs
+    std::array<std::vector<double>, NUM_CONSERVED> m_results;
+
+    std::vector<Window> m_windows;
+    std::vector<Tile> m_tiles;
+};
+
+} // namespace MHD
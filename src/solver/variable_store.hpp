@@ -38,6 +38,7 @@ struct VariableStore {
     double const r = GAS_CONSTANT / 0.0280134; // specific gas constant for N2 [J/(kg K)]
     double const gamma = 1.4;           // ratio of C_p to C_v for N2 at 298 K and 1 atm
     double sMax = 0.0;
+    double sMaxOverWidth = 0.0; // largest wave speed over the width of its cell, on a stretched grid
 
     // Cell-centered
     // Conserved
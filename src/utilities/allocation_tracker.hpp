@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MHD {
+
+struct AllocationCounts {
+    std::uint64_t numAllocations = 0;
+    std::uint64_t numBytes = 0;
+};
+
+/**
+ * Heap allocations made by the calling thread since it started, counted by the global operator new
+ * replacements in allocation_hooks.cpp. Those are opt-in: only executables linking the
+ * allocation_hooks library count, elsewhere this stays zero. The difference of two reads
+ * attributes allocations to the code in between.
+ */
+AllocationCounts threadAllocationCounts();
+
+// Adds one allocation of the given size to the calling thread's counts, called by the hooks
+void countAllocation(std::size_t size);
+
+// Resident set size of the process now and at its peak, zero where /proc is unavailable
+std::size_t currentResidentBytes();
+std::size_t peakResidentBytes();
+
+// Restarts the peak at the current resident size, so a later peak covers only what follows
+void resetPeakResidentBytes();
+
+} // namespace MHD
@@ -0,0 +1,90 @@
+#include <communicator.hpp>
+#include <error.hpp>
+
+#if defined(MHD_HAVE_MPI)
+#include <mpi.h>
+
+#include <vector>
+#endif
+
+namespace MHD {
+
+// A single rank has no neighbours to message
+void SerialCommunicator::PostSend(int const, int const, double const*, std::size_t const) {
+    throw Error::INVALID_DECOMPOSITION;
+}
+
+void SerialCommunicator::PostReceive(int const, int const, double*, std::size_t const) {
+    throw Error::INVALID_DECOMPOSITION;
+}
+
+#if defined(MHD_HAVE_MPI)
+
+namespace {
+
+class MpiCommunicator : public ICommunicator {
+public:
+    MpiCommunicator(MPI_Comm const comm) : m_comm(comm) {
+        MPI_Comm_rank(m_comm, &m_rank);
+        MPI_Comm_size(m_comm, &m_size);
+    }
+
+    int Rank() const { return m_rank; }
+    int Size() const { return m_size; }
+
+    double AllReduceMax(double const value) const {
+        double result = value;
+        MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_MAX, m_comm);
+        return result;
+    }
+
+    void AllReduceSum(double* values, std::size_t const count) const {
+        MPI_Allreduce(MPI_IN_PLACE, values, static_cast<int>(count), MPI_DOUBLE, MPI_SUM, m_comm);
+    }
+
+    void PostSend(int const rank, int const tag, double const* data, std::size_t const count) {
+        m_requests.emplace_back();
+        MPI_Isend(data, static_cast<int>(count), MPI_DOUBLE, rank, tag, m_comm, &m_requests.back());
+    }
+
+    void PostReceive(int const rank, int const tag, double* data, std::size_t const count) {
+        m_requests.emplace_back();
+        MPI_Irecv(data, static_cast<int>(count), MPI_DOUBLE, rank, tag, m_comm, &m_requests.back());
+    }
+
+    void WaitAll() {
+        MPI_Waitall(static_cast<int>(m_requests.size()), m_requests.data(), MPI_STATUSES_IGNORE);
+        m_requests.clear();
+    }
+
+private:
+    MPI_Comm m_comm;
+    int m_rank = 0;
+    int m_size = 1;
+
+    // Keeps its capacity, so a steady exchange pattern does not allocate
+    std::vector<MPI_Request> m_requests;
+};
+
+} // namespace
+
+std::shared_ptr<ICommunicator> worldCommunicator() {
+    int initialized = 0;
+    int finalized = 0;
+    MPI_Initialized(&initialized);
+    MPI_Finalized(&finalized);
+    if (initialized && !finalized) {
+        return std::make_shared<MpiCommunicator>(MPI_COMM_WORLD);
+    }
+    return std::make_shared<SerialCommunicator>();
+}
+
+#else
+
+std::shared_ptr<ICommunicator> worldCommunicator() {
+    return std::make_shared<SerialCommunicator>();
+}
+
+#endif
+
+} // namespace MHD
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace MHD {
+
+// Neighbour rank of a boundary where the global domain ends
+int constexpr NO_NEIGHBOUR = -1;
+
+/**
+ * The collectives and point-to-point messages a decomposed calculation needs. Sends and receives
+ * are posted without blocking and completed together by WaitAll, so a caller can overlap them with
+ * work that does not touch the buffers. Every rank must make the same sequence of collective calls.
+ */
+class ICommunicator {
+public:
+    virtual ~ICommunicator() = default;
+
+    virtual int Rank() const = 0;
+    virtual int Size() const = 0;
+
+    virtual double AllReduceMax(double const value) const = 0;
+    virtual void AllReduceSum(double* values, std::size_t const count) const = 0;
+
+    virtual void PostSend(int const rank, int const tag, double const* data, std::size_t const count) = 0;
+    virtual void PostReceive(int const rank, int const tag, double* data, std::size_t const count) = 0;
+    virtual void WaitAll() = 0;
+};
+
+// One rank owning the whole domain, every collective is the identity
+class SerialCommunicator : public ICommunicator {
+public:
+    int Rank() const { return 0; }
+    int Size() const { return 1; }
+
+    double AllReduceMax(double const value) const { return value; }
+    void AllReduceSum(double*, std::size_t const) const {}
+
+    void PostSend(int const rank, int const tag, double const* data, std::size_t const count);
+    void PostReceive(int const rank, int const tag, double* data, std::size_t const count);
+    void WaitAll() {}
+};
+
+/**
+ * MPI_COMM_WORLD when the library is built with MPI and the program has initialized it, a serial
+ * communicator otherwise. Initializing and finalizing MPI is left to the program.
+ */
+std::shared_ptr<ICommunicator> worldCommunicator();
+
+} // namespace MHD
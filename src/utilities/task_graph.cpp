@@ -0,0 +1,266 @@
+#include <task_graph.hpp>
+#include <topology.hpp>
+#include <trace.hpp>
+
+#include <algorithm>
+
+namespace MHD {
+
+TaskGraph::TaskId TaskGraph::AddTask(char const* name, std::function<void()> work, std::size_t const worker) {
+    m_tasks.push_back({name, std::move(work), worker, 0, {}});
+    return m_tasks.size() - 1;
+}
+
+void TaskGraph::AddDependency(TaskId const before, TaskId const after) {
+    std::vector<TaskId>& successors = m_tasks.at(before).successors;
+    if (std::find(successors.begin(), successors.end(), after) != successors.end()) {
+        return;
+    }
+    successors.push_back(after);
+    ++m_tasks.at(after).numDependencies;
+}
+
+namespace {
+
+// CPUs held by the pinned workers of every scheduler in the process, once per worker
+std::mutex claimedCpusMutex;
+std::vector<int> claimedCpus;
+
+// Gives the calling thread its own CPUs back when a run it was pinned for ends, however it ends
+class ScopedPin {
+public:
+    ScopedPin(int const cpu, std::vector<int>& previous) : m_previous(previous) {
+        m_previous.clear();
+        if (cpu >= 0) {
+            currentThreadCpus(m_previous);
+            pinCurrentThread(cpu);
+        }
+    }
+    ~ScopedPin() {
+        if (!m_previous.empty()) {
+            setCurrentThreadCpus(m_previous.data(), m_previous.size());
+        }
+    }
+
+private:
+    std::vector<int>& m_previous;
+};
+
+} // namespace
+
+TaskScheduler::TaskScheduler(std::size_t const numThreads, std::string const& name, bool const pinThreads,
+                             std::size_t const cpuOffset) {
+    std::size_t const count = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t w = 0; w < count; ++w) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    std::vector<int> cpus = pinThreads ? cpusByNumaNode() : std::vector<int>();
+    if (!cpus.empty()) {
+        // From the offset on in node order, with the CPUs no other scheduler holds first
+        std::rotate(cpus.begin(), cpus.begin() + cpuOffset % cpus.size(), cpus.end());
+        std::lock_guard<std::mutex> lock(claimedCpusMutex);
+        std::stable_partition(cpus.begin(), cpus.end(), [](int const cpu) {
+            return std::find(claimedCpus.begin(), claimedCpus.end(), cpu) == claimedCpus.end();
+        });
+        for (std::size_t w = 0; w < count; ++w) {
+            m_cpus.push_back(cpus[w % cpus.size()]);
+        }
+        claimedCpus.insert(claimedCpus.end(), m_cpus.begin(), m_cpus.end());
+
+        // Room for any mask a caller may have, so runs do not allocate to keep it
+        m_callerCpus.reserve(std::max<std::size_t>(std::thread::hardware_concurrency(), cpus.size()));
+    }
+
+    // The calling thread is worker 0, so only the others get a thread of their own
+    for (std::size_t w = 1; w < count; ++w) {
+        m_threads.emplace_back(&TaskScheduler::WorkerLoop, this, w, name + " " + std::to_string(w),
+                               m_cpus.empty() ? -1 : m_cpus[w]);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_stop = true;
+    }
+    m_runStarted.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(claimedCpusMutex);
+    for (int const cpu : m_cpus) {
+        claimedCpus.erase(std::find(claimedCpus.begin(), claimedCpus.end(), cpu));
+    }
+}
+
+void TaskScheduler::Prepare(TaskGraph const& graph) {
+    std::size_t const numTasks = graph.NumTasks();
+    if (numTasks > m_capacity) {
+        m_remainingDependencies = std::make_unique<std::atomic<std::size_t>[]>(numTasks);
+        for (auto& worker : m_workers) {
+            worker->tasks.reserve(numTasks);
+            worker->own.reserve(numTasks);
+        }
+        m_capacity = numTasks;
+    }
+    for (auto& worker : m_workers) {
+        worker->tasks.clear();
+        worker->own.clear();
+        worker->front = 0;
+    }
+    for (std::size_t t = 0; t < numTasks; ++t) {
+        m_remainingDependencies[t].store(graph.m_tasks[t].numDependencies);
+    }
+    m_graph = &graph;
+    m_numUnfinished.store(numTasks);
+    m_exception = nullptr;
+    m_failed.store(false);
+}
+
+void TaskScheduler::Run(TaskGraph const& graph) {
+    ScopedPin const pin(m_cpus.empty() ? -1 : m_cpus[0], m_callerCpus);
+    Prepare(graph);
+
+    // Tasks ready from the start are dealt out in turn
+    std::size_t next = 0;
+    for (std::size_t t = 0; t < graph.NumTasks(); ++t) {
+        if (graph.m_tasks[t].numDependencies == 0) {
+            Push(next, t);
+            next = (next + 1) % m_workers.size();
+        }
+    }
+
+    if (!m_threads.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_runMutex);
+            ++m_generation;
+            m_numActiveHelpers = m_threads.size();
+        }
+        m_runStarted.notify_all();
+    }
+
+    Drain(0);
+
+    if (!m_threads.empty()) {
+        std::unique_lock<std::mutex> lock(m_runMutex);
+        m_runFinished.wait(lock, [this] { return m_numActiveHelpers == 0; });
+    }
+    m_graph = nullptr;
+
+    if (m_exception) {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+void TaskScheduler::WorkerLoop(std::size_t const w, std::string const name, int const cpu) {
+    Tracer::SetThreadName(name);
+    if (cpu >= 0) {
+        pinCurrentThread(cpu);
+    }
+    std::size_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_runMutex);
+            m_runStarted.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        Drain(w);
+
+        {
+            std::lock_guard<std::mutex> lock(m_runMutex);
+            --m_numActiveHelpers;
+        }
+        m_runFinished.notify_all();
+    }
+}
+
+void TaskScheduler::Drain(std::size_t const w) {
+    TaskGraph::TaskId id;
+    while (m_numUnfinished.load() > 0) {
+        if (Pop(w, id) || Steal(w, id)) {
+            Execute(w, id);
+        } else {
+            // Nothing ready anywhere yet, the tasks that will make some ready are running elsewhere
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool TaskScheduler::Pop(std::size_t const w, TaskGraph::TaskId& id) {
+    Worker& worker = *m_workers[w];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.own.empty()) {
+        id = worker.own.back();
+        worker.own.pop_back();
+        return true;
+    }
+    if (worker.tasks.size() == worker.front) {
+        return false;
+    }
+    id = worker.tasks.back();
+    worker.tasks.pop_back();
+    if (worker.tasks.size() == worker.front) {
+        worker.tasks.clear();
+        worker.front = 0;
+    }
+    return true;
+}
+
+bool TaskScheduler::Steal(std::size_t const w, TaskGraph::TaskId& id) {
+    std::size_t const numWorkers = m_workers.size();
+    for (std::size_t k = 1; k < numWorkers; ++k) {
+        Worker& victim = *m_workers[(w + k) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.size() > victim.front) {
+            id = victim.tasks[victim.front++];
+            if (victim.tasks.size() == victim.front) {
+                victim.tasks.clear();
+                victim.front = 0;
+            }
+            m_numSteals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::Push(std::size_t const w, TaskGraph::TaskId const id) {
+    std::size_t const home = m_graph->m_tasks[id].worker;
+    bool const homed = home != TaskGraph::ANY_WORKER;
+    Worker& worker = *m_workers[homed ? home % m_workers.size() : w];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    (homed ? worker.own : worker.tasks).push_back(id);
+}
+
+void TaskScheduler::Execute(std::size_t const w, TaskGraph::TaskId const id) {
+    TaskGraph::Task const& task = m_graph->m_tasks[id];
+
+    // After a failure the remaining tasks are only retired, so the run still ends
+    if (!m_failed.load()) {
+        ScopedTrace trace(task.name, "task");
+        try {
+            task.work();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_exceptionMutex);
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+            m_failed.store(true);
+        }
+    }
+
+    // Successors are queued before this task counts as finished, so no thread stops while work remains
+    for (TaskGraph::TaskId const successor : task.successors) {
+        if (m_remainingDependencies[successor].fetch_sub(1) == 1) {
+            Push(w, successor);
+        }
+    }
+    m_numUnfinished.fetch_sub(1);
+}
+
+} // namespace MHD
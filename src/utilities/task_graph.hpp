@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Tasks and the order they must run in, built once and run many times. A task starts only after
+ * every task it depends on has finished; tasks with no path between them may run concurrently, so
+ * they must not touch the same data.
+ */
+class TaskGraph {
+public:
+    using TaskId = std::size_t;
+
+    // A task given a worker runs only on that one, modulo the number of workers, and is never
+    // stolen; worker 0 is the thread that calls TaskScheduler::Run, e.g. for MPI calls
+    static std::size_t constexpr ANY_WORKER = static_cast<std::size_t>(-1);
+
+    TaskId AddTask(char const* name, std::function<void()> work, std::size_t const worker = ANY_WORKER);
+    void AddDependency(TaskId const before, TaskId const after);
+
+    std::size_t NumTasks() const { return m_tasks.size(); }
+
+private:
+    friend class TaskScheduler;
+
+    struct Task {
+        char const* name;
+        std::function<void()> work;
+        std::size_t worker;
+        std::size_t numDependencies = 0;
+        std::vector<TaskId> successors;
+    };
+
+    std::vector<Task> m_tasks;
+};
+
+/**
+ * Runs task graphs on a fixed set of threads, the calling thread being one of them. Every thread
+ * owns a deque of ready tasks: it pushes the tasks it makes ready and pops them from the back, so
+ * a tile's next stage tends to run on the thread that holds its data in cache, while an idle
+ * thread steals from the front of another's deque. Once set up for a graph, a run does not
+ * allocate.
+ */
+class TaskScheduler {
+public:
+    /**
+     * Zero threads means one per hardware thread. Pinning binds each worker to one CPU, in NUMA node
+     * order from cpuOffset on, so neighbouring workers share a node; CPUs held by the pinned workers
+     * of other schedulers in the process are passed over while free ones remain, and an offset keeps
+     * processes that share a node, e.g. ranks, apart. The thread calling Run is worker 0, pinned
+     * only for the length of each run and given back its own CPUs after it.
+     */
+    TaskScheduler(std::size_t const numThreads = 0, std::string const& name = "task", bool const pinThreads = false,
+                  std::size_t const cpuOffset = 0);
+    ~TaskScheduler();
+
+    // Blocks until every task has run, then rethrows the first exception a task threw, if any
+    void Run(TaskGraph const& graph);
+
+    std::size_t NumThreads() const { return m_workers.size(); }
+
+    // CPU of each worker when pinned, empty otherwise
+    std::vector<int> const& Cpus() const { return m_cpus; }
+
+    // Tasks taken from another thread's deque over every run so far
+    std::size_t NumSteals() const { return m_numSteals.load(std::memory_order_relaxed); }
+
+private:
+    // Ready tasks of one thread; the owner works at the back and thieves take from the front
+    struct Worker {
+        std::mutex mutex;
+        std::vector<TaskGraph::TaskId> tasks;
+        std::size_t front = 0;
+        std::vector<TaskGraph::TaskId> own; // tasks given to this worker, never stolen
+    };
+
+    void Prepare(TaskGraph const& graph);
+    void WorkerLoop(std::size_t const w, std::string const name, int const cpu);
+    void Drain(std::size_t const w);
+    bool Pop(std::size_t const w, TaskGraph::TaskId& id);
+    bool Steal(std::size_t const w, TaskGraph::TaskId& id);
+    void Push(std::size_t const w, TaskGraph::TaskId const id);
+    void Execute(std::size_t const w, TaskGraph::TaskId const id);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::vector<int> m_cpus;
+    std::vector<int> m_callerCpus; // CPUs of the thread calling Run, given back to it after the run
+
+    // State of the current run
+    TaskGraph const* m_graph = nullptr;
+    std::unique_ptr<std::atomic<std::size_t>[]> m_remainingDependencies;
+    std::size_t m_capacity = 0;
+    std::atomic<std::size_t> m_numUnfinished{0};
+    std::exception_ptr m_exception;
+    std::mutex m_exceptionMutex;
+    std::atomic<bool> m_failed{false};
+    std::atomic<std::size_t> m_numSteals{0};
+
+    // Wakes the helper threads for a run and puts them back to sleep after it
+    std::mutex m_runMutex;
+    std::condition_variable m_runStarted;
+    std::condition_variable m_runFinished;
+    std::size_t m_generation = 0;
+    std::size_t m_numActiveHelpers = 0;
+    bool m_stop = false;
+};
+
+} // namespace MHD
@@ -0,0 +1,64 @@
+#include <thread_pool.hpp>
+#include <trace.hpp>
+
+#include <algorithm>
+
+namespace MHD {
+
+ThreadPool::ThreadPool(std::size_t const numThreads, std::string const& name) {
+    std::size_t const count = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t t = 0; t < count; ++t) {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this, name + " " + std::to_string(t));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_taskPending.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskPending.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_tasks.empty() && m_numRunning == 0; });
+}
+
+void ThreadPool::WorkerLoop(std::string const name) {
+    Tracer::SetThreadName(name);
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskPending.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_numRunning;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_numRunning;
+        }
+        m_idle.notify_all();
+    }
+}
+
+} // namespace MHD
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MHD {
+
+/**
+ * Fixed set of worker threads draining one FIFO queue of tasks. Tasks must not throw; anything a
+ * task needs to report goes through state it captures. Wait blocks until the queue is empty and
+ * every worker is idle, so one pool can run several batches in turn.
+ */
+class ThreadPool {
+public:
+    // Zero threads means one per hardware thread
+    ThreadPool(std::size_t const numThreads = 0, std::string const& name = "worker");
+    ~ThreadPool();
+
+    void Submit(std::function<void()> task);
+    void Wait();
+
+    std::size_t NumThreads() const { return m_threads.size(); }
+
+private:
+    void WorkerLoop(std::string const name);
+
+    std::deque<std::function<void()>> m_tasks;
+    std::size_t m_numRunning = 0;
+    bool m_stop = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskPending;
+    std::condition_variable m_idle;
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace MHD
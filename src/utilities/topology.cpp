@@ -0,0 +1,144 @@
+#include <topology.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace MHD {
+
+namespace {
+
+// Parses a kernel CPU list such as "0-3,8-11"
+std::vector<int> parseCpuList(std::string const& list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        std::size_t const dash = range.find('-');
+        int const first = std::stoi(range.substr(0, dash));
+        int const last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+template <typename T>
+bool discardZeroPagesOf(T const* data, std::size_t const count) {
+#ifdef __linux__
+    if (std::any_of(data, data + count, [](T const value) { return value != 0.0; })) {
+        return false;
+    }
+
+    // Only pages wholly inside the range, so no neighbouring allocation loses anything
+    std::uintptr_t const pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::uintptr_t const begin = reinterpret_cast<std::uintptr_t>(data);
+    std::uintptr_t const end = reinterpret_cast<std::uintptr_t>(data + count);
+    std::uintptr_t const first = (begin + pageSize - 1) / pageSize * pageSize;
+    std::uintptr_t const last = end / pageSize * pageSize;
+    return last <= first || madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED) == 0;
+#else
+    (void)data;
+    (void)count;
+    return false;
+#endif
+}
+
+} // namespace
+
+std::vector<int> cpusByNumaNode() {
+    std::vector<int> allowed;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#endif
+
+    // Node by node from sysfs, then whatever no node lists, e.g. where there is no sysfs at all
+    std::vector<int> ordered;
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) {
+            break;
+        }
+        std::string list;
+        std::getline(file, list);
+        for (int const cpu : parseCpuList(list)) {
+            if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                ordered.push_back(cpu);
+            }
+        }
+    }
+    for (int const cpu : allowed) {
+        if (std::find(ordered.begin(), ordered.end(), cpu) == ordered.end()) {
+            ordered.push_back(cpu);
+        }
+    }
+    return ordered;
+}
+
+bool pinCurrentThread(int const cpu) {
+    return setCurrentThreadCpus(&cpu, 1);
+}
+
+void currentThreadCpus(std::vector<int>& cpus) {
+    cpus.clear();
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+}
+
+bool setCurrentThreadCpus(int const* cpus, std::size_t const count) {
+#ifdef __linux__
+    if (count == 0) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (std::size_t k = 0; k < count; ++k) {
+        CPU_SET(cpus[k], &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    (void)count;
+    return false;
+#endif
+}
+
+bool discardZeroPages(double const* data, std::size_t const count) {
+    return discardZeroPagesOf(data, count);
+}
+
+bool discardZeroPages(float const* data, std::size_t const count) {
+    return discardZeroPagesOf(data, count);
+}
+
+} // namespace MHD
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace MHD {
+
+// CPUs this process may run on, those of NUMA node 0 first, then node 1 and so on
+std::vector<int> cpusByNumaNode();
+
+// Binds the calling thread to one CPU, false where the platform does not allow it
+bool pinCurrentThread(int const cpu);
+
+// CPUs the calling thread may run on, e.g. to hand back to it after pinning it for a while; fills
+// cpus in place, so storage reserved beforehand is reused
+void currentThreadCpus(std::vector<int>& cpus);
+
+// Lets the calling thread run on any of the given CPUs, false where the platform does not allow it
+bool setCurrentThreadCpus(int const* cpus, std::size_t const count);
+
+/**
+ * Hands the whole pages inside a range of zeros back to the operating system. They still read as
+ * zero, and the next thread to write one gets it on its own NUMA node, so data allocated on one
+ * thread can be placed by the threads that will work on it. Returns false, leaving the range as it
+ * was, if it holds anything but zeros or the platform does not allow it.
+ */
+bool discardZeroPages(double const* data, std::size_t const count);
+bool discardZeroPages(float const* data, std::size_t const count);
+
+} // namespace MHD
@@ -0,0 +1,170 @@
+#include <error.hpp>
+#include <trace.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MHD {
+
+namespace {
+
+// Single-producer ring, only its owning thread writes events
+struct ThreadRing {
+    std::vector<TraceEvent> events;
+    std::atomic<std::uint64_t> numRecorded{0};
+    std::string threadName;
+    std::size_t threadId;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::size_t eventsPerThread = Tracer::DEFAULT_EVENTS_PER_THREAD;
+    Tracer::Clock::time_point const epoch = Tracer::Clock::now();
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry traceRegistry;
+    return traceRegistry;
+}
+
+thread_local ThreadRing* t_ring = nullptr;
+thread_local std::string t_threadName;
+
+ThreadRing& threadRing() {
+    if (!t_ring) {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto ring = std::make_unique<ThreadRing>();
+        ring->events.resize(reg.eventsPerThread);
+        ring->threadId = reg.rings.size() + 1;
+        ring->threadName = t_threadName.empty() ? "thread " + std::to_string(ring->threadId) : t_threadName;
+        t_ring = ring.get();
+        reg.rings.push_back(std::move(ring));
+    }
+    return *t_ring;
+}
+
+void writeJsonString(std::ostream& os, char const* value) {
+    os << '"';
+    for (char const* c = value; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            os << '\\';
+        }
+        os << *c;
+    }
+    os << '"';
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::s_enabled{false};
+
+void Tracer::Enable(std::size_t const eventsPerThread) {
+    TraceRegistry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.eventsPerThread = std::max<std::size_t>(eventsPerThread, 1);
+        for (auto& ring : reg.rings) {
+            if (ring->events.size() != reg.eventsPerThread) {
+                ring->events.assign(reg.eventsPerThread, TraceEvent{});
+                ring->numRecorded.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Disable() {
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::Clear() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& ring : reg.rings) {
+        ring->numRecorded.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::SetThreadName(std::string const& name) {
+    // The ring is only allocated by the first record, so naming a thread costs nothing untraced
+    t_threadName = name;
+    if (t_ring) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        t_ring->threadName = name;
+    }
+}
+
+void Tracer::Record(char const* name, char const* category, Clock::time_point const start,
+                    Clock::time_point const end, std::uint64_t const numItems) {
+    if (!Enabled()) {
+        return;
+    }
+    ThreadRing& ring = threadRing();
+    Clock::time_point const epoch = registry().epoch;
+    std::uint64_t const n = ring.numRecorded.load(std::memory_order_relaxed);
+    ring.events[n % ring.events.size()] = {
+        name, category,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        numItems,
+    };
+    ring.numRecorded.store(n + 1, std::memory_order_release);
+}
+
+std::size_t Tracer::NumEvents() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::size_t numEvents = 0;
+    for (auto const& ring : reg.rings) {
+        numEvents += std::min<std::uint64_t>(ring->numRecorded.load(std::memory_order_acquire), ring->events.size());
+    }
+    return numEvents;
+}
+
+void Tracer::WriteChromeTrace(std::string const& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw Error::FILE_IO;
+    }
+
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    // Timestamps are in microseconds, three decimals keep nanosecond resolution
+    file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    for (auto const& ring : reg.rings) {
+        file << (first ? "" : ",") << "\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << ring->threadId
+             << ", \"args\": {\"name\": ";
+        writeJsonString(file, ring->threadName.c_str());
+        file << "}}";
+        first = false;
+
+        // Oldest surviving event first
+        std::uint64_t const numRecorded = ring->numRecorded.load(std::memory_order_acquire);
+        std::size_t const capacity = ring->events.size();
+        std::uint64_t const begin = numRecorded > capacity ? numRecorded - capacity : 0;
+        for (std::uint64_t e = begin; e < numRecorded; ++e) {
+            TraceEvent const& event = ring->events[e % capacity];
+            file << ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->threadId << ", \"name\": ";
+            writeJsonString(file, event.name);
+            file << ", \"cat\": ";
+            writeJsonString(file, event.category);
+            file << ", \"ts\": " << 1e-3 * event.startNs << ", \"dur\": " << 1e-3 * event.durationNs
+                 << ", \"args\": {\"items\": " << event.numItems << "}}";
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file) {
+        throw Error::FILE_IO;
+    }
+}
+
+} // namespace MHD
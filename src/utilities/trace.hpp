@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace MHD {
+
+struct TraceEvent {
+    char const* name;       // must outlive the tracer, e.g. a string literal
+    char const* category;
+    std::int64_t startNs;
+    std::int64_t durationNs;
+    std::uint64_t numItems;
+};
+
+/**
+ * Process-wide timeline of complete events for Chrome's trace viewer and Perfetto. Every thread
+ * records into its own fixed-size ring buffer without locking; once a ring is full the oldest
+ * events are overwritten. While tracing is disabled a record is a single relaxed load.
+ *
+ * WriteChromeTrace reads every ring, so call it while no other thread is recording.
+ */
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static std::size_t constexpr DEFAULT_EVENTS_PER_THREAD = std::size_t(1) << 16;
+
+    static void Enable(std::size_t const eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+    static void Disable();
+    static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Drops every recorded event, rings stay allocated
+    static void Clear();
+
+    // Label for the calling thread in the viewer
+    static void SetThreadName(std::string const& name);
+
+    static void Record(char const* name, char const* category, Clock::time_point const start,
+                       Clock::time_point const end, std::uint64_t const numItems = 0);
+
+    static std::size_t NumEvents();
+
+    static void WriteChromeTrace(std::string const& filename);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Records the lifetime of the scope as one event when tracing is enabled
+class ScopedTrace {
+public:
+    ScopedTrace(char const* name, char const* category, std::uint64_t const numItems = 0) :
+        m_name(name), m_category(category), m_numItems(numItems), m_enabled(Tracer::Enabled()) {
+        if (m_enabled) {
+            m_start = Tracer::Clock::now();
+        }
+    }
+
+    ~ScopedTrace() {
+        if (m_enabled) {
+            Tracer::Record(m_name, m_category, m_start, Tracer::Clock::now(), m_numItems);
+        }
+    }
+
+    ScopedTrace(ScopedTrace const&) = delete;
+    ScopedTrace& operator=(ScopedTrace const&) = delete;
+
+private:
+    char const* m_name;
+    char const* m_category;
+    std::uint64_t m_numItems;
+    bool m_enabled;
+    Tracer::Clock::time_point m_start;
+};
+
+} // namespace MHD
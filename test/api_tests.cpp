@@ -1,10 +1,24 @@
 #include <calc.hpp>
+#include <checkpoint.hpp>
+#include <ensemble.hpp>
+#include <error.hpp>
+#include <grid.hpp>
 #include <profile.hpp>
 #include <profile_options.hpp>
+#include <reference/exact_riemann.hpp>
+#include <snapshot.hpp>
+#include <time_series.hpp>
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <vector>
 
 using namespace MHD;
 
@@ -41,4 +55,703 @@ TEST(APITests, RunBrioWuShockTube) {
     MHD::Calc calc(profile);
     calc.SetInitialCondition(InitialCondition::BRIO_WU_SHOCK_TUBE);
     calc.Run();
-}
\ No newline at end of file
+}
+TEST(APITests, RunSodShockTubeMixedBoundaries) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_boundaryConditionsOption = {MHD::BoundaryConditionOption::REFLECTIVE, MHD::BoundaryConditionOption::OUTFLOW};
+    profile.m_numGhostLayersOption = 2;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    calc.Run();
+
+    // No flux crosses the wall, so the flow next to it stays far slower than the one leaving the open end
+    MHD::StateView const state = calc.State();
+    EXPECT_LT(std::fabs(state.u[0]), 0.1 * std::fabs(state.u[state.numCells - 1]));
+
+    // With the wall and the open end swapped, the mirrored tube stays the mirror image. Constant
+    // states treat the two sides of every face alike, which makes the comparison exact to round-off
+    profile.m_reconstructionOption = MHD::ReconstructionOption::CONSTANT;
+    MHD::Profile mirroredProfile = profile;
+    mirroredProfile.m_boundaryConditionsOption = {MHD::BoundaryConditionOption::OUTFLOW, MHD::BoundaryConditionOption::REFLECTIVE};
+    MHD::Calc original(profile);
+    MHD::Calc mirrored(mirroredProfile);
+    original.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    MHD::StateView const initial = original.State();
+    std::vector<std::vector<double>> fields;
+    for (MHD::FieldView const* field : {&initial.rho, &initial.rhoU, &initial.rhoV, &initial.rhoW, &initial.rhoE,
+                                        &initial.bx, &initial.by, &initial.bz}) {
+        fields.emplace_back(std::make_reverse_iterator(field->end()), std::make_reverse_iterator(field->begin()));
+    }
+    for (std::size_t const normal : {1, 5}) {
+        for (double& value : fields[normal]) {
+            value = -value;
+        }
+    }
+    MHD::StateView reversed = initial;
+    MHD::FieldView* const targets[] = {&reversed.rho, &reversed.rhoU, &reversed.rhoV, &reversed.rhoW, &reversed.rhoE,
+                                       &reversed.bx, &reversed.by, &reversed.bz};
+    for (std::size_t k = 0; k < fields.size(); ++k) {
+        *targets[k] = MHD::FieldView(fields[k].data(), fields[k].size());
+    }
+    mirrored.Load(reversed);
+
+    original.Run();
+    mirrored.Run();
+    EXPECT_EQ(original.CurrentStep(), mirrored.CurrentStep());
+    MHD::StateView const originalState = original.State();
+    MHD::StateView const mirroredState = mirrored.State();
+    std::size_t const numCells = originalState.numCells;
+    for (std::size_t i = 0; i < numCells; ++i) {
+        std::size_t const j = numCells - 1 - i;
+        EXPECT_NEAR(originalState.rho[i], mirroredState.rho[j], 1e-12 * originalState.rho[i]) << i;
+        EXPECT_NEAR(originalState.rhoU[i], -mirroredState.rhoU[j], 1e-12 * originalState.rhoE[i]) << i;
+        EXPECT_NEAR(originalState.rhoE[i], mirroredState.rhoE[j], 1e-12 * originalState.rhoE[i]) << i;
+    }
+}
+
+TEST(APITests, RunSodShockTubePeriodic) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_boundaryConditionOption = MHD::BoundaryConditionOption::PERIODIC;
+    profile.m_numGhostLayersOption = 2;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+
+    // The same tube rotated by a quarter of its length, which a periodic domain cannot tell apart
+    MHD::Calc shifted(profile);
+    MHD::StateView const initial = calc.State();
+    std::size_t const numCells = initial.numCells;
+    std::size_t const shift = numCells / 4;
+    std::vector<std::vector<double>> fields;
+    for (MHD::FieldView const* field : {&initial.rho, &initial.rhoU, &initial.rhoV, &initial.rhoW, &initial.rhoE,
+                                        &initial.bx, &initial.by, &initial.bz}) {
+        std::vector<double>& rotated = fields.emplace_back(numCells);
+        for (std::size_t i = 0; i < numCells; ++i) {
+            rotated[(i + shift) % numCells] = (*field)[i];
+        }
+    }
+    MHD::StateView rotatedState = initial;
+    MHD::FieldView* const targets[] = {&rotatedState.rho, &rotatedState.rhoU, &rotatedState.rhoV, &rotatedState.rhoW,
+                                       &rotatedState.rhoE, &rotatedState.bx, &rotatedState.by, &rotatedState.bz};
+    for (std::size_t k = 0; k < fields.size(); ++k) {
+        *targets[k] = MHD::FieldView(fields[k].data(), fields[k].size());
+    }
+    shifted.Load(rotatedState);
+    double const mass = std::accumulate(initial.rho.begin(), initial.rho.end(), 0.0);
+    double const energy = std::accumulate(initial.rhoE.begin(), initial.rhoE.end(), 0.0);
+
+    calc.Run();
+    shifted.Run();
+    MHD::StateView const state = calc.State();
+    MHD::StateView const shiftedState = shifted.State();
+
+    // Nothing leaves a periodic domain
+    EXPECT_NEAR(mass, std::accumulate(state.rho.begin(), state.rho.end(), 0.0), 1e-13 * mass);
+    EXPECT_NEAR(energy, std::accumulate(state.rhoE.begin(), state.rhoE.end(), 0.0), 1e-13 * energy);
+
+    // Every face sees the same cells in both, so the rotated solution is the solution rotated
+    EXPECT_EQ(calc.CurrentStep(), shifted.CurrentStep());
+    for (std::size_t i = 0; i < numCells; ++i) {
+        EXPECT_EQ(state.rho[i], shiftedState.rho[(i + shift) % numCells]) << i;
+        EXPECT_EQ(state.rhoU[i], shiftedState.rhoU[(i + shift) % numCells]) << i;
+        EXPECT_EQ(state.rhoE[i], shiftedState.rhoE[(i + shift) % numCells]) << i;
+    }
+}
+
+TEST(APITests, DiagnosticsConserveMassOnPeriodicDomain) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_boundaryConditionOption = MHD::BoundaryConditionOption::PERIODIC;
+    profile.m_numGhostLayersOption = 2;
+    profile.m_diagnosticsIntervalOption = 1;
+    profile.m_diagnosticIntegralsOption = {MHD::DiagnosticIntegralOption::MASS, MHD::DiagnosticIntegralOption::TOTAL_ENERGY};
+    profile.m_probeLocationsOption = {1.0, 19.0};
+    profile.m_sliceBoundsOption = {9.0, 11.0};
+    profile.m_sliceIntervalOption = 1000000;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    calc.Run();
+
+    MHD::TimeSeries const series = MHD::readTimeSeries("diagnostics.series");
+    ASSERT_EQ(2 + 2 + 2 * 8, series.columnNames.size());
+    ASSERT_GT(series.NumRows(), 1);
+
+    // Half the domain at density 1 and half at 0.125, with the middle cell on the left
+    std::vector<double> const mass = series.Column("mass");
+    EXPECT_NEAR(10.2 + 9.8 * 0.125, mass[0], 1e-12);
+    for (double const m : mass) {
+        EXPECT_NEAR(mass[0], m, 1e-12 * mass[0]);
+    }
+    EXPECT_EQ(1.0, series.Column("probe0.rho")[0]);
+    EXPECT_EQ(0.125, series.Column("probe1.rho")[0]);
+    EXPECT_EQ(0.0, series.Column("step")[0]);
+
+    MHD::Snapshot const slice = MHD::readSnapshot("slice_0_0.snap");
+    EXPECT_EQ(10, slice.info.numNodes);
+    EXPECT_DOUBLE_EQ(9.1, slice.Field("x")[0]);
+}
+
+TEST(APITests, ProbeOutsideDomainThrows) {
+    MHD::Profile profile;
+    profile.m_diagnosticsIntervalOption = 1;
+    profile.m_probeLocationsOption = {25.0};
+    EXPECT_THROW(MHD::Calc calc(profile), MHD::Error);
+}
+
+TEST(APITests, TimingReportCoversEveryStage) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+    profile.m_timingFileOption = "timings_test.json";
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    calc.Run();
+
+    std::ifstream file("timings_test.json");
+    std::string const json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    for (char const* name : {"\"Run\"", "\"PrimFromCons\"", "\"BoundaryConditions\"", "\"Reconstruction\"", "\"Flux\"",
+                             "\"Residual\"", "\"Integration\"", "\"MUSCLReconstruction\"", "\"KTFlux\"", "\"Transport\""}) {
+        EXPECT_NE(std::string::npos, json.find(name)) << name;
+    }
+}
+
+TEST(APITests, HardwareCountersDegradeGracefully) {
+    // Counters may be missing in containers and VMs, the run and its report must not depend on them
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_hardwareCountersOption = MHD::HardwareCountersOption::YES;
+    profile.m_peakBandwidthOption = 10.0;
+    profile.m_peakFlopRateOption = 50.0;
+    profile.m_timingFileOption = "counters_test.json";
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    EXPECT_NO_THROW(calc.Run());
+
+    std::ifstream file("counters_test.json");
+    std::string const json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(std::string::npos, json.find("\"hardwareCounters\": ["));
+    EXPECT_NE(std::string::npos, json.find("\"KTFlux\""));
+}
+
+TEST(APITests, TraceTimelineCoversKernelsAndWrites) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_outputDataOption = MHD::OutputDataOption::YES;
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+    profile.m_traceFileOption = "trace_test.json";
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    calc.Run();
+
+    std::ifstream file("trace_test.json");
+    std::string const json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(0, json.find("{\"displayTimeUnit\": \"ns\", \"traceEvents\": ["));
+    for (char const* name : {"\"main\"", "\"snapshot writer\"", "\"Run\"", "\"KTFlux\"", "\"StageSnapshot\"",
+                             "\"WriteSnapshot\"", "\"kernel\"", "\"stage\"", "\"io\""}) {
+        EXPECT_NE(std::string::npos, json.find(name)) << name;
+    }
+}
+
+TEST(APITests, ExactRiemannSolverMatchesSodStarState) {
+    // Star region of the classic Sod problem, Toro table 4.3 test 1
+    MHD::ExactRiemannSolver const exact({1.0, 0.0, 1.0}, {0.125, 0.0, 0.1}, 1.4);
+    EXPECT_NEAR(0.30313, exact.StarPressure(), 1e-5);
+    EXPECT_NEAR(0.92745, exact.StarVelocity(), 1e-5);
+
+    MHD::GasState const left = exact.Sample(-2.0);
+    EXPECT_EQ(1.0, left.rho);
+    MHD::GasState const contactLeft = exact.Sample(0.9);
+    EXPECT_NEAR(0.42632, contactLeft.rho, 1e-5);
+    MHD::GasState const contactRight = exact.Sample(1.0);
+    EXPECT_NEAR(0.26557, contactRight.rho, 1e-5);
+    MHD::GasState const right = exact.Sample(2.0);
+    EXPECT_EQ(0.125, right.rho);
+}
+
+TEST(APITests, SodConvergesToExactSolution) {
+    double previousError = 0.0;
+    for (double const spacing : {0.2, 0.1}) {
+        MHD::Profile profile;
+        profile.m_gridSpacingsOption = {spacing, 0.1, 0.1};
+        profile.m_numGhostLayersOption = 2;
+        profile.m_durationOption = 1e-2;
+        profile.m_timingReportOption = MHD::TimingReportOption::NO;
+        MHD::Calc calc(profile);
+        calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        calc.Run();
+        calc.WriteSnapshot("sod_exact_test.snap");
+
+        MHD::Snapshot const snapshot = MHD::readSnapshot("sod_exact_test.snap");
+        std::size_t const numCells = snapshot.info.numCells;
+        double const x0 = snapshot.Field("x")[numCells / 2] + 0.5 * spacing;
+        MHD::ExactRiemannSolver const exact({1.0, 0.0, 1e5}, {0.125, 0.0, 1e4}, 1.4);
+        double error = 0.0;
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const xOverT = (snapshot.Field("x")[i] - x0) / snapshot.info.time;
+            error += std::abs(snapshot.Field("rho")[i] - exact.Sample(xOverT).rho) / numCells;
+        }
+
+        EXPECT_LT(error, 0.02);
+        if (previousError > 0.0) {
+            EXPECT_LT(error, 0.6 * previousError);
+        }
+        previousError = error;
+    }
+}
+
+TEST(APITests, MixedPrecisionMatchesDoubleOnSod) {
+    // Float face states and fluxes round at about 1e-7, far below the truncation error of the scheme
+    std::vector<double> errors;
+    std::vector<std::vector<double>> densities;
+    for (MHD::PrecisionOption const precision : {MHD::PrecisionOption::DOUBLE, MHD::PrecisionOption::MIXED}) {
+        MHD::Profile profile;
+        profile.m_gridSpacingsOption = {0.1, 0.1, 0.1};
+        profile.m_numGhostLayersOption = 2;
+        profile.m_durationOption = 1e-2;
+        profile.m_precisionOption = precision;
+        profile.m_timingReportOption = MHD::TimingReportOption::NO;
+        MHD::Calc calc(profile);
+        calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        calc.Run();
+        calc.WriteSnapshot("sod_precision_test.snap");
+
+        MHD::Snapshot const snapshot = MHD::readSnapshot("sod_precision_test.snap");
+        std::size_t const numCells = snapshot.info.numCells;
+        double const x0 = snapshot.Field("x")[numCells / 2] + 0.05;
+        MHD::ExactRiemannSolver const exact({1.0, 0.0, 1e5}, {0.125, 0.0, 1e4}, 1.4);
+        double error = 0.0;
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const xOverT = (snapshot.Field("x")[i] - x0) / snapshot.info.time;
+            error += std::abs(snapshot.Field("rho")[i] - exact.Sample(xOverT).rho) / numCells;
+        }
+        errors.push_back(error);
+        densities.emplace_back(snapshot.Field("rho").begin(), snapshot.Field("rho").begin() + numCells);
+    }
+
+    double difference = 0.0;
+    for (std::size_t i = 0; i < densities[0].size(); ++i) {
+        difference += std::abs(densities[1][i] - densities[0][i]) / densities[0].size();
+    }
+    EXPECT_GT(difference, 0.0);
+    EXPECT_LT(difference, 1e-4 * errors[0]);
+    EXPECT_NEAR(errors[0], errors[1], 1e-4 * errors[0]);
+}
+
+TEST(APITests, RefinementMatchesFinerGridOnSod) {
+    // Two levels of patches on a coarse grid against uniform grids at its spacing and at the finest
+    auto sodError = [](double const spacing, std::size_t const levels) {
+        MHD::Profile profile;
+        profile.m_gridSpacingsOption = {spacing, 0.1, 0.1};
+        profile.m_numGhostLayersOption = 2;
+        profile.m_durationOption = 1e-2;
+        profile.m_refinementLevelsOption = levels;
+        profile.m_timingReportOption = MHD::TimingReportOption::NO;
+        MHD::Calc calc(profile);
+        calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        calc.Run();
+        calc.WriteSnapshot("sod_refinement_test.snap");
+
+        MHD::Snapshot const snapshot = MHD::readSnapshot("sod_refinement_test.snap");
+        std::size_t const numCells = snapshot.info.numCells;
+        double const x0 = snapshot.Field("x")[numCells / 2] + 0.5 * spacing;
+        MHD::ExactRiemannSolver const exact({1.0, 0.0, 1e5}, {0.125, 0.0, 1e4}, 1.4);
+        double error = 0.0;
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const xOverT = (snapshot.Field("x")[i] - x0) / snapshot.info.time;
+            error += std::abs(snapshot.Field("rho")[i] - exact.Sample(xOverT).rho) * spacing;
+        }
+        return error;
+    };
+
+    // The refined run is read on the coarse grid, where its patches were averaged
+    double const coarse = sodError(0.1, 0);
+    double const refined = sodError(0.1, 2);
+    double const fine = sodError(0.025, 0);
+    EXPECT_LT(refined, 0.5 * coarse);
+    EXPECT_LT(refined, 1.1 * fine);
+}
+
+TEST(APITests, ClusteredGridMatchesFinerGridOnSod) {
+    // Cells narrowed fourfold about the diaphragm against uniform grids of as many cells and at the finest spacing
+    auto sodError = [](MHD::Profile profile, std::size_t& numCells) {
+        profile.m_numGhostLayersOption = 2;
+        profile.m_durationOption = 1e-2;
+        profile.m_timingReportOption = MHD::TimingReportOption::NO;
+        MHD::Calc calc(profile);
+        calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        calc.Run();
+        calc.WriteSnapshot("sod_stretching_test.snap");
+
+        auto const grid = MHD::gridFactory(profile);
+        MHD::Snapshot const snapshot = MHD::readSnapshot("sod_stretching_test.snap");
+        numCells = snapshot.info.numCells;
+        double const x0 = grid->Nodes()[numCells / 2][0] + 0.5 * grid->CellWidths()[numCells / 2];
+        MHD::ExactRiemannSolver const exact({1.0, 0.0, 1e5}, {0.125, 0.0, 1e4}, 1.4);
+        double error = 0.0;
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const xOverT = (snapshot.Field("x")[i] - x0) / snapshot.info.time;
+            error += std::abs(snapshot.Field("rho")[i] - exact.Sample(xOverT).rho) * grid->CellWidths()[i];
+        }
+        return error;
+    };
+
+    MHD::Profile clusteredProfile;
+    clusteredProfile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    clusteredProfile.m_gridClusterPointsOption = {10.0};
+    clusteredProfile.m_gridClusterRatioOption = 4.0;
+    clusteredProfile.m_gridClusterWidthOption = 5.0;
+    std::size_t clusteredCells = 0;
+    double const clustered = sodError(clusteredProfile, clusteredCells);
+
+    MHD::Profile evenProfile;
+    evenProfile.m_gridSpacingsOption = {20.0 / clusteredCells, 0.1, 0.1};
+    std::size_t evenCells = 0;
+    double const even = sodError(evenProfile, evenCells);
+
+    MHD::Profile fineProfile;
+    fineProfile.m_gridSpacingsOption = {0.05, 0.1, 0.1};
+    std::size_t fineCells = 0;
+    double const fine = sodError(fineProfile, fineCells);
+
+    EXPECT_LT(clusteredCells, 0.6 * fineCells);
+    EXPECT_LT(clustered, 0.7 * even);
+    EXPECT_LT(clustered, 1.2 * fine);
+}
+
+TEST(APITests, SteppingMatchesRun) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_durationOption = 1e-2;
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+
+    MHD::Calc whole(profile);
+    whole.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    whole.Run();
+    whole.WriteCheckpoint("run_whole.ckpt");
+
+    // The same steps taken in pieces reach the same state bit for bit
+    MHD::Calc stepped(profile);
+    stepped.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    stepped.Step(10);
+    EXPECT_EQ(10, stepped.CurrentStep());
+    while (stepped.CurrentStep() < whole.CurrentStep()) {
+        stepped.Step();
+    }
+    stepped.WriteCheckpoint("run_stepped.ckpt");
+
+    MHD::MappedCheckpoint const a("run_whole.ckpt");
+    MHD::MappedCheckpoint const b("run_stepped.ckpt");
+    EXPECT_EQ(a.Info().time, b.Info().time);
+    for (std::size_t i = 0; i < a.Info().numNodes; ++i) {
+        ASSERT_EQ(a.Field("rhoE")[i], b.Field("rhoE")[i]) << i;
+    }
+
+    // RunUntil lands on the requested time exactly, where Run overshoots by part of a step
+    MHD::Calc until(profile);
+    until.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    until.RunUntil(2.5e-3);
+    EXPECT_EQ(2.5e-3, until.CurrentTime());
+    until.RunUntil(5e-3);
+    EXPECT_EQ(5e-3, until.CurrentTime());
+    until.RunUntil(1e-3);
+    EXPECT_EQ(5e-3, until.CurrentTime());
+}
+
+TEST(APITests, ObserversSeeLiveStateAtTheirCadence) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+
+    std::vector<std::size_t> steps;
+    double const* rhoData = nullptr;
+    double totalMass = 0.0;
+    calc.AddObserver([&](MHD::StateView const& state) {
+        steps.push_back(state.step);
+        rhoData = state.rho.Data();
+        totalMass = 0.0;
+        for (double const rho : state.rho) {
+            totalMass += rho;
+        }
+        EXPECT_EQ(100, state.rho.Size());
+        EXPECT_DOUBLE_EQ(0.1, state.x[0]);
+    }, 5);
+
+    std::vector<double> times;
+    std::size_t const timeObserver = calc.AddTimeObserver([&](MHD::StateView const& state) {
+        times.push_back(state.time);
+    }, 1e-3);
+
+    calc.RunUntil(4.5e-3);
+    ASSERT_FALSE(steps.empty());
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        EXPECT_EQ(5 * i, steps[i]);
+    }
+    EXPECT_EQ(5, times.size());
+    for (std::size_t i = 1; i < times.size(); ++i) {
+        EXPECT_GE(times[i], 1e-3 * i);
+        EXPECT_LT(times[i - 1], 1e-3 * i);
+    }
+
+    // The view points into the solver's arrays rather than a copy of them
+    MHD::StateView const state = calc.State();
+    EXPECT_EQ(rhoData, state.rho.Data());
+    EXPECT_NEAR(51 * 1.0 + 49 * 0.125, totalMass, 1e-9);
+    EXPECT_GT(state.p[0], 0.0);
+
+    calc.RemoveObserver(timeObserver);
+    calc.Step(20);
+    EXPECT_EQ(5, times.size());
+    EXPECT_THROW(calc.RemoveObserver(timeObserver), MHD::Error);
+    EXPECT_THROW(calc.AddObserver([](MHD::StateView const&) {}, 0), MHD::Error);
+}
+
+TEST(APITests, ObserversMayAddAndRemoveObserversFromTheirCallbacks) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+
+    // One observer removes itself, a second removes a third before its turn, and a fourth adds one
+    std::vector<std::size_t> selfSteps, laterSteps, addedSteps;
+    std::size_t selfId = 0, laterId = 0;
+    bool added = false;
+    selfId = calc.AddObserver([&](MHD::StateView const& state) {
+        selfSteps.push_back(state.step);
+        if (state.step == 2) {
+            calc.RemoveObserver(selfId);
+        }
+    });
+    calc.AddObserver([&](MHD::StateView const& state) {
+        if (state.step == 3) {
+            calc.RemoveObserver(laterId);
+        }
+    });
+    laterId = calc.AddObserver([&](MHD::StateView const& state) { laterSteps.push_back(state.step); });
+    calc.AddObserver([&](MHD::StateView const& state) {
+        if (!added && state.step == 1) {
+            added = true;
+            calc.AddObserver([&](MHD::StateView const& inner) { addedSteps.push_back(inner.step); });
+        }
+    });
+
+    calc.Step(5);
+    EXPECT_EQ((std::vector<std::size_t>{0, 1, 2}), selfSteps);
+    EXPECT_EQ((std::vector<std::size_t>{0, 1, 2}), laterSteps);
+    EXPECT_EQ((std::vector<std::size_t>{2, 3, 4}), addedSteps);
+    EXPECT_THROW(calc.RemoveObserver(selfId), MHD::Error);
+    EXPECT_THROW(calc.RemoveObserver(laterId), MHD::Error);
+}
+
+TEST(APITests, EnsembleMembersMatchStandaloneRuns) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_durationOption = 1e-2;
+    profile.m_diagnosticsIntervalOption = 10;
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+
+    MHD::Profile constantProfile = profile;
+    constantProfile.m_reconstructionOption = MHD::ReconstructionOption::CONSTANT;
+
+    MHD::Ensemble ensemble(profile, 2);
+    EXPECT_EQ(2, ensemble.NumThreads());
+    std::vector<double> finalMass(3, 0.0);
+    auto captureMass = [&finalMass](std::size_t const m) {
+        return [&finalMass, m](MHD::Calc& calc) {
+            calc.AddObserver([&finalMass, m](MHD::StateView const& state) {
+                finalMass[m] = 0.0;
+                for (double const rho : state.rho) {
+                    finalMass[m] += rho;
+                }
+            });
+        };
+    };
+    ensemble.AddMember(InitialCondition::SOD_SHOCK_TUBE, captureMass(0));
+    ensemble.AddMember(InitialCondition::BRIO_WU_SHOCK_TUBE, captureMass(1));
+    ensemble.AddMember(constantProfile, InitialCondition::SOD_SHOCK_TUBE, captureMass(2));
+
+    MHD::Profile fineProfile = profile;
+    fineProfile.m_gridSpacingsOption = {0.1, 0.1, 0.1};
+    EXPECT_THROW(ensemble.AddMember(fineProfile, InitialCondition::SOD_SHOCK_TUBE), MHD::Error);
+
+    std::vector<MHD::EnsembleResult> const results = ensemble.Run();
+    ASSERT_EQ(3, results.size());
+    std::vector<MHD::Profile> const profiles = {profile, profile, constantProfile};
+    std::vector<InitialCondition> const conditions = {InitialCondition::SOD_SHOCK_TUBE,
+                                                      InitialCondition::BRIO_WU_SHOCK_TUBE,
+                                                      InitialCondition::SOD_SHOCK_TUBE};
+    for (std::size_t m = 0; m < results.size(); ++m) {
+        EXPECT_EQ(MHD::Error::SUCCESS, results[m].status);
+        EXPECT_EQ("member_" + std::to_string(m) + "_", results[m].outputPrefix);
+        EXPECT_TRUE(std::ifstream(results[m].outputPrefix + "diagnostics.series").good());
+
+        // Sharing the grid and the pool changes nothing about the result
+        MHD::Calc standalone(profiles[m]);
+        standalone.SetInitialCondition(conditions[m]);
+        standalone.Run();
+        EXPECT_EQ(standalone.CurrentStep(), results[m].steps);
+        EXPECT_EQ(standalone.CurrentTime(), results[m].time);
+        EXPECT_GT(finalMass[m], 0.0);
+    }
+    EXPECT_NE(results[0].steps, results[1].steps);
+}
+
+TEST(APITests, BatchedEnsembleAdvancesMembersInLockStep) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_durationOption = 1e-2;
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+
+    MHD::Calc standalone(profile);
+    standalone.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    standalone.Run();
+    MHD::StateView const expected = standalone.State();
+
+    // Sod's stable step is the smaller one here, as its lone run takes more steps than Brio-Wu's
+    MHD::Calc brioWu(profile);
+    brioWu.SetInitialCondition(InitialCondition::BRIO_WU_SHOCK_TUBE);
+    brioWu.Run();
+    ASSERT_LT(brioWu.CurrentStep(), standalone.CurrentStep());
+
+    // A batch steps at the smallest stable step of its lanes, Sod's, so its Sod lanes reproduce the lone run exactly
+    MHD::Ensemble ensemble(profile, 1, 4);
+    std::vector<std::vector<double>> finalRhoE(5);
+    auto keepRhoE = [&finalRhoE](std::size_t const m) {
+        return [&finalRhoE, m](MHD::Calc& calc) {
+            MHD::StateView const state = calc.State();
+            finalRhoE[m].assign(state.rhoE.begin(), state.rhoE.end());
+        };
+    };
+    for (std::size_t m = 0; m < 3; ++m) {
+        ensemble.AddMember(InitialCondition::SOD_SHOCK_TUBE, {}, keepRhoE(m));
+    }
+    ensemble.AddMember(InitialCondition::BRIO_WU_SHOCK_TUBE, {}, keepRhoE(3));
+
+    // A different scheme cannot share the batch and runs after it on its own
+    MHD::Profile constantProfile = profile;
+    constantProfile.m_reconstructionOption = MHD::ReconstructionOption::CONSTANT;
+    ensemble.AddMember(constantProfile, InitialCondition::SOD_SHOCK_TUBE, {}, keepRhoE(4));
+
+    std::vector<MHD::EnsembleResult> const results = ensemble.Run();
+    ASSERT_EQ(5, results.size());
+    for (std::size_t m = 0; m < 3; ++m) {
+        EXPECT_EQ(MHD::Error::SUCCESS, results[m].status);
+        EXPECT_EQ(standalone.CurrentStep(), results[m].steps);
+        EXPECT_EQ(standalone.CurrentTime(), results[m].time);
+        ASSERT_EQ(expected.rhoE.Size(), finalRhoE[m].size());
+        for (std::size_t i = 0; i < finalRhoE[m].size(); ++i) {
+            ASSERT_EQ(expected.rhoE[i], finalRhoE[m][i]) << "member " << m << ", cell " << i;
+        }
+    }
+
+    // Brio-Wu shares the batch, so it takes Sod's smaller steps rather than its own
+    EXPECT_EQ(MHD::Error::SUCCESS, results[3].status);
+    EXPECT_EQ(standalone.CurrentStep(), results[3].steps);
+    EXPECT_EQ(standalone.CurrentTime(), results[3].time);
+    EXPECT_GT(results[3].steps, brioWu.CurrentStep());
+    EXPECT_FALSE(finalRhoE[3].empty());
+
+    MHD::Calc constant(constantProfile);
+    constant.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    constant.Run();
+    EXPECT_EQ(constant.CurrentStep(), results[4].steps);
+}
+
+TEST(APITests, UnpairedPeriodicBoundaryThrows) {
+    MHD::Profile profile;
+    profile.m_boundaryConditionsOption = {MHD::BoundaryConditionOption::PERIODIC, MHD::BoundaryConditionOption::OUTFLOW};
+    EXPECT_THROW(MHD::Calc calc(profile), MHD::Error);
+}
+
+TEST(APITests, PeriodicBoundaryNeedsGhostLayersForTheStencil) {
+    MHD::Profile profile;
+    profile.m_boundaryConditionOption = MHD::BoundaryConditionOption::PERIODIC;
+    EXPECT_THROW(MHD::Calc calc(profile), MHD::Error);
+
+    // Constant states read one cell either side of a face, so one layer is enough for them
+    profile.m_reconstructionOption = MHD::ReconstructionOption::CONSTANT;
+    EXPECT_NO_THROW(MHD::Calc calc(profile));
+}
+
+TEST(APITests, BinarySnapshotRoundTrip) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_outputDataOption = MHD::OutputDataOption::YES;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    calc.Run();
+
+    MHD::Snapshot const snapshot = MHD::readSnapshot("results_0.snap");
+    EXPECT_EQ(0, snapshot.info.step);
+    EXPECT_EQ(100, snapshot.info.numCells);
+    EXPECT_EQ(102, snapshot.info.numNodes);
+    ASSERT_EQ(12, snapshot.fieldNames.size());
+    EXPECT_EQ(1.0, snapshot.Field("rho")[0]);
+    EXPECT_EQ(0.125, snapshot.Field("rho")[99]);
+    EXPECT_DOUBLE_EQ(0.1, snapshot.Field("x")[0]);
+}
+
+TEST(APITests, RestartFromCheckpointReproducesRun) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_checkpointIntervalOption = 50;
+    profile.m_checkpointFileOption = "restart_test.ckpt";
+
+    MHD::Calc original(profile);
+    original.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    original.Run();
+    original.WriteCheckpoint("original_final.ckpt");
+
+    MHD::Calc restarted(profile);
+    restarted.Restart("restart_test.ckpt");
+    restarted.Run();
+    restarted.WriteCheckpoint("restarted_final.ckpt");
+
+    MHD::MappedCheckpoint const a("original_final.ckpt");
+    MHD::MappedCheckpoint const b("restarted_final.ckpt");
+    EXPECT_EQ(a.Info().step, b.Info().step);
+    EXPECT_EQ(a.Info().time, b.Info().time);
+    for (std::string const& name : a.FieldNames()) {
+        for (std::size_t i = 0; i < a.Info().numNodes; ++i) {
+            ASSERT_EQ(a.Field(name)[i], b.Field(name)[i]) << name << "[" << i << "]";
+        }
+    }
+}
+
+TEST(APITests, RestartRejectsMismatchedGrid) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+    calc.WriteCheckpoint("coarse.ckpt");
+
+    MHD::Profile fineProfile;
+    fineProfile.m_gridSpacingsOption = {0.1, 0.1, 0.1};
+    MHD::Calc fine(fineProfile);
+    EXPECT_THROW(fine.Restart("coarse.ckpt"), MHD::Error);
+}
+
+TEST(APITests, RestartFromCompressedCheckpoint) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_outputCompressionOption = MHD::CompressionOption::XOR_BITPLANE;
+    MHD::Calc calc(profile);
+    calc.SetInitialCondition(InitialCondition::BRIO_WU_SHOCK_TUBE);
+    calc.WriteCheckpoint("compressed.ckpt");
+
+    MHD::Calc restarted(profile);
+    restarted.Restart("compressed.ckpt");
+    restarted.WriteCheckpoint("compressed_again.ckpt");
+
+    MHD::MappedCheckpoint const a("compressed.ckpt");
+    MHD::MappedCheckpoint const b("compressed_again.ckpt");
+    EXPECT_EQ(MHD::CompressionOption::XOR_BITPLANE, a.Info().compression);
+    for (std::string const& name : a.FieldNames()) {
+        for (std::size_t i = 0; i < a.Info().numNodes; ++i) {
+            ASSERT_EQ(a.Field(name)[i], b.Field(name)[i]) << name << "[" << i << "]";
+        }
+    }
+}
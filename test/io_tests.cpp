@@ -0,0 +1,128 @@
+#include <async_writer.hpp>
+#include <compression.hpp>
+#include <error.hpp>
+#include <snapshot.hpp>
+#include <time_series.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool bitwiseEqual(double const a, double const b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+} // namespace
+
+TEST(IOTests, AsyncSnapshotWriterAppliesBackPressure) {
+    std::vector<double> data(64);
+    MHD::SnapshotInfo info;
+    info.numCells = data.size();
+    info.numNodes = data.size();
+
+    // A single staging buffer forces every submit after the first to wait on the writer
+    MHD::AsyncSnapshotWriter writer(1);
+    for (std::size_t s = 0; s < 4; ++s) {
+        data.assign(data.size(), static_cast<double>(s));
+        info.step = s;
+        writer.Submit("async_" + std::to_string(s) + ".snap", info, {{"f", data.data()}});
+    }
+    writer.Flush();
+
+    EXPECT_EQ(0, writer.NumFailedWrites());
+    for (std::size_t s = 0; s < 4; ++s) {
+        MHD::Snapshot const snapshot = MHD::readSnapshot("async_" + std::to_string(s) + ".snap");
+        EXPECT_EQ(s, snapshot.info.step);
+        EXPECT_EQ(static_cast<double>(s), snapshot.Field("f")[63]);
+    }
+}
+
+TEST(IOTests, CompressionRoundTripIsLossless) {
+    // A smooth field with a partial trailing block and a few values no predictor likes
+    std::size_t const n = 3 * MHD::COMPRESSION_BLOCK_SIZE + 77;
+    std::vector<double> values(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        values[i] = 1.0 + 0.125 * std::tanh((static_cast<double>(i) - n / 2.0) / 40.0);
+    }
+    values[5] = std::numeric_limits<double>::quiet_NaN();
+    values[6] = -std::numeric_limits<double>::infinity();
+    values[7] = -0.0;
+    values[8] = std::numeric_limits<double>::denorm_min();
+
+    std::vector<std::uint64_t> words;
+    MHD::compressField(values.data(), n, words);
+    EXPECT_TRUE(MHD::isValidCompressedField(words.data(), words.size(), n));
+    EXPECT_LT(words.size() * sizeof(std::uint64_t), n * sizeof(double));
+
+    std::vector<double> decoded(n);
+    MHD::decompressField(words.data(), n, decoded.data());
+    for (std::size_t i = 0; i < n; ++i) {
+        ASSERT_TRUE(bitwiseEqual(values[i], decoded[i])) << i;
+    }
+
+    // Any block decodes on its own
+    std::vector<double> block(MHD::COMPRESSION_BLOCK_SIZE);
+    MHD::decompressBlock(words.data(), n, 3, block.data());
+    for (std::size_t i = 0; i < 77; ++i) {
+        ASSERT_TRUE(bitwiseEqual(values[3 * MHD::COMPRESSION_BLOCK_SIZE + i], block[i])) << i;
+    }
+}
+
+TEST(IOTests, ConstantFieldCompressesToMasks) {
+    std::vector<double> values(2 * MHD::COMPRESSION_BLOCK_SIZE, 0.125);
+    std::vector<std::uint64_t> words;
+    MHD::compressField(values.data(), values.size(), words);
+
+    // Block table, then per block the first value and an empty plane mask per group
+    EXPECT_EQ(3 + 2 * (1 + MHD::COMPRESSION_BLOCK_SIZE / 64), words.size());
+}
+
+TEST(IOTests, CompressedSnapshotRoundTrip) {
+    std::size_t const n = 5000;
+    std::vector<double> rho(n);
+    std::vector<double> p(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        rho[i] = i < n / 2 ? 1.0 : 0.125;
+        p[i] = 1e5 * std::exp(-1e-4 * i);
+    }
+
+    MHD::SnapshotInfo info;
+    info.step = 42;
+    info.numCells = n - 2;
+    info.numNodes = n;
+    info.compression = MHD::CompressionOption::XOR_BITPLANE;
+    MHD::writeSnapshot("compressed.snap", info, {{"rho", rho.data()}, {"p", p.data()}});
+
+    MHD::Snapshot const snapshot = MHD::readSnapshot("compressed.snap");
+    EXPECT_EQ(42, snapshot.info.step);
+    EXPECT_EQ(MHD::CompressionOption::XOR_BITPLANE, snapshot.info.compression);
+    EXPECT_EQ(rho, snapshot.Field("rho"));
+    EXPECT_EQ(p, snapshot.Field("p"));
+}
+
+TEST(IOTests, TimeSeriesRoundTripAcrossBatches) {
+    {
+        // Three rows per write, so the last row is only written by the destructor
+        MHD::TimeSeriesWriter writer("series_test.series", {"time", "mass"}, 3);
+        for (int r = 0; r < 7; ++r) {
+            double const row[] = {0.1 * r, 1.0 + r};
+            writer.Append(row);
+        }
+    }
+
+    MHD::TimeSeries const series = MHD::readTimeSeries("series_test.series");
+    ASSERT_EQ(2, series.columnNames.size());
+    EXPECT_EQ("mass", series.columnNames[1]);
+    ASSERT_EQ(7, series.NumRows());
+    std::vector<double> const mass = series.Column("mass");
+    for (int r = 0; r < 7; ++r) {
+        EXPECT_EQ(1.0 + r, mass[r]);
+    }
+    EXPECT_THROW(series.Column("energy"), MHD::Error);
+}
@@ -0,0 +1,197 @@
+#include <calc.hpp>
+#include <communicator.hpp>
+#include <error.hpp>
+#include <grid.hpp>
+#include <profile.hpp>
+#include <profile_options.hpp>
+#include <snapshot.hpp>
+#include <time_series.hpp>
+
+#include "gtest/gtest.h"
+
+#include <mpi.h>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace MHD;
+
+namespace {
+
+MHD::Profile decomposedProfile(MHD::BoundaryConditionOption const boundaryCondition) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_numGhostLayersOption = 2;
+    profile.m_boundaryConditionOption = boundaryCondition;
+    profile.m_timingReportOption = MHD::TimingReportOption::NO;
+    return profile;
+}
+
+} // namespace
+
+TEST(MPITests, DecomposedRunsMatchSerialRunBitwise) {
+    std::shared_ptr<MHD::ICommunicator> const communicator = MHD::worldCommunicator();
+    ASSERT_GT(communicator->Size(), 1);
+
+    for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                 MHD::BoundaryConditionOption::PERIODIC}) {
+        // Staged steps, and task graph steps whose halo tasks stay on the calling thread
+        for (std::size_t const numThreads : {1, 2}) {
+            MHD::Profile profile = decomposedProfile(boundaryCondition);
+            profile.m_numThreadsOption = numThreads;
+            profile.m_tileCellsOption = 8;
+            MHD::Calc decomposed(profile, communicator);
+            decomposed.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+            decomposed.Run();
+
+            // Every rank runs the whole domain alone for comparison
+            MHD::Calc serial(profile, MHD::gridFactory(profile));
+            serial.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+            serial.Run();
+
+            std::size_t const first = MHD::gridFactory(profile, communicator->Rank(), communicator->Size())->FirstCell();
+            MHD::StateView const part = decomposed.State();
+            MHD::StateView const whole = serial.State();
+            EXPECT_EQ(whole.time, part.time);
+            EXPECT_EQ(whole.step, part.step);
+            ASSERT_LE(first + part.numCells, whole.numCells);
+            for (std::size_t i = 0; i < part.numCells; ++i) {
+                ASSERT_EQ(whole.x[first + i], part.x[i]);
+                ASSERT_EQ(whole.rho[first + i], part.rho[i]) << "cell " << first + i;
+                ASSERT_EQ(whole.rhoU[first + i], part.rhoU[i]) << "cell " << first + i;
+                ASSERT_EQ(whole.rhoE[first + i], part.rhoE[i]) << "cell " << first + i;
+            }
+        }
+    }
+}
+
+TEST(MPITests, HaloNeedsGhostLayersForTheStencil) {
+    std::shared_ptr<MHD::ICommunicator> const communicator = MHD::worldCommunicator();
+    MHD::Profile profile = decomposedProfile(MHD::BoundaryConditionOption::REFLECTIVE);
+    profile.m_numGhostLayersOption = 1;
+    EXPECT_THROW(MHD::Calc calc(profile, communicator), MHD::Error);
+
+    // Constant states read one cell either side of a face, so one layer is enough for them
+    profile.m_reconstructionOption = MHD::ReconstructionOption::CONSTANT;
+    EXPECT_NO_THROW(MHD::Calc calc(profile, communicator));
+}
+
+TEST(MPITests, HaloMessagesOverlapInteriorFaces) {
+    std::shared_ptr<MHD::ICommunicator> const communicator = MHD::worldCommunicator();
+    MHD::Profile profile = decomposedProfile(MHD::BoundaryConditionOption::OUTFLOW);
+    profile.m_timingFileOption = "timings_mpi.json";
+    {
+        MHD::Calc calc(profile, communicator);
+        calc.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        calc.Run();
+    }
+
+    // Posting and completing the exchange are timed apart, with the interior faces in between
+    std::ifstream file("rank_" + std::to_string(communicator->Rank()) + "_timings_mpi.json");
+    std::string const json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    for (char const* name : {"\"HaloExchange\"", "\"HaloWait\"", "\"HaloPack\"", "\"HaloUnpack\""}) {
+        EXPECT_NE(std::string::npos, json.find(name)) << name;
+    }
+}
+
+TEST(MPITests, OverlappedHaloStepsMatchWaitingOnesBitwise) {
+    std::shared_ptr<MHD::ICommunicator> const communicator = MHD::worldCommunicator();
+
+    // Staged steps split into interior and halo faces, the same with quiescent tiles skipped, and task graph steps
+    for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                 MHD::BoundaryConditionOption::PERIODIC}) {
+        for (std::size_t const numThreads : {1, 2}) {
+            for (MHD::ActivityTrackingOption const activityTracking : {MHD::ActivityTrackingOption::NO,
+                                                                       MHD::ActivityTrackingOption::YES}) {
+                if (numThreads > 1 && MHD::ActivityTrackingOption::YES == activityTracking) {
+                    continue;
+                }
+                MHD::Profile profile = decomposedProfile(boundaryCondition);
+                profile.m_numThreadsOption = numThreads;
+                profile.m_tileCellsOption = 8;
+                profile.m_activityTrackingOption = activityTracking;
+                MHD::Calc overlapped(profile, communicator);
+                overlapped.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+                overlapped.Run();
+
+                profile.m_haloOverlapOption = MHD::HaloOverlapOption::NO;
+                MHD::Calc waiting(profile, communicator);
+                waiting.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+                waiting.Run();
+
+                MHD::StateView const expected = waiting.State();
+                MHD::StateView const actual = overlapped.State();
+                EXPECT_EQ(expected.time, actual.time);
+                EXPECT_EQ(expected.step, actual.step);
+                ASSERT_EQ(expected.numCells, actual.numCells);
+                for (std::size_t i = 0; i < actual.numCells; ++i) {
+                    ASSERT_EQ(expected.rho[i], actual.rho[i]) << "cell " << i << ", threads " << numThreads;
+                    ASSERT_EQ(expected.rhoU[i], actual.rhoU[i]) << "cell " << i << ", threads " << numThreads;
+                    ASSERT_EQ(expected.rhoE[i], actual.rhoE[i]) << "cell " << i << ", threads " << numThreads;
+                }
+            }
+        }
+    }
+}
+
+TEST(MPITests, DiagnosticsCoverTheWholeDomain) {
+    std::shared_ptr<MHD::ICommunicator> const communicator = MHD::worldCommunicator();
+    std::string const rank = std::to_string(communicator->Rank());
+
+    // The middle probe sits on the first boundary between ranks
+    MHD::Profile profile = decomposedProfile(MHD::BoundaryConditionOption::PERIODIC);
+    profile.m_diagnosticsIntervalOption = 10;
+    profile.m_diagnosticIntegralsOption = {MHD::DiagnosticIntegralOption::MASS};
+    profile.m_probeLocationsOption = {1.0, 6.6, 19.0};
+    profile.m_sliceBoundsOption = {6.0, 7.0};
+    profile.m_sliceIntervalOption = 1000000;
+    {
+        MHD::Calc decomposed(profile, communicator);
+        decomposed.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        decomposed.Run();
+    }
+
+    MHD::Profile serialProfile = profile;
+    serialProfile.m_outputPrefixOption = "serial_" + rank + "_";
+    {
+        MHD::Calc serial(serialProfile, MHD::gridFactory(serialProfile));
+        serial.SetInitialCondition(InitialCondition::SOD_SHOCK_TUBE);
+        serial.Run();
+    }
+
+    MHD::TimeSeries const part = MHD::readTimeSeries("rank_" + rank + "_diagnostics.series");
+    MHD::TimeSeries const whole = MHD::readTimeSeries("serial_" + rank + "_diagnostics.series");
+    ASSERT_EQ(whole.columnNames, part.columnNames);
+    ASSERT_EQ(whole.NumRows(), part.NumRows());
+
+    // Summing over ranks reorders the integral, while probes are read from a single cell
+    std::vector<double> const partMass = part.Column("mass");
+    std::vector<double> const wholeMass = whole.Column("mass");
+    for (std::size_t r = 0; r < whole.NumRows(); ++r) {
+        EXPECT_NEAR(wholeMass[r], partMass[r], 1e-12 * wholeMass[r]);
+    }
+    for (std::string const& name : whole.columnNames) {
+        if (name.rfind("probe", 0) == 0) {
+            EXPECT_EQ(whole.Column(name), part.Column(name)) << name;
+        }
+    }
+
+    // The slice straddles the first two ranks, and each writes its own share
+    std::string const sliceFile = "rank_" + rank + "_slice_0_0.snap";
+    if (communicator->Rank() < 2) {
+        EXPECT_EQ(communicator->Rank() == 0 ? 3 : 2, MHD::readSnapshot(sliceFile).info.numNodes);
+    } else {
+        EXPECT_FALSE(std::ifstream(sliceFile).good());
+    }
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    testing::InitGoogleTest(&argc, argv);
+    int const result = RUN_ALL_TESTS();
+    MPI_Finalize();
+    return result;
+}
@@ -1,15 +1,780 @@
+#include <allocation_tracker.hpp>
+#include <error.hpp>
+#include <execution_controller.hpp>
+#include <grid.hpp>
 #include <profile.hpp>
 #include <profile_options.hpp>
 #include <solver.hpp>
-#include <cartesian/1d.hpp>
+#include <task_graph.hpp>
+#include <topology.hpp>
+#include <variable_store.hpp>
 
 #include "gtest/gtest.h"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
 
-TEST(SolverTests, SpatialDerivative) {
+namespace {
+
+// Smooth state on every interior cell, so every reconstruction stays physical
+void setSmoothState(MHD::IGrid const& grid, MHD::VariableStore& varStore) {
+    double const length = grid.NumCells() * grid.CellSize()[0];
+    for (std::size_t i = 0; i < grid.NumCells(); ++i) {
+        double const phase = 2.0 * M_PI * grid.Nodes()[i][0] / length;
+        varStore.rho[i] = 1.0 + 0.1 * std::sin(phase);
+        varStore.rhoU[i] = 0.1 * std::cos(phase);
+        varStore.bx[i] = 0.75;
+        varStore.by[i] = std::cos(phase);
+        varStore.rhoE[i] = 2.5e5 + 0.1 * std::cos(phase);
+    }
+}
+
+// Uniform state but for a bump a few cells wide in the middle, which the rest of the grid waits for
+void setPulseState(MHD::IGrid const& grid, MHD::VariableStore& varStore) {
+    std::size_t const numCells = grid.NumCells();
+    for (std::size_t i = 0; i < numCells; ++i) {
+        double const distance = std::abs(static_cast<double>(i) - 0.5 * numCells);
+        double const bump = distance < 8.0 ? 0.5 * (1.0 + std::cos(M_PI * distance / 8.0)) : 0.0;
+        varStore.rho[i] = 1.0 + 0.1 * bump;
+        varStore.rhoU[i] = 0.0;
+        varStore.bx[i] = 0.75;
+        varStore.by[i] = 1.0;
+        varStore.rhoE[i] = 2.5e5 * (1.0 + 0.1 * bump);
+    }
+}
+
+} // namespace
+
+TEST(SolverTests, AllocationCountsAttributeToThread) {
+    MHD::AllocationCounts const before = MHD::threadAllocationCounts();
+    auto const values = std::make_unique<double[]>(16);
+    MHD::AllocationCounts const after = MHD::threadAllocationCounts();
+    EXPECT_NE(nullptr, values);
+    EXPECT_EQ(1, after.numAllocations - before.numAllocations);
+    EXPECT_EQ(16 * sizeof(double), after.numBytes - before.numBytes);
+    EXPECT_GT(MHD::peakResidentBytes(), 0);
+}
+
+// Sums a few thousand square roots per item, enough work for a worker's own counters to notice
+struct SpinKernel {
+    void operator()(std::size_t const i) {
+        for (std::size_t k = 1; k <= 4096; ++k) {
+            sum += std::sqrt(static_cast<double>(i + k));
+        }
+    }
+
+    double sum = 0.0;
+};
+
+TEST(SolverTests, KernelStatisticsMergeAcrossLaunchingThreads) {
+    MHD::ExecutionController execCtrl;
+    bool const counters = execCtrl.EnableHardwareCounters();
+
+    // Only worker threads launch, while the thread that enabled the counters waits
+    std::size_t constexpr numThreads = 4;
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&execCtrl, t] {
+            SpinKernel kernel;
+            for (std::size_t launch = 0; launch <= t; ++launch) {
+                execCtrl.LaunchKernel(kernel, 64);
+            }
+            EXPECT_GT(kernel.sum, 0.0);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<MHD::KernelStats> const stats = execCtrl.KernelStatistics();
+    ASSERT_EQ(1, stats.size());
+    EXPECT_EQ(numThreads * (numThreads + 1) / 2, stats[0].numLaunches);
+    EXPECT_EQ(64 * stats[0].numLaunches, stats[0].numItems);
+    if (counters && execCtrl.HardwareCounterAvailable(MHD::HardwareCounter::INSTRUCTIONS)) {
+        std::size_t const instructions = stats[0].counters[static_cast<std::size_t>(MHD::HardwareCounter::INSTRUCTIONS)];
+        EXPECT_GT(instructions, stats[0].numItems * 4096);
+    }
+
+    execCtrl.ResetStatistics();
+    EXPECT_TRUE(execCtrl.KernelStatistics().empty());
+}
+
+TEST(SolverTests, SteadyStateTimeStepsDoNotAllocate) {
+    for (MHD::ReconstructionOption const reconstruction : {MHD::ReconstructionOption::CONSTANT,
+                                                           MHD::ReconstructionOption::LINEAR,
+                                                           MHD::ReconstructionOption::MUSCL}) {
+        for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                     MHD::BoundaryConditionOption::OUTFLOW,
+                                                                     MHD::BoundaryConditionOption::PERIODIC}) {
+            MHD::Profile profile;
+            profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+            profile.m_numGhostLayersOption = 2;
+            profile.m_reconstructionOption = reconstruction;
+            profile.m_boundaryConditionOption = boundaryCondition;
+
+            MHD::ExecutionController execCtrl;
+            auto const grid = MHD::gridFactory(profile);
+            MHD::VariableStore varStore(*grid);
+            MHD::AllocationCounts const beforeSetup = MHD::threadAllocationCounts();
+            auto const solver = MHD::solverFactory(profile, execCtrl, varStore, *grid);
+            setSmoothState(*grid, varStore);
+
+            // Setup allocates inside the solver library, which shows the counters see it
+            EXPECT_GT(MHD::threadAllocationCounts().numAllocations, beforeSetup.numAllocations);
+
+            // The first steps size the statistics and regions of the controller
+            for (std::size_t step = 0; step < 2; ++step) {
+                solver->PrimFromCons();
+                solver->PerformTimeStep();
+            }
+
+            MHD::AllocationCounts const before = MHD::threadAllocationCounts();
+            for (std::size_t step = 0; step < 10; ++step) {
+                solver->PrimFromCons();
+                solver->PerformTimeStep();
+            }
+            MHD::AllocationCounts const after = MHD::threadAllocationCounts();
+            EXPECT_EQ(0, after.numAllocations - before.numAllocations)
+                << "reconstruction " << static_cast<int>(reconstruction)
+                << ", boundary condition " << static_cast<int>(boundaryCondition);
+            EXPECT_EQ(0, after.numBytes - before.numBytes);
+        }
+    }
+}
+
+TEST(SolverTests, GridPartsTileTheDomain) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    auto const whole = MHD::gridFactory(profile);
+
+    // Parts are contiguous, in order, and place their cells exactly where the whole grid does
+    std::size_t const numParts = 3;
+    std::size_t nextCell = 0;
+    for (std::size_t part = 0; part < numParts; ++part) {
+        auto const grid = MHD::gridFactory(profile, part, numParts);
+        EXPECT_EQ(whole->NumCells(), grid->NumGlobalCells());
+        EXPECT_EQ(nextCell, grid->FirstCell());
+        for (std::size_t i = 0; i < grid->NumCells(); ++i) {
+            EXPECT_EQ(whole->Nodes()[nextCell + i][0], grid->Nodes()[i][0]);
+        }
+        nextCell += grid->NumCells();
+    }
+    EXPECT_EQ(whole->NumCells(), nextCell);
+
+    EXPECT_THROW(MHD::gridFactory(profile, numParts, numParts), MHD::Error);
+    EXPECT_THROW(MHD::gridFactory(profile, 0, 0), MHD::Error);
+}
+
+TEST(SolverTests, TaskSchedulerRespectsDependencies) {
+    // A diamond per tile behind one shared root, wide enough for the threads to steal from each other
+    MHD::TaskGraph graph;
+    std::size_t const numTiles = 64;
+    std::vector<int> stage(numTiles, 0);
+    std::atomic<int> violations{0};
+    MHD::TaskGraph::TaskId const root = graph.AddTask("Root", [] {});
+    for (std::size_t t = 0; t < numTiles; ++t) {
+        auto const first = graph.AddTask("First", [&stage, &violations, t] {
+            violations += stage[t] != 0;
+            stage[t] = 1;
+        });
+        auto const last = graph.AddTask("Last", [&stage, &violations, t] {
+            violations += stage[t] != 1;
+            stage[t] = 2;
+        });
+        graph.AddDependency(root, first);
+        graph.AddDependency(first, last);
+    }
+
+    MHD::TaskScheduler scheduler(3);
+    EXPECT_EQ(3, scheduler.NumThreads());
+    for (int run = 0; run < 10; ++run) {
+        std::fill(stage.begin(), stage.end(), 0);
+        scheduler.Run(graph);
+        EXPECT_EQ(0, violations.load());
+        EXPECT_TRUE(std::all_of(stage.begin(), stage.end(), [](int const s) { return s == 2; }));
+    }
+
+    // A failing task stops the work after it, and the run still ends and reports it
+    MHD::TaskGraph failing;
+    bool ranAfter = false;
+    auto const throws = failing.AddTask("Throws", [] { throw MHD::Error::NON_PHYSICAL_STATE; });
+    auto const after = failing.AddTask("After", [&ranAfter] { ranAfter = true; });
+    failing.AddDependency(throws, after);
+    EXPECT_THROW(scheduler.Run(failing), MHD::Error);
+    EXPECT_FALSE(ranAfter);
+}
+
+TEST(SolverTests, TaskSchedulerKeepsTasksOnTheirWorker) {
+    // Tasks given a worker run on the same thread every time, and workers are distinct threads
+    std::size_t const numThreads = 3;
+    std::size_t const numTasks = 30;
+    MHD::TaskGraph graph;
+    std::vector<std::thread::id> ranOn(numTasks);
+    for (std::size_t t = 0; t < numTasks; ++t) {
+        graph.AddTask("Homed", [&ranOn, t] { ranOn[t] = std::this_thread::get_id(); }, t % numThreads);
+    }
+
+    MHD::TaskScheduler scheduler(numThreads, "homed", true);
+    scheduler.Run(graph);
+    std::vector<std::thread::id> const first = ranOn;
+    EXPECT_EQ(std::this_thread::get_id(), first[0]);
+    for (int run = 0; run < 10; ++run) {
+        scheduler.Run(graph);
+        EXPECT_EQ(first, ranOn);
+    }
+    for (std::size_t t = 0; t < numTasks; ++t) {
+        EXPECT_EQ(first[t % numThreads], first[t]);
+        EXPECT_EQ(t % numThreads == 0, first[t] == first[0]);
+    }
+    EXPECT_EQ(0, scheduler.NumSteals());
+
+    // The calling thread is only pinned while it runs tasks, and gets its own CPUs back after
+    std::vector<int> callerCpus;
+    MHD::currentThreadCpus(callerCpus);
+    std::vector<int> cpusNow;
+    {
+        MHD::TaskScheduler pinned(numThreads, "pinned", true);
+        EXPECT_EQ(numThreads, pinned.Cpus().size());
+        pinned.Run(graph);
+        MHD::currentThreadCpus(cpusNow);
+        EXPECT_EQ(callerCpus, cpusNow);
+
+        // A second scheduler alive at the same time takes the CPUs the first left free, while any remain
+        MHD::TaskScheduler other(numThreads, "other", true);
+        std::size_t const numCpus = MHD::cpusByNumaNode().size();
+        for (int const cpu : other.Cpus()) {
+            bool const shared = std::find(pinned.Cpus().begin(), pinned.Cpus().end(), cpu) != pinned.Cpus().end();
+            EXPECT_TRUE(!shared || numCpus < 2 * numThreads) << cpu;
+        }
+    }
+    MHD::currentThreadCpus(cpusNow);
+    EXPECT_EQ(callerCpus, cpusNow);
+
+    // Every CPU the process may use appears once
+    std::vector<int> cpus = MHD::cpusByNumaNode();
+    EXPECT_FALSE(cpus.empty());
+    std::sort(cpus.begin(), cpus.end());
+    EXPECT_TRUE(std::adjacent_find(cpus.begin(), cpus.end()) == cpus.end());
+}
+
+TEST(SolverTests, DiscardedPagesStillReadAsZero) {
+    std::vector<double> values(1 << 16, 0.0);
+    EXPECT_TRUE(MHD::discardZeroPages(values.data(), values.size()));
+    EXPECT_TRUE(std::all_of(values.begin(), values.end(), [](double const value) { return value == 0.0; }));
+    values[values.size() / 2] = 1.0;
+    EXPECT_EQ(1.0, values[values.size() / 2]);
+
+    // Anything but zeros is left alone
+    EXPECT_FALSE(MHD::discardZeroPages(values.data(), values.size()));
+    EXPECT_EQ(1.0, values[values.size() / 2]);
+}
+
+TEST(SolverTests, TaskGraphStepsMatchStagedSteps) {
+    for (MHD::ReconstructionOption const reconstruction : {MHD::ReconstructionOption::CONSTANT,
+                                                           MHD::ReconstructionOption::MUSCL}) {
+        for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                     MHD::BoundaryConditionOption::PERIODIC}) {
+            MHD::Profile profile;
+            profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+            profile.m_numGhostLayersOption = 2;
+            profile.m_reconstructionOption = reconstruction;
+            profile.m_boundaryConditionOption = boundaryCondition;
+
+            // Periodic cases pin their threads, which then run a fixed run of tiles each from pages they placed
+            MHD::Profile tiledProfile = profile;
+            tiledProfile.m_numThreadsOption = 3;
+            tiledProfile.m_tileCellsOption = 7;
+            tiledProfile.m_pinThreadsOption = boundaryCondition == MHD::BoundaryConditionOption::PERIODIC
+                ? MHD::PinThreadsOption::YES : MHD::PinThreadsOption::NO;
+
+            MHD::ExecutionController execCtrl;
+            auto const grid = MHD::gridFactory(profile);
+            MHD::VariableStore staged(*grid);
+            MHD::VariableStore tiled(*grid);
+            auto const stagedSolver = MHD::solverFactory(profile, execCtrl, staged, *grid);
+            auto const tiledSolver = MHD::solverFactory(tiledProfile, execCtrl, tiled, *grid);
+            setSmoothState(*grid, staged);
+            setSmoothState(*grid, tiled);
+
+            for (std::size_t step = 0; step < 20; ++step) {
+                stagedSolver->PrimFromCons();
+                stagedSolver->PerformTimeStep();
+                tiledSolver->PrimFromCons();
+                tiledSolver->PerformTimeStep();
+            }
+
+            // Every face and cell is computed by the same kernel from the same inputs, only the order differs
+            EXPECT_EQ(staged.rho, tiled.rho);
+            EXPECT_EQ(staged.rhoU, tiled.rhoU);
+            EXPECT_EQ(staged.rhoE, tiled.rhoE);
+            EXPECT_EQ(staged.by, tiled.by);
+
+            // Once warm, a task graph step allocates no more than a staged one
+            MHD::AllocationCounts const before = MHD::threadAllocationCounts();
+            for (std::size_t step = 0; step < 5; ++step) {
+                tiledSolver->PrimFromCons();
+                tiledSolver->PerformTimeStep();
+            }
+            EXPECT_EQ(0, MHD::threadAllocationCounts().numAllocations - before.numAllocations);
+        }
+    }
+}
+
+TEST(SolverTests, TileBoundsOnStencilCrossingsMatchStagedSteps) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.1, 0.1, 0.1};
+    profile.m_numGhostLayersOption = 2;
+    profile.m_reconstructionOption = MHD::ReconstructionOption::MUSCL;
+
+    MHD::ExecutionController execCtrl;
+    auto const grid = MHD::gridFactory(profile);
+    MHD::VariableStore staged(*grid);
+    auto const stagedSolver = MHD::solverFactory(profile, execCtrl, staged, *grid);
+    setSmoothState(*grid, staged);
+    for (std::size_t step = 0; step < 20; ++step) {
+        stagedSolver->PrimFromCons();
+        stagedSolver->PerformTimeStep();
+    }
+
+    // Faces at the bound between two tiles reach two cells into each, which the next tile overwrites,
+    // whether the tiles run in turn on one thread or as a graph on several
+    for (std::size_t const numThreads : {1, 3}) {
+        for (std::size_t const tileCells : {40, 50, 67, 100}) {
+            MHD::Profile tiledProfile = profile;
+            tiledProfile.m_stepScheduleOption = MHD::StepScheduleOption::TILED;
+            tiledProfile.m_numThreadsOption = numThreads;
+            tiledProfile.m_tileCellsOption = tileCells;
+            MHD::VariableStore tiled(*grid);
+            auto const tiledSolver = MHD::solverFactory(tiledProfile, execCtrl, tiled, *grid);
+            setSmoothState(*grid, tiled);
+            for (std::size_t step = 0; step < 20; ++step) {
+                tiledSolver->PrimFromCons();
+                tiledSolver->PerformTimeStep();
+            }
+            EXPECT_EQ(staged.rho, tiled.rho) << numThreads << " threads, tiles of " << tileCells;
+            EXPECT_EQ(staged.rhoU, tiled.rhoU) << numThreads << " threads, tiles of " << tileCells;
+            EXPECT_EQ(staged.rhoE, tiled.rhoE) << numThreads << " threads, tiles of " << tileCells;
+            EXPECT_EQ(staged.by, tiled.by) << numThreads << " threads, tiles of " << tileCells;
+        }
+    }
+
+    // Pinned threads left to choose split the cells evenly between them, 67 each on three threads
+    MHD::Profile pinnedProfile = profile;
+    pinnedProfile.m_numThreadsOption = 3;
+    pinnedProfile.m_tileCellsOption = 0;
+    pinnedProfile.m_pinThreadsOption = MHD::PinThreadsOption::YES;
+    MHD::VariableStore pinned(*grid);
+    MHD::Solver pinnedSolver(pinnedProfile, execCtrl, pinned, *grid);
+    EXPECT_EQ(67, pinnedSolver.TileCells());
+    setSmoothState(*grid, pinned);
+    for (std::size_t step = 0; step < 20; ++step) {
+        pinnedSolver.PrimFromCons();
+        pinnedSolver.PerformTimeStep();
+    }
+    EXPECT_EQ(staged.rho, pinned.rho);
+    EXPECT_EQ(staged.rhoE, pinned.rhoE);
+}
+
+TEST(SolverTests, TiledStepsTuneTheirTileSize) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.01, 0.1, 0.1};
+    profile.m_numGhostLayersOption = 2;
+
+    MHD::Profile tiledProfile = profile;
+    tiledProfile.m_stepScheduleOption = MHD::StepScheduleOption::TILED;
+    tiledProfile.m_tileCellsOption = 0;
+
+    MHD::ExecutionController execCtrl;
+    auto const grid = MHD::gridFactory(profile);
+    MHD::VariableStore staged(*grid);
+    MHD::VariableStore tiled(*grid);
+    MHD::Solver stagedSolver(profile, execCtrl, staged, *grid);
+    MHD::Solver tiledSolver(tiledProfile, execCtrl, tiled, *grid);
+    setSmoothState(*grid, staged);
+    setSmoothState(*grid, tiled);
+    EXPECT_EQ(0, stagedSolver.TileCells());
+
+    // 2000 cells try tiles of 256, 512 and 1024 cells and the whole grid, two steps each
+    std::vector<std::size_t> sizes;
+    for (std::size_t step = 0; step < 12; ++step) {
+        sizes.push_back(tiledSolver.TileCells());
+        stagedSolver.PrimFromCons();
+        stagedSolver.PerformTimeStep();
+        tiledSolver.PrimFromCons();
+        tiledSolver.PerformTimeStep();
+    }
+    EXPECT_EQ((std::vector<std::size_t>{256, 256, 512, 512, 1024, 1024, 2000, 2000}),
+              std::vector<std::size_t>(sizes.begin(), sizes.begin() + 8));
+    std::size_t const chosen = tiledSolver.TileCells();
+    EXPECT_TRUE(chosen == 256 || chosen == 512 || chosen == 1024 || chosen == 2000) << chosen;
+    EXPECT_EQ(chosen, sizes.back());
+
+    EXPECT_EQ(staged.rho, tiled.rho);
+    EXPECT_EQ(staged.rhoU, tiled.rhoU);
+    EXPECT_EQ(staged.rhoE, tiled.rhoE);
+}
+
+TEST(SolverTests, TemporalBlocksMatchSingleSteps) {
+    // Uniform cells, and cells clustered towards a point, whose widths differ from tile to tile
+    for (bool const clustered : {false, true}) {
+        for (MHD::ReconstructionOption const reconstruction : {MHD::ReconstructionOption::CONSTANT,
+                                                               MHD::ReconstructionOption::MUSCL}) {
+            for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                         MHD::BoundaryConditionOption::OUTFLOW,
+                                                                         MHD::BoundaryConditionOption::PERIODIC}) {
+                MHD::Profile profile;
+                profile.m_gridSpacingsOption = {clustered ? 0.04 : 0.005, 0.1, 0.1};
+                if (clustered) {
+                    profile.m_gridClusterPointsOption = {10.0};
+                }
+                profile.m_numGhostLayersOption = 2;
+                profile.m_reconstructionOption = reconstruction;
+                profile.m_boundaryConditionOption = boundaryCondition;
+
+                // Tiles narrower than their margins, and a last tile shorter than the others
+                std::size_t const numSteps = 4;
+                MHD::Profile blockedProfile = profile;
+                blockedProfile.m_temporalBlockStepsOption = numSteps;
+                blockedProfile.m_tileCellsOption = 7;
+
+                MHD::ExecutionController execCtrl;
+                auto const grid = MHD::gridFactory(profile);
+                MHD::VariableStore stepped(*grid);
+                MHD::VariableStore blocked(*grid);
+                MHD::Solver steppedSolver(profile, execCtrl, stepped, *grid);
+                MHD::Solver blockedSolver(blockedProfile, execCtrl, blocked, *grid);
+                setSmoothState(*grid, stepped);
+                setSmoothState(*grid, blocked);
+
+                // A power of two splits exactly into the steps of a block, which the limit then sets
+                double const timeStep = 1.0 / (1 << 20);
+                blockedSolver.LimitTimeStep(numSteps * timeStep);
+                for (std::size_t block = 0; block < 5; ++block) {
+                    blockedSolver.PrimFromCons();
+                    blockedSolver.PerformTimeStep();
+                    EXPECT_EQ(numSteps * timeStep, blockedSolver.TimeStep());
+                    for (std::size_t step = 0; step < numSteps; ++step) {
+                        steppedSolver.PrimFromCons();
+                        steppedSolver.PerformTimeStep(timeStep);
+                    }
+                }
+
+                // Every tile cell sees the inputs a step of the whole grid would give it
+                std::size_t const numCells = grid->NumCells();
+                auto interior = [numCells](std::vector<double> const& field) {
+                    return std::vector<double>(field.begin(), field.begin() + numCells);
+                };
+                EXPECT_EQ(interior(stepped.rho), interior(blocked.rho))
+                    << "reconstruction " << static_cast<int>(reconstruction)
+                    << ", boundary condition " << static_cast<int>(boundaryCondition) << ", clustered " << clustered;
+                EXPECT_EQ(interior(stepped.rhoU), interior(blocked.rhoU));
+                EXPECT_EQ(interior(stepped.rhoE), interior(blocked.rhoE));
+                EXPECT_EQ(interior(stepped.by), interior(blocked.by));
+
+                // Unlimited, a block takes a fraction of the CFL step for each of its steps
+                blockedSolver.LimitTimeStep(std::numeric_limits<double>::infinity());
+                blockedSolver.PrimFromCons();
+                blockedSolver.PerformTimeStep();
+                steppedSolver.PrimFromCons();
+                steppedSolver.CalculateTimeStep();
+                EXPECT_LT(blockedSolver.TimeStep(), numSteps * steppedSolver.TimeStep());
+                EXPECT_GT(blockedSolver.TimeStep(), 0.5 * numSteps * steppedSolver.TimeStep());
+
+                // Once set up, blocks allocate nothing
+                MHD::AllocationCounts const before = MHD::threadAllocationCounts();
+                for (std::size_t block = 0; block < 3; ++block) {
+                    blockedSolver.PrimFromCons();
+                    blockedSolver.PerformTimeStep();
+                }
+                EXPECT_EQ(0, MHD::threadAllocationCounts().numAllocations - before.numAllocations);
+            }
+        }
+    }
+}
+
+TEST(SolverTests, TemporalBlocksStayWithinTheLimitAsWavesSpeedUp) {
+    MHD::Profile profile;
+    profile.m_gridSpacingsOption = {0.05, 0.1, 0.1};
+    profile.m_numGhostLayersOption = 2;
+    profile.m_boundaryConditionOption = MHD::BoundaryConditionOption::OUTFLOW;
+
+    std::size_t const numSteps = 8;
+    MHD::Profile blockedProfile = profile;
+    blockedProfile.m_temporalBlockStepsOption = numSteps;
+
+    // A pressure jump at rest, whose shock soon moves faster than any wave at the start
+    MHD::ExecutionController execCtrl;
+    auto const grid = MHD::gridFactory(profile);
+    MHD::VariableStore stepped(*grid);
+    MHD::VariableStore blocked(*grid);
+    MHD::Solver steppedSolver(profile, execCtrl, stepped, *grid);
+    MHD::Solver blockedSolver(blockedProfile, execCtrl, blocked, *grid);
+    for (MHD::VariableStore* varStore : {&stepped, &blocked}) {
+        for (std::size_t i = 0; i < grid->NumCells(); ++i) {
+            bool const left = grid->Nodes()[i][0] < 10.0;
+            varStore->rho[i] = left ? 1.0 : 0.125;
+            varStore->rhoE[i] = (left ? 1e5 : 1e4) / 0.4;
+        }
+    }
+    steppedSolver.PrimFromCons();
+    double const initialTimeStep = steppedSolver.StableTimeStep();
+
+    // Replayed one step at a time, every step of every block is within the limit of the state it starts from
+    for (std::size_t block = 0; block < 3; ++block) {
+        blockedSolver.PrimFromCons();
+        blockedSolver.PerformTimeStep();
+        double const timeStep = blockedSolver.TimeStep() / numSteps;
+        for (std::size_t step = 0; step < numSteps; ++step) {
+            steppedSolver.PrimFromCons();
+            EXPECT_LE(timeStep, steppedSolver.StableTimeStep()) << "block " << block << ", step " << step;
+            steppedSolver.PerformTimeStep(timeStep);
+        }
+        if (block == 0) {
+            EXPECT_LT(blockedSolver.TimeStep(), 0.8 * numSteps * initialTimeStep);
+        }
+    }
+    std::size_t const numCells = grid->NumCells();
+    EXPECT_TRUE(std::equal(stepped.rho.begin(), stepped.rho.begin() + numCells, blocked.rho.begin()));
+    EXPECT_TRUE(std::equal(stepped.rhoE.begin(), stepped.rhoE.begin() + numCells, blocked.rhoE.begin()));
+}
+
+TEST(SolverTests, ActiveTilesMatchFullSteps) {
+    for (MHD::ReconstructionOption const reconstruction : {MHD::ReconstructionOption::CONSTANT,
+                                                           MHD::ReconstructionOption::MUSCL}) {
+        for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                     MHD::BoundaryConditionOption::PERIODIC}) {
+            MHD::Profile profile;
+            profile.m_gridSpacingsOption = {0.01, 0.1, 0.1};
+            profile.m_numGhostLayersOption = 2;
+            profile.m_reconstructionOption = reconstruction;
+            profile.m_boundaryConditionOption = boundaryCondition;
+
+            // Tiles narrower than a stencil is wide, so activity must spread through several at once
+            MHD::Profile activeProfile = profile;
+            activeProfile.m_activityTrackingOption = MHD::ActivityTrackingOption::YES;
+            activeProfile.m_tileCellsOption = 3;
+
+            MHD::ExecutionController execCtrl;
+            auto const grid = MHD::gridFactory(profile);
+            std::size_t const numCells = grid->NumCells();
+            MHD::VariableStore full(*grid);
+            MHD::VariableStore active(*grid);
+            MHD::Solver fullSolver(profile, execCtrl, full, *grid);
+            MHD::Solver activeSolver(activeProfile, execCtrl, active, *grid);
+            setPulseState(*grid, full);
+            setPulseState(*grid, active);
+            EXPECT_EQ(numCells, activeSolver.NumActiveCells());
+
+            auto interior = [numCells](std::vector<double> const& field) {
+                return std::vector<double>(field.begin(), field.begin() + numCells);
+            };
+            auto step = [&](std::size_t const numSteps) {
+                for (std::size_t n = 0; n < numSteps; ++n) {
+                    fullSolver.PrimFromCons();
+                    fullSolver.PerformTimeStep();
+                    activeSolver.PrimFromCons();
+                    activeSolver.PerformTimeStep();
+                }
+                fullSolver.PrimFromCons();
+                activeSolver.PrimFromCons();
+                EXPECT_EQ(fullSolver.TimeStep(), activeSolver.TimeStep());
+                EXPECT_EQ(interior(full.rho), interior(active.rho))
+                    << "reconstruction " << static_cast<int>(reconstruction)
+                    << ", boundary condition " << static_cast<int>(boundaryCondition);
+                EXPECT_EQ(interior(full.rhoU), interior(active.rhoU));
+                EXPECT_EQ(interior(full.rhoE), interior(active.rhoE));
+                EXPECT_EQ(interior(full.by), interior(active.by));
+                EXPECT_EQ(interior(full.p), interior(active.p));
+            };
+
+            // The pulse and the boundaries keep a small part of the grid active, which grows as it spreads
+            step(1);
+            std::size_t const early = activeSolver.NumActiveCells();
+            EXPECT_LT(early, numCells / 10);
+            step(20);
+            EXPECT_GT(activeSolver.NumActiveCells(), early);
+
+            // Steps over the active tiles allocate nothing
+            MHD::AllocationCounts const before = MHD::threadAllocationCounts();
+            for (std::size_t n = 0; n < 5; ++n) {
+                activeSolver.PrimFromCons();
+                activeSolver.PerformTimeStep();
+            }
+            EXPECT_EQ(0, MHD::threadAllocationCounts().numAllocations - before.numAllocations);
+            for (std::size_t n = 0; n < 5; ++n) {
+                fullSolver.PrimFromCons();
+                fullSolver.PerformTimeStep();
+            }
+            step(0);
+
+            // A state replaced from outside is stepped everywhere again
+            setSmoothState(*grid, full);
+            setSmoothState(*grid, active);
+            activeSolver.StateReplaced();
+            EXPECT_EQ(numCells, activeSolver.NumActiveCells());
+            step(5);
+        }
+    }
+
+    // Activity tracking runs staged steps on one thread
+    MHD::Profile profile;
+    profile.m_activityTrackingOption = MHD::ActivityTrackingOption::YES;
+    profile.m_stepScheduleOption = MHD::StepScheduleOption::TILED;
+    MHD::ExecutionController execCtrl;
+    auto const grid = MHD::gridFactory(profile);
+    MHD::VariableStore varStore(*grid);
+    EXPECT_THROW(MHD::Solver(profile, execCtrl, varStore, *grid), MHD::Error);
+}
+
+TEST(SolverTests, RefinedPatchesConserveAndFollowJumps) {
+    for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                 MHD::BoundaryConditionOption::PERIODIC}) {
+        MHD::Profile profile;
+        profile.m_gridSpacingsOption = {0.05, 0.1, 0.1};
+        profile.m_numGhostLayersOption = 2;
+        profile.m_boundaryConditionOption = boundaryCondition;
+        profile.m_refinementLevelsOption = 2;
+
+        MHD::ExecutionController execCtrl;
+        auto const grid = MHD::gridFactory(profile);
+        std::size_t const numCells = grid->NumCells();
+        MHD::VariableStore varStore(*grid);
+        MHD::Solver solver(profile, execCtrl, varStore, *grid);
+
+        // A Brio-Wu-like jump in the middle, and a second one where a periodic domain wraps around
+        for (std::size_t i = 0; i < numCells; ++i) {
+            bool const left = i < numCells / 2;
+            varStore.rho[i] = left ? 1.0 : 0.125;
+            varStore.bx[i] = 0.75;
+            varStore.by[i] = left ? 1.0 : -1.0;
+            varStore.rhoE[i] = left ? 2.5e5 : 2.5e4;
+        }
+        solver.StateReplaced();
+
+        auto total = [numCells](std::vector<double> const& field) {
+            double sum = 0.0;
+            for (std::size_t i = 0; i < numCells; ++i) {
+                sum += field[i];
+            }
+            return sum;
+        };
+        double const mass = total(varStore.rho);
+        double const energy = total(varStore.rhoE);
+        for (std::size_t step = 0; step < 100; ++step) {
+            solver.PrimFromCons();
+            solver.PerformTimeStep();
+        }
+
+        // The spread-out waves are refined, yet a step costs well under the 16 updates per cell of a
+        // uniform grid at the finest spacing
+        EXPECT_GT(solver.NumCellUpdates(), 2 * numCells);
+        EXPECT_LT(solver.NumCellUpdates(), 8 * numCells);
+
+        // Fine fluxes replace the coarse ones through every patch edge, so nothing is gained or lost there
+        EXPECT_NEAR(mass, total(varStore.rho), 1e-13 * mass);
+        EXPECT_NEAR(energy, total(varStore.rhoE), 1e-13 * energy);
+    }
+
+    // Patches need the whole grid stepped at once, by one thread
+    MHD::Profile profile;
+    profile.m_refinementLevelsOption = 1;
+    profile.m_activityTrackingOption = MHD::ActivityTrackingOption::YES;
+    MHD::ExecutionController execCtrl;
+    auto const grid = MHD::gridFactory(profile);
+    MHD::VariableStore varStore(*grid);
+    EXPECT_THROW(MHD::Solver(profile, execCtrl, varStore, *grid), MHD::Error);
+}
+
+TEST(SolverTests, StretchedGridsConserveAndSplitIntoParts) {
+    // Cells widening fourfold from the lower bound, listed face by face
+    std::vector<double> nodes;
+    for (std::size_t k = 0; k <= 40; ++k) {
+        double const fraction = k / 40.0;
+        nodes.push_back(20.0 * (0.25 * fraction + 0.75 * fraction * fraction));
+    }
+
+    for (MHD::BoundaryConditionOption const boundaryCondition : {MHD::BoundaryConditionOption::REFLECTIVE,
+                                                                 MHD::BoundaryConditionOption::PERIODIC}) {
+        MHD::Profile profile;
+        profile.m_gridNodesOption = nodes;
+        profile.m_numGhostLayersOption = 2;
+        profile.m_boundaryConditionOption = boundaryCondition;
+
+        MHD::ExecutionController execCtrl;
+        auto const grid = MHD::gridFactory(profile);
+        std::size_t const numCells = grid->NumCells();
+        ASSERT_EQ(40, numCells);
+        EXPECT_FALSE(grid->IsUniform());
+        EXPECT_DOUBLE_EQ(nodes[1] - nodes[0], grid->CellSize()[0]);
+
+        // A part holds the same cells as the whole grid, and its ghost cells are the cells of its neighbour
+        auto const upperPart = MHD::gridFactory(profile, 1, 2);
+        for (std::size_t i = 0; i < upperPart->NumCells(); ++i) {
+            EXPECT_DOUBLE_EQ(grid->Nodes()[20 + i][0], upperPart->Nodes()[i][0]);
+            EXPECT_DOUBLE_EQ(grid->CellWidths()[20 + i], upperPart->CellWidths()[i]);
+        }
+        for (std::size_t k = 0; k < 2; ++k) {
+            EXPECT_DOUBLE_EQ(grid->Nodes()[19 - k][0], upperPart->Nodes()[20 + k][0]);
+            EXPECT_DOUBLE_EQ(grid->CellWidths()[19 - k], upperPart->CellWidths()[20 + k]);
+        }
+
+        // A sound pulse that reaches the narrow cells, and the wall beside them, within the steps
+        MHD::VariableStore varStore(*grid);
+        MHD::Solver solver(profile, execCtrl, varStore, *grid);
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const x = grid->Nodes()[i][0];
+            double const bump = std::exp(-(x - 5.0) * (x - 5.0));
+            varStore.rho[i] = 1.0 + 0.5 * bump;
+            varStore.rhoE[i] = 2.5e5 * (1.0 + 0.5 * bump);
+        }
+        solver.StateReplaced();
+
+        auto total = [&grid, numCells](std::vector<double> const& field) {
+            double sum = 0.0;
+            for (std::size_t i = 0; i < numCells; ++i) {
+                sum += field[i] * grid->CellWidths()[i];
+            }
+            return sum;
+        };
+        double const mass = total(varStore.rho);
+        double const energy = total(varStore.rhoE);
+
+        // The narrowest cells set the step, at the CFL number over the time their fastest wave takes to cross
+        solver.PrimFromCons();
+        solver.CalculateTimeStep();
+        double shortestCrossing = std::numeric_limits<double>::max();
+        for (std::size_t i = 0; i < numCells; ++i) {
+            double const waveSpeed = std::abs(varStore.u[i]) + varStore.cs[i];
+            shortestCrossing = std::min(shortestCrossing, grid->CellWidths()[i] / waveSpeed);
+        }
+        EXPECT_DOUBLE_EQ(0.4 * shortestCrossing, solver.TimeStep());
+
+        for (std::size_t step = 0; step < 100; ++step) {
+            solver.PrimFromCons();
+            solver.PerformTimeStep();
+        }
+        EXPECT_NEAR(mass, total(varStore.rho), 1e-13 * mass);
+        EXPECT_NEAR(energy, total(varStore.rhoE), 1e-13 * energy);
+        EXPECT_GT(varStore.rho[0], 1.01);
+    }
+
+    // Clustered cells narrow towards the ratio at a point, and a grid takes its faces from one source
     MHD::Profile profile;
-    MHD::Cartesian1DGrid grid(profile);
-    MHD::Solver solver(profile);
-    solver.SolveTimeStep(grid);
+    profile.m_gridSpacingsOption = {0.2, 0.1, 0.1};
+    profile.m_gridClusterPointsOption = {10.0};
+    profile.m_gridClusterRatioOption = 4.0;
+    auto const clustered = MHD::gridFactory(profile);
+    EXPECT_NEAR(0.05, clustered->CellSize()[0], 1e-3);
+    EXPECT_NEAR(0.2, clustered->CellWidths()[0], 1e-3);
+    EXPECT_NEAR(20.0, clustered->Nodes()[clustered->NumCells() - 1][0] + 0.5 * clustered->CellWidths()[clustered->NumCells() - 1], 1e-12);
+    profile.m_gridNodesOption = nodes;
+    EXPECT_THROW(MHD::gridFactory(profile), MHD::Error);
+    profile.m_gridClusterPointsOption.clear();
+    std::swap(profile.m_gridNodesOption[3], profile.m_gridNodesOption[4]);
+    EXPECT_THROW(MHD::gridFactory(profile), MHD::Error);
 }